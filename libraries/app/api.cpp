@@ -594,57 +594,59 @@ vector<account_asset_balance> asset_api::get_asset_holders(std::string asset, ui
 
    uint32_t index = 0;
    for (const account_balance_object &bal : boost::make_iterator_range(range.first, range.second)) {
-      if (result.size() >= limit)
+      // balances are ordered by amount descending, so only zero balances follow
+      if (result.size() >= limit || bal.balance.value == 0)
          break;
 
-      if (bal.balance.value == 0)
-         continue;
-
       if (index++ < start)
          continue;
 
-      const auto account = _db.find(bal.owner);
+      result.push_back(make_account_asset_balance(bal));
+   }
 
-      account_asset_balance aab;
-      aab.name = account->name;
-      aab.account_id = account->id;
-      aab.amount = bal.balance.value;
+   return result;
+}
 
-      result.push_back(aab);
-   }
+vector<account_asset_balance> asset_api::get_asset_holders_after(std::string asset, share_type last_amount, account_id_type last_account, uint32_t limit) const {
+   FC_ASSERT(limit <= api_limit_get_asset_holders,
+             "Number of querying asset holder accounts can not be greater than ${configured_limit}",
+             ("configured_limit", api_limit_get_asset_holders));
+
+   asset_id_type asset_id = database_api.get_asset_id_from_string(asset);
+   const auto &bal_idx = _db.get_index_type<account_balance_index>().indices().get<by_asset_balance>();
+   auto itr = bal_idx.upper_bound(boost::make_tuple(asset_id, last_amount, last_account));
+
+   vector<account_asset_balance> result;
+   for (; itr != bal_idx.end() && itr->asset_type == asset_id && itr->balance.value != 0 && result.size() < limit; ++itr)
+      result.push_back(make_account_asset_balance(*itr));
 
    return result;
 }
+
+account_asset_balance asset_api::make_account_asset_balance(const account_balance_object &bal) const {
+   const auto &account = bal.owner(_db);
+
+   account_asset_balance aab;
+   aab.name = account.name;
+   aab.account_id = account.id;
+   aab.amount = bal.balance.value;
+   return aab;
+}
+
 // get number of asset holders.
 int asset_api::get_asset_holders_count(std::string asset) const {
-
-   const auto &bal_idx = _db.get_index_type<account_balance_index>().indices().get<by_asset_balance>();
    asset_id_type asset_id = database_api.get_asset_id_from_string(asset);
-   auto range = bal_idx.equal_range(boost::make_tuple(asset_id));
-   int count = boost::distance(range) - 1;
-
-   return count;
+   return get_holders_count_index().get_holders_count(asset_id);
 }
 // function to get vector of system assets with holders count.
 vector<asset_holders> asset_api::get_all_asset_holders() const {
+   const auto &count_idx = get_holders_count_index();
 
    vector<asset_holders> result;
-
-   vector<asset_id_type> total_assets;
    for (const asset_object &asset_obj : _db.get_index_type<asset_index>().indices()) {
-      const auto &dasset_obj = asset_obj.dynamic_asset_data_id(_db);
-
-      asset_id_type asset_id;
-      asset_id = dasset_obj.id;
-
-      const auto &bal_idx = _db.get_index_type<account_balance_index>().indices().get<by_asset_balance>();
-      auto range = bal_idx.equal_range(boost::make_tuple(asset_id));
-
-      int count = boost::distance(range) - 1;
-
       asset_holders ah;
-      ah.asset_id = asset_id;
-      ah.count = count;
+      ah.asset_id = asset_obj.id;
+      ah.count = count_idx.get_holders_count(asset_obj.id);
 
       result.push_back(ah);
    }
@@ -652,4 +654,8 @@ vector<asset_holders> asset_api::get_all_asset_holders() const {
    return result;
 }
 
+const asset_holders_count_index &asset_api::get_holders_count_index() const {
+   return _db.get_index_type<primary_index<account_balance_index>>().get_secondary_index<asset_holders_count_index>();
+}
+
 }} // namespace graphene::app
@@ -324,6 +324,35 @@ public:
             _chain_db->enable_standby_votes_tracking(_options->at("enable-standby-votes-tracking").as<bool>());
          }
 
+         if (_options->count("object-database-max-deltas") || _options->count("object-database-flush-threads")) {
+            uint32_t max_deltas = _options->count("object-database-max-deltas") ? _options->at("object-database-max-deltas").as<uint32_t>() : 0;
+            uint32_t flush_threads = _options->count("object-database-flush-threads") ? _options->at("object-database-flush-threads").as<uint32_t>() : 0;
+            _chain_db->set_snapshot_options(max_deltas, flush_threads);
+         }
+         if (_options->count("replay-threads") || _options->count("replay-queue-depth")) {
+            uint32_t replay_threads = _options->count("replay-threads") ? _options->at("replay-threads").as<uint32_t>() : 0;
+            uint32_t queue_depth = _options->count("replay-queue-depth") ? _options->at("replay-queue-depth").as<uint32_t>() : 1000;
+            _chain_db->set_replay_pipeline(replay_threads, queue_depth);
+         }
+         if (_options->count("signature-threads")) {
+            _chain_db->set_signature_threads(_options->at("signature-threads").as<uint32_t>());
+         }
+         if (_options->count("vote-tally-threads") || _options->count("vote-tally-cross-check")) {
+            uint32_t tally_threads = _options->count("vote-tally-threads") ? _options->at("vote-tally-threads").as<uint32_t>() : 0;
+            bool cross_check = _options->count("vote-tally-cross-check") && _options->at("vote-tally-cross-check").as<bool>();
+            _chain_db->set_vote_tally_threads(tally_threads, cross_check);
+         }
+         if (_options->count("block-log-compression")) {
+            std::string codec = _options->at("block-log-compression").as<string>();
+            if (codec == "zstd")
+               _chain_db->set_block_compression(chain::block_codec::zstd);
+            else
+               FC_ASSERT(codec == "none", "Unknown block-log-compression ${c}, expected none or zstd", ("c", codec));
+         }
+         if (_options->count("object-database-load-threads")) {
+            _chain_db->set_load_threads(_options->at("object-database-load-threads").as<uint32_t>());
+         }
+
          std::string replay_reason = "reason not provided";
 
          if (_options->count("replay-blockchain"))
@@ -859,6 +888,25 @@ void application::set_program_options(boost::program_options::options_descriptio
    cfg.add_options()("enable-standby-votes-tracking", bpo::value<bool>()->implicit_value(true),
                      "Whether to enable tracking of votes of standby witnesses and committee members. "
                      "Set it to true to provide accurate data to API clients, set to false for slightly better performance.");
+   cfg.add_options()("object-database-max-deltas", bpo::value<uint32_t>()->default_value(10),
+                     "Number of incremental object database snapshots, containing only the indexes modified since "
+                     "the previous one, to write before the next snapshot rewrites the complete state (0 = always full)");
+   cfg.add_options()("object-database-flush-threads", bpo::value<uint32_t>()->default_value(4),
+                     "Number of threads used to serialize object database indexes when writing a snapshot (0 = main thread only)");
+   cfg.add_options()("object-database-load-threads", bpo::value<uint32_t>()->default_value(4),
+                     "Number of threads used to decode object database indexes on startup (0 = main thread only)");
+   cfg.add_options()("replay-threads", bpo::value<uint32_t>()->default_value(4),
+                     "Number of threads reading, unpacking and checking blocks ahead of applying them during a replay (0 = inline)");
+   cfg.add_options()("replay-queue-depth", bpo::value<uint32_t>()->default_value(1000),
+                     "Number of blocks prepared ahead of the block being applied during a replay");
+   cfg.add_options()("signature-threads", bpo::value<uint32_t>()->default_value(4),
+                     "Number of threads recovering transaction signing keys ahead of authority checks (0 = inline)");
+   cfg.add_options()("vote-tally-threads", bpo::value<uint32_t>()->default_value(4),
+                     "Number of threads tallying votes during chain maintenance (0 = inline)");
+   cfg.add_options()("vote-tally-cross-check", bpo::value<bool>()->default_value(false),
+                     "Also tally votes serially during chain maintenance and log any difference to the parallel tally");
+   cfg.add_options()("block-log-compression", bpo::value<string>()->default_value("none"),
+                     "Codec for newly stored blocks in the block log: none or zstd. Existing blocks keep their codec.");
    cfg.add_options()("plugins", bpo::value<string>()->default_value("account_history accounts_list affiliate_stats bookie market_history witness"),
                      "Space-separated list of plugins to activate");
 
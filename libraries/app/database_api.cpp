@@ -46,6 +46,8 @@
 
 #include <cfenv>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
 
 #define GET_REQUIRED_FEES_MAX_RECURSION 4
 
@@ -71,6 +73,57 @@ std::string object_id_to_string(object_id_type id) {
    return object_id;
 }
 
+/**
+ * Serializes every object of a change notification at most once, however many API sessions forward it.
+ *
+ * One cache is shared by all database_api_impl instances attached to the same database. It connects to the
+ * object signals at the front so it is reset before any session of the same emission reads from it. Sessions
+ * then copy the cached variants, which only bumps the reference count of the shared object payload.
+ */
+class object_change_cache {
+public:
+   explicit object_change_cache(graphene::chain::database &db) {
+      auto reset = [this](const vector<object_id_type> &, const flat_set<account_id_type> &) {
+         _variants.clear();
+      };
+      _new_connection = db.new_objects.connect(reset, boost::signals2::at_front);
+      _change_connection = db.changed_objects.connect(reset, boost::signals2::at_front);
+   }
+
+   /// returns the cache shared by all sessions of @p db, creating it when the first session is opened
+   static std::shared_ptr<object_change_cache> get(graphene::chain::database &db) {
+      static std::mutex registry_mutex;
+      static std::map<const graphene::chain::database *, std::weak_ptr<object_change_cache>> registry;
+
+      std::lock_guard<std::mutex> lock(registry_mutex);
+      for (auto itr = registry.begin(); itr != registry.end();) {
+         if (itr->second.expired())
+            itr = registry.erase(itr);
+         else
+            ++itr;
+      }
+      auto &entry = registry[&db];
+      auto cache = entry.lock();
+      if (!cache) {
+         cache = std::make_shared<object_change_cache>(db);
+         entry = cache;
+      }
+      return cache;
+   }
+
+   const fc::variant &to_variant(const object &obj) {
+      auto itr = _variants.find(obj.id);
+      if (itr == _variants.end())
+         itr = _variants.emplace(obj.id, obj.to_variant()).first;
+      return itr->second;
+   }
+
+private:
+   std::unordered_map<object_id_type, fc::variant> _variants;
+   boost::signals2::scoped_connection _new_connection;
+   boost::signals2::scoped_connection _change_connection;
+};
+
 class database_api_impl : public std::enable_shared_from_this<database_api_impl> {
 public:
    database_api_impl(graphene::chain::database &db);
@@ -159,7 +212,9 @@ public:
    vector<call_order_object> get_margin_positions(const std::string account_id_or_name) const;
    void subscribe_to_market(std::function<void(const variant &)> callback, const std::string &a, const std::string &b);
    void unsubscribe_from_market(const std::string &a, const std::string &b);
-   market_ticker get_ticker(const string &base, const string &quote) const;
+   market_ticker get_ticker(const string &base, const string &quote, bool skip_order_book = false) const;
+   vector<market_ticker> get_tickers(const vector<std::pair<string, string>> &markets) const;
+   void get_ticker_from_trade_history(market_ticker &result) const;
    market_volume get_24_volume(const string &base, const string &quote) const;
    order_book get_order_book(const string &base, const string &quote, unsigned limit = 50) const;
    vector<market_trade> get_trade_history(const string &base, const string &quote, fc::time_point_sec start, fc::time_point_sec stop, unsigned limit = 100) const;
@@ -289,6 +344,7 @@ public:
    uint32_t api_limit_get_limit_orders = 300;
    uint32_t api_limit_get_limit_orders_by_account = 101;
    uint32_t api_limit_get_order_book = 50;
+   uint32_t api_limit_get_tickers = 100;
    uint32_t api_limit_all_offers_count = 100;
    uint32_t api_limit_lookup_accounts = 1000;
    uint32_t api_limit_lookup_witness_accounts = 1000;
@@ -340,7 +396,7 @@ public:
 
       auto sub = _market_subscriptions.find(market);
       if (sub != _market_subscriptions.end()) {
-         queue[market].emplace_back(full_object ? obj->to_variant() : fc::variant(obj->id, 1));
+         queue[market].emplace_back(full_object ? _change_cache->to_variant(*obj) : fc::variant(obj->id, 1));
       }
    }
 
@@ -368,6 +424,7 @@ public:
    boost::signals2::scoped_connection _pending_trx_connection;
    map<pair<asset_id_type, asset_id_type>, std::function<void(const variant &)>> _market_subscriptions;
    graphene::chain::database &_db;
+   std::shared_ptr<object_change_cache> _change_cache;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -384,7 +441,8 @@ database_api::~database_api() {
 }
 
 database_api_impl::database_api_impl(graphene::chain::database &db) :
-      _db(db) {
+      _db(db),
+      _change_cache(object_change_cache::get(db)) {
    wlog("creating database api ${x}", ("x", int64_t(this)));
    _new_connection = _db.new_objects.connect([this](const vector<object_id_type> &ids, const flat_set<account_id_type> &impacted_accounts) {
       on_objects_new(ids, impacted_accounts);
@@ -1421,7 +1479,7 @@ market_ticker database_api::get_ticker(const string &base, const string &quote)
    return my->get_ticker(base, quote);
 }
 
-market_ticker database_api_impl::get_ticker(const string &base, const string &quote) const {
+market_ticker database_api_impl::get_ticker(const string &base, const string &quote, bool skip_order_book) const {
    const auto assets = lookup_asset_symbols({base, quote});
    FC_ASSERT(assets[0], "Invalid base asset symbol: ${s}", ("s", base));
    FC_ASSERT(assets[1], "Invalid quote asset symbol: ${s}", ("s", quote));
@@ -1437,51 +1495,101 @@ market_ticker database_api_impl::get_ticker(const string &base, const string &qu
    result.quote_volume = 0;
 
    try {
-      const fc::time_point_sec now = fc::time_point::now();
-      const fc::time_point_sec yesterday = fc::time_point_sec(now.sec_since_epoch() - 86400);
-      const auto batch_size = 100;
-
-      vector<market_trade> trades = get_trade_history(base, quote, now, yesterday, batch_size);
-      if (!trades.empty()) {
-         result.latest = trades[0].price;
-
-         while (!trades.empty()) {
-            for (const market_trade &t : trades) {
-               result.base_volume += t.value;
-               result.quote_volume += t.amount;
-            }
-
-            trades = get_trade_history(base, quote, trades.back().date, yesterday, batch_size);
-         }
-
-         const auto last_trade_yesterday = get_trade_history(base, quote, yesterday, fc::time_point_sec(), 1);
-         if (!last_trade_yesterday.empty()) {
-            const auto price_yesterday = last_trade_yesterday[0].price;
+      const auto base_id = assets[0]->id;
+      const auto quote_id = assets[1]->id;
+      const auto &ticker_idx = _db.get_index_type<graphene::market_history::market_ticker_index>().indices().get<graphene::market_history::by_market>();
+      auto ticker_itr = ticker_idx.find(boost::make_tuple(std::min(base_id, quote_id), std::max(base_id, quote_id)));
+
+      if (ticker_itr != ticker_idx.end()) {
+         const auto summary = ticker_itr->summarize(fc::time_point::now());
+         const bool base_is_a = ticker_itr->asset_a == base_id;
+         auto base_to_real = [&](share_type a, share_type b) {
+            return double((base_is_a ? a : b).value) / pow(10, assets[0]->precision);
+         };
+         auto quote_to_real = [&](share_type a, share_type b) {
+            return double((base_is_a ? b : a).value) / pow(10, assets[1]->precision);
+         };
+
+         result.latest = base_to_real(ticker_itr->last_a, ticker_itr->last_b) / quote_to_real(ticker_itr->last_a, ticker_itr->last_b);
+         result.base_volume = base_to_real(summary.volume_a, summary.volume_b);
+         result.quote_volume = quote_to_real(summary.volume_a, summary.volume_b);
+         // as with the trade history scan, the change is only reported for markets that traded in the last day
+         if (summary.volume_b != 0 && summary.day_open_b != 0) {
+            const auto price_yesterday = base_to_real(summary.day_open_a, summary.day_open_b) / quote_to_real(summary.day_open_a, summary.day_open_b);
             result.percent_change = ((result.latest / price_yesterday) - 1) * 100;
          }
       } else {
-         const auto last_trade = get_trade_history(base, quote, now, fc::time_point_sec(), 1);
-         if (!last_trade.empty())
-            result.latest = last_trade[0].price;
+         // no fill seen since the ticker index was introduced
+         get_ticker_from_trade_history(result);
       }
 
-      const auto orders = get_order_book(base, quote, 1);
-      if (!orders.asks.empty())
-         result.lowest_ask = orders.asks[0].price;
-      if (!orders.bids.empty())
-         result.highest_bid = orders.bids[0].price;
+      if (!skip_order_book) {
+         const auto orders = get_order_book(base, quote, 1);
+         if (!orders.asks.empty())
+            result.lowest_ask = orders.asks[0].price;
+         if (!orders.bids.empty())
+            result.highest_bid = orders.bids[0].price;
+      }
    }
    FC_CAPTURE_AND_RETHROW((base)(quote))
 
    return result;
 }
 
+void database_api_impl::get_ticker_from_trade_history(market_ticker &result) const {
+   const string &base = result.base;
+   const string &quote = result.quote;
+   const fc::time_point_sec now = fc::time_point::now();
+   const fc::time_point_sec yesterday = fc::time_point_sec(now.sec_since_epoch() - 86400);
+   const auto batch_size = 100;
+
+   vector<market_trade> trades = get_trade_history(base, quote, now, yesterday, batch_size);
+   if (!trades.empty()) {
+      result.latest = trades[0].price;
+
+      while (!trades.empty()) {
+         for (const market_trade &t : trades) {
+            result.base_volume += t.value;
+            result.quote_volume += t.amount;
+         }
+
+         trades = get_trade_history(base, quote, trades.back().date, yesterday, batch_size);
+      }
+
+      const auto last_trade_yesterday = get_trade_history(base, quote, yesterday, fc::time_point_sec(), 1);
+      if (!last_trade_yesterday.empty()) {
+         const auto price_yesterday = last_trade_yesterday[0].price;
+         result.percent_change = ((result.latest / price_yesterday) - 1) * 100;
+      }
+   } else {
+      const auto last_trade = get_trade_history(base, quote, now, fc::time_point_sec(), 1);
+      if (!last_trade.empty())
+         result.latest = last_trade[0].price;
+   }
+}
+
+vector<market_ticker> database_api::get_tickers(const vector<std::pair<string, string>> &markets) const {
+   return my->get_tickers(markets);
+}
+
+vector<market_ticker> database_api_impl::get_tickers(const vector<std::pair<string, string>> &markets) const {
+   FC_ASSERT(markets.size() <= api_limit_get_tickers,
+             "Number of querying markets can not be greater than ${configured_limit}",
+             ("configured_limit", api_limit_get_tickers));
+
+   vector<market_ticker> result;
+   result.reserve(markets.size());
+   for (const auto &market : markets)
+      result.push_back(get_ticker(market.first, market.second));
+   return result;
+}
+
 market_volume database_api::get_24_volume(const string &base, const string &quote) const {
    return my->get_24_volume(base, quote);
 }
 
 market_volume database_api_impl::get_24_volume(const string &base, const string &quote) const {
-   const auto ticker = get_ticker(base, quote);
+   const auto ticker = get_ticker(base, quote, true);
 
    market_volume result;
    result.base = ticker.base;
@@ -3381,13 +3489,14 @@ void database_api_impl::on_objects_changed(const vector<object_id_type> &ids, co
 void database_api_impl::handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type> &ids, const flat_set<account_id_type> &impacted_accounts, std::function<const object *(object_id_type id)> find_object) {
    if (_subscribe_callback) {
       vector<variant> updates;
+      const bool notify_all = force_notify || is_impacted_account(impacted_accounts);
 
       for (auto id : ids) {
-         if (force_notify || is_subscribed_to_item(id) || is_impacted_account(impacted_accounts)) {
+         if (notify_all || is_subscribed_to_item(id)) {
             if (full_object) {
                auto obj = find_object(id);
                if (obj) {
-                  updates.emplace_back(obj->to_variant());
+                  updates.emplace_back(_change_cache->to_variant(*obj));
                }
             } else {
                updates.emplace_back(fc::variant(id, 1));
@@ -333,6 +333,16 @@ public:
           */
    vector<account_asset_balance> get_asset_holders(std::string asset, uint32_t start, uint32_t limit) const;
 
+   /**
+          * @brief Get asset holders for a specific asset, continuing after the last holder of a previous page
+          * @param asset The specific asset id or symbol
+          * @param last_amount The balance of the last holder returned by the previous page
+          * @param last_account The account id of the last holder returned by the previous page
+          * @param limit Maximum limit must not exceed 100
+          * @return A list of asset holders ordered by balance descending, then by account id
+          */
+   vector<account_asset_balance> get_asset_holders_after(std::string asset, share_type last_amount, account_id_type last_account, uint32_t limit) const;
+
    /**
           * @brief Get asset holders count for a specific asset
           * @param asset The specific asset id or symbol
@@ -349,6 +359,9 @@ public:
    uint32_t api_limit_get_asset_holders = 100;
 
 private:
+   account_asset_balance make_account_asset_balance(const account_balance_object &bal) const;
+   const asset_holders_count_index &get_holders_count_index() const;
+
    graphene::app::application &_app;
    graphene::chain::database &_db;
    graphene::app::database_api database_api;
@@ -486,6 +499,7 @@ FC_API(graphene::app::crypto_api,
 
 FC_API(graphene::app::asset_api,
       (get_asset_holders)
+      (get_asset_holders_after)
       (get_asset_holders_count)
       (get_all_asset_holders))
 
@@ -526,6 +526,13 @@ public:
     */
    market_ticker get_ticker(const string &base, const string &quote) const;
 
+   /**
+    * @brief Returns the tickers for several markets at once
+    * @param markets Pairs of base and quote asset names or IDs, at most 100
+    * @return The market tickers for the past 24 hours, in the order of the markets requested
+    */
+   vector<market_ticker> get_tickers(const vector<std::pair<string, string>> &markets) const;
+
    /**
     * @brief Returns the 24 hour volume for the market assetA:assetB
     * @param a String name of the first asset
@@ -1135,6 +1142,7 @@ FC_API(graphene::app::database_api,
    (subscribe_to_market)
    (unsubscribe_from_market)
    (get_ticker)
+   (get_tickers)
    (get_24_volume)
    (get_trade_history)
 
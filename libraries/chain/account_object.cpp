@@ -319,6 +319,44 @@ const account_balance_object* balances_by_account_index::get_account_balance( co
    return itr->second;
 }
 
+void asset_holders_count_index::object_inserted( const object& obj )
+{
+   const auto& abo = dynamic_cast< const account_balance_object& >( obj );
+   if( abo.balance != 0 )
+      ++holders_count[abo.asset_type];
+}
+
+void asset_holders_count_index::object_removed( const object& obj )
+{
+   const auto& abo = dynamic_cast< const account_balance_object& >( obj );
+   if( abo.balance != 0 && --holders_count[abo.asset_type] == 0 )
+      holders_count.erase( abo.asset_type );
+}
+
+void asset_holders_count_index::about_to_modify( const object& before )
+{
+   const auto& abo = dynamic_cast< const account_balance_object& >( before );
+   held_before_modify.push( abo.balance != 0 );
+}
+
+void asset_holders_count_index::object_modified( const object& after  )
+{
+   const auto& abo = dynamic_cast< const account_balance_object& >( after );
+   const bool held_before = held_before_modify.top();
+   held_before_modify.pop();
+   const bool held_after = abo.balance != 0;
+   if( held_after && !held_before )
+      ++holders_count[abo.asset_type];
+   else if( held_before && !held_after && --holders_count[abo.asset_type] == 0 )
+      holders_count.erase( abo.asset_type );
+}
+
+uint64_t asset_holders_count_index::get_holders_count( const asset_id_type& asset )const
+{
+   const auto itr = holders_count.find( asset );
+   return itr == holders_count.end() ? 0 : itr->second;
+}
+
 } } // graphene::chain
 
 GRAPHENE_EXTERNAL_SERIALIZATION( /*not extern*/, graphene::chain::account_object )
@@ -29,6 +29,9 @@
 #include <fc/io/raw.hpp>
 #include <fc/uint128.hpp>
 
+#include <algorithm>
+#include <iterator>
+
 using namespace graphene::chain;
 
 share_type asset_bitasset_data_object::max_force_settlement_volume(share_type current_supply) const
@@ -187,39 +190,48 @@ vector<account_id_type> asset_object::get_holders( database& db ) const
    return holders;
 }
 
-vector<uint64_t> asset_object::get_ticket_ids( database& db ) const
+/**
+ * Returns the id in the operation history of the purchase of a ticket, where ticket counts the tickets of the
+ * lottery the holder bought from the most recent purchase backwards. Purchases applied since the last block was
+ * added to the account history have no id yet.
+ */
+static optional<uint64_t> find_ticket_id( database& db, asset_id_type lottery, account_id_type holder, uint64_t ticket )
 {
-   auto& asset_bal_idx = db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-   vector<uint64_t> ids;
-   const auto range = asset_bal_idx.equal_range( boost::make_tuple( get_id() ) );
-
-   for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
+   const auto& purchases = db.get_index_type<lottery_ticket_purchase_index>().indices().get<by_lottery_buyer>();
+   const auto begin = purchases.lower_bound( boost::make_tuple( lottery, holder ) );
+   const auto end = purchases.upper_bound( boost::make_tuple( lottery, holder ) );
+   if( begin == end )
+      return optional<uint64_t>();
+   const uint64_t bought = std::prev( end )->buyer_tickets_after();
+   if( ticket >= bought )
+      return optional<uint64_t>();
+
+   auto purchase = purchases.upper_bound( boost::make_tuple( lottery, holder, bought - 1 - ticket ) );
+   --purchase;
+   if( purchase->block_num > db.head_block_num() )
+      return optional<uint64_t>();
+   uint32_t newer_purchases = 0;
+   for( auto itr = std::next( purchase ); itr != end; ++itr )
+      if( itr->block_num <= db.head_block_num() )
+         ++newer_purchases;
+
+   const auto& stats = holder( db ).statistics( db );
+   const account_transaction_history_object* ath = db.find( stats.most_recent_op );
+   while( ath != nullptr && ath->account == holder )
    {
-      const auto& stats = bal.owner(db).statistics(db);
-      const account_transaction_history_object* ath = static_cast<const account_transaction_history_object*>(&stats.most_recent_op(db));
-      for( uint64_t balance = bal.balance.value; balance > 0;)
+      const operation_history_object* oho = db.find( ath->operation_id );
+      if( oho != nullptr && oho->op.which() == operation::tag<ticket_purchase_operation>::value &&
+          oho->op.get<ticket_purchase_operation>().lottery == lottery )
       {
-         if(ath != nullptr)
-         {
-            const operation_history_object& oho = db.get<operation_history_object>( ath->operation_id );
-            if( oho.op.which() == operation::tag<ticket_purchase_operation>::value && get_id() == oho.op.get<ticket_purchase_operation>().lottery)
-            {
-               uint64_t tickets_count = oho.op.get<ticket_purchase_operation>().tickets_to_buy;
-               ids.insert(ids.end(), tickets_count, oho.id.instance());
-               balance -= tickets_count;
-               assert(balance >= 0);
-            }
-
-            if( ath->next == account_transaction_history_id_type() )
-            {
-               ath = nullptr;
-               break;
-            }
-            else ath = db.find(ath->next);
-         }
+         if( newer_purchases == 0 )
+            return oho->id.instance();
+         --newer_purchases;
       }
+      if( ath->next == account_transaction_history_id_type() )
+         break;
+      ath = db.find( ath->next );
    }
-   return ids;
+   return optional<uint64_t>();
 }
 
 void asset_object::distribute_benefactors_part( database& db )
@@ -241,47 +253,64 @@ void asset_object::distribute_benefactors_part( database& db )
 map< account_id_type, vector< uint16_t > > asset_object::distribute_winners_part( database& db )
 {
    transaction_evaluation_state eval( &db );
-      
-   auto holders = get_holders( db );
-   vector<uint64_t> ticket_ids = get_ticket_ids(db);
-   FC_ASSERT( dynamic_data( db ).current_supply == holders.size() );
-   map<account_id_type, vector<uint16_t> > structurized_participants;
-   for( account_id_type holder : holders )
+
+   // The tickets are numbered in the order of the balance index, each holder's tickets following those of the
+   // previous holder; first_tickets[i] is the number of the first ticket of holders[i]
+   auto& asset_bal_idx = db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
+   vector<account_id_type> holders;
+   vector<uint64_t> first_tickets;
+   uint64_t ticket_count = 0;
+   const auto range = asset_bal_idx.equal_range( boost::make_tuple( get_id() ) );
+   for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
    {
-      if( !structurized_participants.count( holder ) )
-         structurized_participants.emplace( holder, vector< uint16_t >() );
+      if( bal.balance.value <= 0 )
+         continue;
+      holders.push_back( bal.owner );
+      first_tickets.push_back( ticket_count );
+      ticket_count += bal.balance.value;
    }
+   FC_ASSERT( dynamic_data( db ).current_supply.value == int64_t( ticket_count ) );
+   map<account_id_type, vector<uint16_t> > structurized_participants;
+   for( account_id_type holder : holders )
+      structurized_participants.emplace( holder, vector< uint16_t >() );
    uint64_t jackpot = get_id()( db ).dynamic_data( db ).current_supply.value * lottery_options->ticket_price.amount.value;
-   auto winner_numbers = db.get_winner_numbers( get_id(), holders.size(), lottery_options->winning_tickets.size() );
+   auto winner_numbers = db.get_winner_numbers( get_id(), ticket_count, lottery_options->winning_tickets.size() );
    
    auto& tickets( lottery_options->winning_tickets );
    
-   if( holders.size() < tickets.size() ) {
+   if( ticket_count < tickets.size() ) {
       uint16_t percents_to_distribute = 0;
-      for( auto i = tickets.begin() + holders.size(); i != tickets.end(); ) {
+      for( auto i = tickets.begin() + ticket_count; i != tickets.end(); ) {
          percents_to_distribute += *i;
          i = tickets.erase(i);
       }
-      for( auto t = tickets.begin(); t != tickets.begin() + holders.size(); ++t )
-         *t += percents_to_distribute / holders.size();
+      for( auto t = tickets.begin(); t != tickets.begin() + ticket_count; ++t )
+         *t += percents_to_distribute / ticket_count;
    }
    auto sweeps_distribution_percentage = db.get_global_properties().parameters.sweeps_distribution_percentage();
    for( size_t c = 0; c < winner_numbers.size(); ++c ) {
       auto winner_num = winner_numbers[c];
+      size_t holder = std::upper_bound( first_tickets.begin(), first_tickets.end(), uint64_t( winner_num ) )
+                      - first_tickets.begin() - 1;
       lottery_reward_operation reward_op;
       reward_op.lottery = get_id();
       reward_op.is_benefactor_reward = false;
-      reward_op.winner = holders[winner_num];
-      if(db.head_block_time() > HARDFORK_5050_1_TIME && ticket_ids.size() > winner_num)
+      reward_op.winner = holders[holder];
+      if(db.head_block_time() > HARDFORK_5050_1_TIME)
       {
-         const static_variant<uint64_t, void_t> tkt_id = ticket_ids[winner_num];
-         reward_op.winner_ticket_id = tkt_id;
+         // a holder's tickets are numbered from the most recent purchase backwards
+         optional<uint64_t> ticket_id = find_ticket_id( db, get_id(), holders[holder], winner_num - first_tickets[holder] );
+         if( ticket_id.valid() )
+         {
+            const static_variant<uint64_t, void_t> tkt_id = *ticket_id;
+            reward_op.winner_ticket_id = tkt_id;
+         }
       }
       reward_op.win_percentage = tickets[c];
       reward_op.amount = asset( jackpot * tickets[c] * ( 1. - sweeps_distribution_percentage / (double)GRAPHENE_100_PERCENT ) / GRAPHENE_100_PERCENT , db.get_balance(id).asset_id );
       db.apply_operation(eval, reward_op);
       
-      structurized_participants[ holders[ winner_num ] ].push_back( tickets[c] );
+      structurized_participants[ holders[holder] ].push_back( tickets[c] );
    }
    return structurized_participants;
 }
@@ -345,4 +374,5 @@ GRAPHENE_EXTERNAL_SERIALIZATION( /*not extern*/, graphene::chain::asset_dividend
 GRAPHENE_EXTERNAL_SERIALIZATION( /*not extern*/, graphene::chain::total_distributed_dividend_balance_object )
 GRAPHENE_EXTERNAL_SERIALIZATION( /*not extern*/, graphene::chain::asset_object )
 GRAPHENE_EXTERNAL_SERIALIZATION( /*not extern*/, graphene::chain::lottery_balance_object )
+GRAPHENE_EXTERNAL_SERIALIZATION( /*not extern*/, graphene::chain::lottery_ticket_purchase_object )
 GRAPHENE_EXTERNAL_SERIALIZATION( /*not extern*/, graphene::chain::sweeps_vesting_balance_object )
@@ -25,53 +25,299 @@
 #include <graphene/chain/protocol/fee_schedule.hpp>
 #include <fc/io/raw.hpp>
 
+#include <cerrno>
+#include <cstring>
+
+#ifdef GRAPHENE_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace graphene { namespace chain {
 
-struct index_entry
+struct block_database::index_mapping
 {
-   uint64_t      block_pos = 0;
-   uint32_t      block_size = 0;
-   block_id_type block_id;
+   index_mapping( int fd, uint64_t cap ) : capacity( cap )
+   {
+      // mapping past the end of the file is fine as long as nobody touches those pages,
+      // readers never look beyond _index_entries
+      void* addr = mmap( nullptr, capacity * sizeof(index_entry), PROT_READ, MAP_SHARED, fd, 0 );
+      FC_ASSERT( addr != MAP_FAILED, "Unable to map block index" );
+      entries = static_cast<const index_entry*>( addr );
+   }
+   ~index_mapping()
+   {
+      munmap( const_cast<index_entry*>( entries ), capacity * sizeof(index_entry) );
+   }
+
+   const index_entry* entries = nullptr;
+   uint64_t           capacity = 0;
 };
- }}
-FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) );
 
-namespace graphene { namespace chain {
+namespace {
 
-void block_database::open( const fc::path& dbdir )
-{ try {
-   fc::create_directories(dbdir);
-   _block_num_to_pos.exceptions(std::ios_base::failbit | std::ios_base::badbit);
-   _blocks.exceptions(std::ios_base::failbit | std::ios_base::badbit);
+   const uint64_t min_index_mapping_entries = 1 << 20;
 
-   _index_filename = dbdir / "index";
-   if( !fc::exists( _index_filename ) )
+   /// blocks file of a log with only raw blocks, the layout every version can read
+   const std::string raw_blocks_filename = "blocks";
+   /// blocks file once a compressed block was stored, versions without compression find no log to open
+   const std::string compressed_blocks_filename = "blocks_v2";
+
+   void pwrite_all( int fd, const char* data, size_t size, uint64_t pos )
+   {
+      while( size > 0 )
+      {
+         ssize_t written = ::pwrite( fd, data, size, pos );
+         if( written < 0 && errno == EINTR ) continue;
+         FC_ASSERT( written > 0, "Error writing to block database: ${e}", ("e",strerror(errno)) );
+         data += written;
+         size -= written;
+         pos  += written;
+      }
+   }
+
+   bool pread_all( int fd, char* data, size_t size, uint64_t pos )
+   {
+      while( size > 0 )
+      {
+         ssize_t got = ::pread( fd, data, size, pos );
+         if( got < 0 && errno == EINTR ) continue;
+         if( got <= 0 ) return false;
+         data += got;
+         size -= got;
+         pos  += got;
+      }
+      return true;
+   }
+
+   vector<char> compress_block( const vector<char>& packed, block_codec codec )
+   {
+      switch( codec )
+      {
+#ifdef GRAPHENE_HAVE_ZSTD
+         case block_codec::zstd:
+         {
+            vector<char> result( ZSTD_compressBound( packed.size() ) );
+            const size_t size = ZSTD_compress( result.data(), result.size(), packed.data(), packed.size(), 3 );
+            FC_ASSERT( !ZSTD_isError( size ), "zstd compression failed: ${e}", ("e",ZSTD_getErrorName(size)) );
+            result.resize( size );
+            return result;
+         }
+#endif
+         case block_codec::raw:
+            return packed;
+         default:
+            FC_THROW( "Unsupported block codec ${c}", ("c",uint32_t(codec)) );
+      }
+   }
+
+   vector<char> decompress_block( vector<char>&& data, block_codec codec )
    {
-     _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
+      switch( codec )
+      {
+#ifdef GRAPHENE_HAVE_ZSTD
+         case block_codec::zstd:
+         {
+            const unsigned long long size = ZSTD_getFrameContentSize( data.data(), data.size() );
+            FC_ASSERT( size != ZSTD_CONTENTSIZE_ERROR && size != ZSTD_CONTENTSIZE_UNKNOWN, "Corrupt compressed block" );
+            vector<char> result( size );
+            const size_t got = ZSTD_decompress( result.data(), result.size(), data.data(), data.size() );
+            FC_ASSERT( !ZSTD_isError( got ) && got == size, "zstd decompression failed" );
+            return result;
+         }
+#endif
+         case block_codec::raw:
+            return std::move( data );
+         default:
+            FC_THROW( "Block stored with codec ${c} which is not supported by this build", ("c",uint32_t(codec)) );
+      }
    }
-   else
+
+   uint64_t file_size( int fd )
    {
-     _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+      struct stat st;
+      FC_ASSERT( fstat( fd, &st ) == 0, "Unable to stat block database file" );
+      return st.st_size;
    }
+
+}
+
+block_database::block_database()
+: _index_entries(0), _index_map(nullptr), _has_pending(false)
+{
+}
+
+block_database::~block_database()
+{
+   try {
+      close();
+   } FC_CAPTURE_AND_LOG( (_index_filename) )
+}
+
+void block_database::open( const fc::path& dbdir )
+{ try {
+   close();
+   fc::create_directories(dbdir);
+
+   _index_filename = dbdir / "index";
+   const int flags = O_RDWR | O_CREAT | ( fc::exists( _index_filename ) ? 0 : O_TRUNC );
+   _index_fd = ::open( _index_filename.generic_string().c_str(), flags, 0644 );
+   FC_ASSERT( _index_fd >= 0, "Unable to open ${f}: ${e}", ("f",_index_filename)("e",strerror(errno)) );
+   // a log holding compressed blocks keeps them in blocks_v2, see use_compressed_blocks_file()
+   _blocks_filename = dbdir / ( fc::exists( dbdir / compressed_blocks_filename ) ? compressed_blocks_filename : raw_blocks_filename );
+   _blocks_fd = ::open( _blocks_filename.generic_string().c_str(), flags, 0644 );
+   FC_ASSERT( _blocks_fd >= 0, "Unable to open ${f}: ${e}", ("f",_blocks_filename)("e",strerror(errno)) );
+
+   _blocks_size = file_size( _blocks_fd );
+   _index_entries = file_size( _index_fd ) / sizeof(index_entry);
+   map_index( _index_entries );
 } FC_CAPTURE_AND_RETHROW( (dbdir) ) }
 
 bool block_database::is_open()const
 {
-  return _blocks.is_open();
+  return _blocks_fd >= 0;
 }
 
 void block_database::close()
 {
-  _blocks.close();
-  _block_num_to_pos.close();
+  if( !is_open() )
+     return;
+  commit_pending();
+  {
+     std::lock_guard<std::mutex> lock( _cache_mutex );
+     _decoded_blocks.clear();
+     _decoded_by_id.clear();
+  }
+  _index_map = nullptr;
+  _mappings.clear();
+  _index_entries = 0;
+  ::close( _blocks_fd );
+  ::close( _index_fd );
+  _blocks_fd = -1;
+  _index_fd = -1;
 }
 
 void block_database::flush()
 {
-  _blocks.flush();
-  _block_num_to_pos.flush();
+  if( is_open() )
+     commit_pending();
+}
+
+void block_database::set_group_commit( uint32_t max_blocks, uint32_t max_bytes )
+{
+   _max_pending_blocks = std::max<uint32_t>( max_blocks, 1 );
+   _max_pending_bytes  = max_bytes;
+}
+
+bool block_database::is_codec_supported( block_codec codec )
+{
+   switch( codec )
+   {
+      case block_codec::raw:
+         return true;
+#ifdef GRAPHENE_HAVE_ZSTD
+      case block_codec::zstd:
+         return true;
+#endif
+      default:
+         return false;
+   }
+}
+
+void block_database::set_compression( block_codec codec )
+{
+   FC_ASSERT( is_codec_supported( codec ), "Block codec ${c} is not supported by this build", ("c",uint32_t(codec)) );
+   _codec = codec;
+}
+
+uint32_t block_database::copy_from( const block_database& src )
+{
+   auto last = src.last_index_entry();
+   if( !last.valid() )
+      return 0;
+   uint32_t copied = 0;
+   const uint32_t last_num = block_header::num_from_id( last->block_id );
+   for( uint32_t num = 1; num <= last_num; ++num )
+   {
+      auto block = src.fetch_by_number( num );
+      if( !block.valid() )
+         continue;
+      store( block->id(), *block );
+      ++copied;
+   }
+   flush();
+   return copied;
+}
+
+void block_database::use_compressed_blocks_file()
+{
+   if( _blocks_filename.filename() == fc::path( compressed_blocks_filename ) )
+      return;
+   // the open descriptor keeps referring to the renamed file
+   const fc::path compressed = _blocks_filename.parent_path() / compressed_blocks_filename;
+   fc::rename( _blocks_filename, compressed );
+   _blocks_filename = compressed;
+}
+
+void block_database::map_index( uint64_t min_entries )const
+{
+   const index_mapping* current = _index_map.load();
+   if( current != nullptr && current->capacity >= min_entries )
+      return;
+   uint64_t capacity = std::max( min_index_mapping_entries, current ? current->capacity : 0 );
+   while( capacity < min_entries )
+      capacity *= 2;
+   // readers may still hold the old mapping, it is only released on close()
+   _mappings.emplace_back( new index_mapping( _index_fd, capacity ) );
+   _index_map = _mappings.back().get();
+}
+
+void block_database::write_index_entries( const std::map<uint32_t, index_entry>& entries )const
+{
+   // consecutive entries, the common case when appending blocks, are written with a single call
+   auto itr = entries.begin();
+   while( itr != entries.end() )
+   {
+      auto run_end = itr;
+      std::vector<index_entry> run;
+      uint32_t next_num = itr->first;
+      while( run_end != entries.end() && run_end->first == next_num )
+      {
+         run.push_back( run_end->second );
+         ++run_end;
+         ++next_num;
+      }
+      {
+         std::lock_guard<std::mutex> lock( _index_mutex );
+         pwrite_all( _index_fd, (const char*)run.data(), run.size() * sizeof(index_entry),
+                     uint64_t(itr->first) * sizeof(index_entry) );
+      }
+      itr = run_end;
+   }
+   if( !entries.empty() )
+   {
+      const uint64_t entry_count = uint64_t(entries.rbegin()->first) + 1;
+      map_index( entry_count );
+      if( entry_count > _index_entries )
+         _index_entries = entry_count;
+   }
+}
+
+void block_database::commit_pending()const
+{
+   if( !_has_pending ) return;
+   std::lock_guard<std::mutex> lock( _pending_mutex );
+   // blocks first, so that an index entry never points past the end of the blocks file
+   pwrite_all( _blocks_fd, _pending_blocks.data(), _pending_blocks.size(), _blocks_size );
+   write_index_entries( _pending_index );
+   _blocks_size += _pending_blocks.size();
+   _pending_blocks.clear();
+   _pending_index.clear();
+   _has_pending = false;
 }
 
 void block_database::store( const block_id_type& _id, const signed_block& b )
@@ -87,110 +333,148 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
       elog( "id argument of block_database::store() was not initialized for block ${id}", ("id", id) );
    }
    auto num = block_header::num_from_id(id);
-   _block_num_to_pos.seekp( sizeof( index_entry ) * num );
-   index_entry e;
-   _blocks.seekp( 0, _blocks.end );
-   auto vec = fc::raw::pack( b );
-   e.block_pos  = _blocks.tellp();
-   e.block_size = vec.size();
-   e.block_id   = id;
-   _blocks.write( vec.data(), vec.size() );
-   _block_num_to_pos.write( (char*)&e, sizeof(e) );
+   auto vec = compress_block( fc::raw::pack( b ), _codec );
+   bool commit = false;
+   {
+      std::lock_guard<std::mutex> lock( _pending_mutex );
+      if( _codec != block_codec::raw )
+         use_compressed_blocks_file();
+      index_entry e;
+      e.set_position( _blocks_size + _pending_blocks.size(), _codec );
+      e.block_size = vec.size();
+      e.block_id   = id;
+      _pending_blocks.insert( _pending_blocks.end(), vec.begin(), vec.end() );
+      _pending_index[num] = e;
+      _has_pending = true;
+      commit = _pending_index.size() >= _max_pending_blocks || _pending_blocks.size() >= _max_pending_bytes;
+   }
+   if( commit )
+      commit_pending();
 }
 
 void block_database::remove( const block_id_type& id )
 { try {
-   index_entry e;
-   auto index_pos = sizeof(e)*block_header::num_from_id(id);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-
-   std::streampos s_pos = _block_num_to_pos.tellg();
-   if (-1 == s_pos){ 
-      FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database, _block_num_to_pos.tellg failed", ("id", id));
+   const auto num = block_header::num_from_id(id);
+   if( _has_pending )
+   {
+      std::lock_guard<std::mutex> lock( _pending_mutex );
+      auto itr = _pending_index.find( num );
+      if( itr != _pending_index.end() )
+      {
+         if( itr->second.block_id == id )
+            itr->second.block_size = 0;
+         return;
+      }
    }
 
-   if ( static_cast<uint32_t>(s_pos) <= index_pos ){
+   if( num >= _index_entries )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database", ("id", id));
-   }
-
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
 
+   std::lock_guard<std::mutex> lock( _index_mutex );
+   index_entry e = _index_map.load()->entries[num];
    if( e.block_id == id )
    {
       e.block_size = 0;
-      _block_num_to_pos.seekp( sizeof(e)*block_header::num_from_id(id) );
-      _block_num_to_pos.write( (char*)&e, sizeof(e) );
+      pwrite_all( _index_fd, (const char*)&e, sizeof(e), uint64_t(num) * sizeof(e) );
    }
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
-bool block_database::contains( const block_id_type& id )const
-{ try {
-   if( id == block_id_type() )
-      return false;
+optional<index_entry> block_database::read_index_entry( uint32_t block_num )const
+{
+   if( _has_pending )
+   {
+      std::lock_guard<std::mutex> lock( _pending_mutex );
+      auto itr = _pending_index.find( block_num );
+      if( itr != _pending_index.end() )
+         return itr->second;
+   }
+   // the entry count is published after the mapping, so the mapping always covers it
+   if( block_num >= _index_entries.load() )
+      return optional<index_entry>();
+   std::lock_guard<std::mutex> lock( _index_mutex );
+   return _index_map.load()->entries[block_num];
+}
 
-   index_entry e;
-   auto index_pos = sizeof(e)*block_header::num_from_id(id);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
+optional<signed_block> block_database::read_block( const index_entry& e )const
+{
+   if( e.block_size == 0 )
+      return optional<signed_block>();
 
-   std::streampos s_pos = _block_num_to_pos.tellg();
-   if (-1 == s_pos){
-      FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database, _block_num_to_pos.tellg failed", ("id", id));
+   // compressed blocks are decoded once and kept around, peers tend to ask for the same recent blocks
+   const bool cached = e.codec() != block_codec::raw;
+   if( cached )
+   {
+      std::lock_guard<std::mutex> lock( _cache_mutex );
+      auto itr = _decoded_by_id.find( e.block_id );
+      if( itr != _decoded_by_id.end() )
+      {
+         _decoded_blocks.splice( _decoded_blocks.begin(), _decoded_blocks, itr->second );
+         return *itr->second;
+      }
    }
 
-   if ( static_cast<uint32_t>(s_pos) < index_pos + sizeof(e) )
-      return false;
+   vector<char> data( e.block_size );
+   bool found = false;
+   if( _has_pending )
+   {
+      std::lock_guard<std::mutex> lock( _pending_mutex );
+      if( e.offset() >= _blocks_size )
+      {
+         const uint64_t offset = e.offset() - _blocks_size;
+         FC_ASSERT( offset + e.block_size <= _pending_blocks.size() );
+         std::copy( _pending_blocks.begin() + offset, _pending_blocks.begin() + offset + e.block_size, data.begin() );
+         found = true;
+      }
+   }
+   if( !found && !pread_all( _blocks_fd, data.data(), e.block_size, e.offset() ) )
+      return optional<signed_block>();
+   auto result = fc::raw::unpack<signed_block>( decompress_block( std::move(data), e.codec() ) );
+   FC_ASSERT( result.id() == e.block_id );
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
+   if( cached )
+   {
+      std::lock_guard<std::mutex> lock( _cache_mutex );
+      if( _decoded_by_id.find( e.block_id ) == _decoded_by_id.end() )
+      {
+         _decoded_blocks.push_front( result );
+         _decoded_by_id[e.block_id] = _decoded_blocks.begin();
+         if( _decoded_blocks.size() > _max_decoded_blocks )
+         {
+            _decoded_by_id.erase( _decoded_blocks.back().id() );
+            _decoded_blocks.pop_back();
+         }
+      }
+   }
+   return result;
+}
+
+bool block_database::contains( const block_id_type& id )const
+{ try {
+   if( id == block_id_type() )
+      return false;
 
-   return e.block_id == id && e.block_size > 0;
+   auto e = read_index_entry( block_header::num_from_id(id) );
+   return e.valid() && e->block_id == id && e->block_size > 0;
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
 block_id_type block_database::fetch_block_id( uint32_t block_num )const
 {
    assert( block_num != 0 );
-   index_entry e;
-   auto index_pos = sizeof(e)*block_num;
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= int64_t(index_pos) )
+   auto e = read_index_entry( block_num );
+   if( !e.valid() )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block number ${block_num} not contained in block database", ("block_num", block_num));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-   FC_ASSERT( e.block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
-   return e.block_id;
+   FC_ASSERT( e->block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
+   return e->block_id;
 }
 
 optional<signed_block> block_database::fetch_optional( const block_id_type& id )const
 {
    try
    {
-      index_entry e;
-      auto index_pos = sizeof(e)*block_header::num_from_id(id);
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      std::streampos s_pos = _block_num_to_pos.tellg();
-
-      if (-1 == s_pos){
-         FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database, _block_num_to_pos.tellg failed", ("id", id));
-      }
-
-      if ( static_cast<uint32_t>(s_pos) <= index_pos )
-         return {};
-
-      _block_num_to_pos.seekg( index_pos );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-      if( e.block_id != id ) return optional<signed_block>();
-
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      if (e.block_size)
-         _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
-      return result;
+      auto e = read_index_entry( block_header::num_from_id(id) );
+      if( !e.valid() || e->block_id != id ) return optional<signed_block>();
+      return read_block( *e );
    }
    catch (const fc::exception&)
    {
@@ -205,26 +489,9 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
 {
    try
    {
-      index_entry e;
-      auto index_pos = sizeof(e)*block_num;
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      std::streampos s_pos = _block_num_to_pos.tellg();
-      if (-1 == s_pos){
-         FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${block_num} not contained in block database, _block_num_to_pos.tellg failed", ("block_num", block_num));
-      }
-
-      if ( static_cast<uint32_t>(s_pos) <= index_pos )
-         return {};
-
-      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
-      return result;
+      auto e = read_index_entry( block_num );
+      if( !e.valid() ) return optional<signed_block>();
+      return read_block( *e );
    }
    catch (const fc::exception&)
    {
@@ -238,39 +505,23 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
 optional<index_entry> block_database::last_index_entry()const {
    try
    {
-      index_entry e;
-
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      std::streampos pos = _block_num_to_pos.tellg();
-      if (-1 == pos){
-         FC_THROW_EXCEPTION(fc::key_not_found_exception, "last_index_entry tellg failed");
-      }
-
-      if( static_cast<size_t>(pos) < sizeof(index_entry) )
-         return optional<index_entry>();
+      commit_pending();
 
-      pos -= pos % sizeof(index_entry);
-
-      _blocks.seekg( 0, _block_num_to_pos.end );
-      const std::streampos blocks_size = _blocks.tellg();
-      while( pos > 0 )
+      uint64_t entries = _index_entries;
+      const index_mapping* mapping = _index_map.load();
+      optional<index_entry> result;
+      while( entries > 0 && !result.valid() )
       {
-         pos -= sizeof(index_entry);
-         _block_num_to_pos.seekg( pos );
-         _block_num_to_pos.read( (char*)&e, sizeof(e) );
-         if( _block_num_to_pos.gcount() == sizeof(e) && e.block_size > 0
-                && e.block_pos + static_cast<uint64_t>(e.block_size) <= static_cast<uint64_t>(blocks_size) )
+         index_entry e;
+         {
+            std::lock_guard<std::mutex> lock( _index_mutex );
+            e = mapping->entries[entries - 1];
+         }
+         if( e.block_size > 0 && e.offset() + static_cast<uint64_t>(e.block_size) <= _blocks_size )
             try
             {
-               vector<char> data( e.block_size );
-               _blocks.seekg( e.block_pos );
-               _blocks.read( data.data(), e.block_size );
-               if( _blocks.gcount() == e.block_size )
-               {
-                  const signed_block block = fc::raw::unpack<signed_block>(data);
-                  if( block.id() == e.block_id )
-                     return e;
-               }
+               if( read_block( e ).valid() )
+                  result = e;
             }
             catch (const fc::exception&)
             {
@@ -278,8 +529,16 @@ optional<index_entry> block_database::last_index_entry()const {
             catch (const std::exception&)
             {
             }
-         fc::resize_file( _index_filename, pos );
+         if( !result.valid() )
+            --entries;
+      }
+      // drop the invalid tail, including a partially written entry
+      if( entries * sizeof(index_entry) != file_size( _index_fd ) )
+      {
+         _index_entries = entries;
+         FC_ASSERT( ftruncate( _index_fd, entries * sizeof(index_entry) ) == 0 );
       }
+      return result;
    }
    catch (const fc::exception&)
    {
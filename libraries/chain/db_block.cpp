@@ -383,7 +383,12 @@ processed_transaction database::_push_transaction( const signed_transaction& trx
    // If this is the first transaction pushed after applying a block, start a new undo session.
    // This allows us to quickly rewind to the clean state of the head block, in case a new block arrives.
    if( !_pending_tx_session.valid() )
+   {
       _pending_tx_session = _undo_db.start_undo_session();
+      _pending_tx_session_base = _pending_tx.size();
+      _pending_tx_session_skip = 0;
+   }
+   _pending_tx_session_skip |= get_node_properties().skip_flags;
 
    // Create a temporary undo session as a child of _pending_tx_session.
    // The temporary session will be discarded by the destructor if
@@ -491,60 +496,102 @@ signed_block database::_generate_block(
    auto maximum_block_size = get_global_properties().parameters.maximum_block_size;
    size_t total_block_size = max_block_header_size;
 
+   block_generation_stats stats;
+   const fc::time_point assembly_start = fc::time_point::now();
+   const fc::time_point assembly_deadline = _block_assembly_time_budget.count() > 0 ?
+                                            assembly_start + _block_assembly_time_budget : fc::time_point::maximum();
+
    signed_block pending_block;
 
    //
-   // The following code throws away existing pending_tx_session and
-   // rebuilds it by re-applying pending transactions.
+   // When every pending transaction was applied in _pending_tx_session on top of the
+   // head block, with no skip flags this block is not generated with, their processed
+   // results are what applying them again would give.  A prefix of them is just as
+   // valid, so they are taken in order until one does not fit or time runs out.
    //
-   // This rebuild is necessary because pending transactions' validity
-   // and semantics may have changed since they were received, because
-   // time-based semantics are evaluated based on the current block
-   // time.  These changes can only be reflected in the database when
-   // the value of the "when" variable is known, which means we need to
-   // re-apply pending transactions in this method.
-   //
-   _pending_tx_session.reset();
-   _pending_tx_session = _undo_db.start_undo_session();
-
-   uint64_t postponed_tx_count = 0;
-   // pop pending state (reset to head block state)
-   for( const processed_transaction& tx : _pending_tx )
+   if( _pending_tx_session.valid() && _pending_tx_session_base == 0
+       && ( _pending_tx_session_skip & ~skip ) == 0 )
    {
-      size_t new_total_size = total_block_size + fc::raw::pack_size( tx );
-
-      // postpone transaction if it would make block too big
-      if( new_total_size >= maximum_block_size )
+      stats.reused_pending_state = true;
+      for( const processed_transaction& tx : _pending_tx )
       {
-         postponed_tx_count++;
-         continue;
+         if( fc::time_point::now() > assembly_deadline )
+         {
+            stats.time_budget_exceeded = true;
+            break;
+         }
+         if( total_block_size + tx.get_packed_size() >= maximum_block_size )
+            break;
+         total_block_size += tx.get_packed_size();
+         pending_block.transactions.push_back( tx );
       }
+      stats.postponed_transactions = _pending_tx.size() - pending_block.transactions.size();
+   }
+   else
+   {
+      //
+      // The following code throws away existing pending_tx_session and
+      // rebuilds it by re-applying pending transactions.
+      //
+      // This rebuild is necessary because pending transactions' validity
+      // and semantics may have changed since they were received, because
+      // time-based semantics are evaluated based on the current block
+      // time.  These changes can only be reflected in the database when
+      // the value of the "when" variable is known, which means we need to
+      // re-apply pending transactions in this method.
+      //
+      _pending_tx_session.reset();
+      _pending_tx_session = _undo_db.start_undo_session();
 
-      try
+      // pop pending state (reset to head block state)
+      for( const processed_transaction& tx : _pending_tx )
       {
-         auto temp_session = _undo_db.start_undo_session();
-         processed_transaction ptx = _apply_transaction( tx );
-         temp_session.merge();
-
-         // We have to recompute pack_size(ptx) because it may be different
-         // than pack_size(tx) (i.e. if one or more results increased
-         // their size)
-         total_block_size += fc::raw::pack_size( ptx );
-         pending_block.transactions.push_back( ptx );
-      }
-      catch ( const fc::exception& e )
-      {
-         // Do nothing, transaction will not be re-applied
-         wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
-         wlog( "The transaction was ${t}", ("t", tx) );
+         if( fc::time_point::now() > assembly_deadline )
+         {
+            stats.time_budget_exceeded = true;
+            stats.postponed_transactions += _pending_tx.size() - pending_block.transactions.size();
+            break;
+         }
+
+         size_t new_total_size = total_block_size + tx.get_packed_size();
+
+         // postpone transaction if it would make block too big
+         if( new_total_size >= maximum_block_size )
+         {
+            stats.postponed_transactions++;
+            continue;
+         }
+
+         try
+         {
+            auto temp_session = _undo_db.start_undo_session();
+            processed_transaction ptx = _apply_transaction( tx );
+            temp_session.merge();
+
+            // We have to recompute pack_size(ptx) because it may be different
+            // than pack_size(tx) (i.e. if one or more results increased
+            // their size)
+            total_block_size += ptx.get_packed_size();
+            pending_block.transactions.push_back( ptx );
+         }
+         catch ( const fc::exception& e )
+         {
+            // Do nothing, transaction will not be re-applied
+            wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
+            wlog( "The transaction was ${t}", ("t", tx) );
+         }
       }
    }
-   if( postponed_tx_count > 0 )
+   if( stats.postponed_transactions > 0 )
    {
-      wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
+      wlog( "Postponed ${n} transactions due to ${r}", ("n", stats.postponed_transactions)
+            ("r", stats.time_budget_exceeded ? "block assembly time budget" : "block size limit") );
    }
 
    _pending_tx_session.reset();
+   stats.included_transactions = pending_block.transactions.size();
+   const fc::time_point sealing_start = fc::time_point::now();
+   stats.assembly_time = sealing_start - assembly_start;
 
    // We have temporarily broken the invariant that
    // _pending_tx_session is the result of applying _pending_tx, as
@@ -581,8 +628,14 @@ signed_block database::_generate_block(
       FC_ASSERT( fc::raw::pack_size(pending_block) <= get_global_properties().parameters.maximum_block_size );
    }
 
+   const fc::time_point push_start = fc::time_point::now();
+   stats.sealing_time = push_start - sealing_start;
+
    push_block( pending_block, skip | skip_transaction_signatures ); // skip authority check when pushing self-generated blocks
 
+   stats.push_time = fc::time_point::now() - push_start;
+   _last_block_generation_stats = stats;
+
    return pending_block;
 } FC_CAPTURE_AND_RETHROW( (witness_id) ) }
 
@@ -683,6 +736,15 @@ void database::_apply_block( const signed_block& next_block )
 
    _issue_453_affected_assets.clear();
 
+   if( !(skip & (skip_transaction_signatures | skip_authority_check)) )
+   {
+      vector<const signed_transaction*> trxs;
+      trxs.reserve( next_block.transactions.size() );
+      for( const auto& trx : next_block.transactions )
+         trxs.push_back( &trx );
+      precompute_signees( trxs );
+   }
+
    for( const auto& trx : next_block.transactions )
    {
       /* We do not need to push the undo state for each transaction
@@ -782,6 +844,36 @@ class undo_size_restorer {
       size_t         old_max;
 };
 
+void database::set_signature_threads( uint32_t threads )
+{
+   if( threads == 0 )
+      _signature_pool.reset();
+   else
+      _signature_pool.reset( new graphene::db::thread_pool( threads ) );
+}
+
+void database::precompute_signees( const vector<const signed_transaction*>& trxs )const
+{
+   if( !_signature_pool )
+      return;
+   vector<const signed_transaction*> todo;
+   todo.reserve( trxs.size() );
+   for( const signed_transaction* trx : trxs )
+      if( trx->signees.empty() && !trx->signatures.empty() )
+         todo.push_back( trx );
+   if( todo.size() < 2 )
+      return;
+
+   const chain_id_type& chain_id = get_chain_id();
+   _signature_pool->run( todo.size(), [&todo,&chain_id]( size_t i ) {
+      try {
+         todo[i]->get_signature_keys( chain_id );
+      } catch( const fc::exception& ) {
+         // signees stay empty, the error is raised again when the transaction is applied
+      }
+   });
+}
+
 processed_transaction database::_apply_transaction(const signed_transaction& trx)
 { try {
    uint32_t skip = get_node_properties().skip_flags;
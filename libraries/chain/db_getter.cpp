@@ -33,6 +33,7 @@
 #include <graphene/chain/account_role_object.hpp>
 #include <graphene/chain/son_object.hpp>
 #include <graphene/chain/son_proposal_object.hpp>
+#include <graphene/chain/distinct_number_picker.hpp>
 
 #include <ctime>
 #include <algorithm>
@@ -331,16 +332,10 @@ vector<uint64_t> database::get_random_numbers(uint64_t minimum, uint64_t maximum
          v.push_back(rnd);
       }
    } else {
-      vector<uint64_t> tmpv;
-      tmpv.reserve(selections);
-      for (uint64_t i = minimum; i < maximum; i++) {
-         tmpv.push_back(i);
-      }
-
-      for (uint64_t i = 0; (i < selections) && (tmpv.size() > 0); i++) {
-         uint64_t idx = get_random_bits(tmpv.size());
-         v.push_back(tmpv.at(idx));
-         tmpv.erase(tmpv.begin() + idx);
+      distinct_number_picker picker(minimum, maximum);
+      for (uint64_t i = 0; (i < selections) && (picker.remaining() > 0); i++) {
+         uint64_t idx = get_random_bits(picker.remaining());
+         v.push_back(picker.pick(idx));
       }
    }
 
@@ -212,6 +212,9 @@ const uint8_t nft_lottery_balance_object::type_id;
 const uint8_t random_number_object::space_id;
 const uint8_t random_number_object::type_id;
 
+const uint8_t lottery_ticket_purchase_object::space_id;
+const uint8_t lottery_ticket_purchase_object::type_id;
+
 void database::initialize_evaluators()
 {
    _operation_evaluators.resize(255);
@@ -367,15 +370,15 @@ void database::initialize_indexes()
    add_index< primary_index<tournament_index> >();
    auto tournament_details_idx = add_index< primary_index<tournament_details_index> >();
    tournament_details_idx->add_secondary_index<tournament_players_index>();
-   add_index< primary_index<match_index> >();
+   _tournament_due_index = add_index< primary_index<match_index> >()->add_secondary_index<tournament_due_index>();
    add_index< primary_index<game_index> >();
    add_index< primary_index<custom_permission_index> >();
    add_index< primary_index<custom_account_authority_index> >();
    auto offer_idx = add_index< primary_index<offer_index> >();
    offer_idx->add_secondary_index<offer_item_index>();
 
-   add_index< primary_index<nft_metadata_index > >();
-   add_index< primary_index<nft_index > >();
+   _nft_metadata_due_index = add_index< primary_index<nft_metadata_index > >()->add_secondary_index<nft_lottery_due_index>();
+   _nft_token_due_index = add_index< primary_index<nft_index > >()->add_secondary_index<nft_lottery_due_index>();
    add_index< primary_index<account_role_index> >();
    add_index< primary_index<son_proposal_index> >();
 
@@ -391,6 +394,7 @@ void database::initialize_indexes()
 
    auto bal_idx = add_index< primary_index<account_balance_index          > >();
    bal_idx->add_secondary_index<balances_by_account_index>();
+   bal_idx->add_secondary_index<asset_holders_count_index>();
 
    add_index< primary_index<asset_bitasset_data_index,                 13 > >(); // 8192
    add_index< primary_index<asset_dividend_data_object_index              > >();
@@ -419,6 +423,7 @@ void database::initialize_indexes()
    add_index< primary_index<nft_lottery_balance_index                     > >();
    add_index< primary_index<son_stats_index                               > >();
    add_index< primary_index<random_number_index                           > >();
+   add_index< primary_index<lottery_ticket_purchase_index                 > >();
 
 }
 
@@ -104,7 +104,7 @@ vector<std::reference_wrapper<const son_object>> database::sort_votable_objects<
 }
 
 template<class Type>
-void database::perform_account_maintenance(Type tally_helper)
+void database::perform_account_maintenance(Type& tally_helper)
 {
    const auto& bal_idx = get_index_type< account_balance_index >().indices().get< by_maintenance_flag >();
    if( bal_idx.begin() != bal_idx.end() )
@@ -2043,6 +2043,15 @@ void update_son_params(database& db)
    }
 }
 
+void database::set_vote_tally_threads( uint32_t threads, bool cross_check )
+{
+   if( threads == 0 )
+      _vote_tally_pool.reset();
+   else
+      _vote_tally_pool.reset( new graphene::db::thread_pool( threads ) );
+   _vote_tally_cross_check = cross_check;
+}
+
 void database::perform_chain_maintenance(const signed_block& next_block, const global_property_object& global_props)
 { try {
    const auto& gpo = get_global_properties();
@@ -2056,20 +2065,111 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
 
    update_son_params(*this);
 
+   struct vote_tally_buffers {
+      vector<uint64_t> votes;
+      vector<uint64_t> witness_counts;
+      vector<uint64_t> committee_counts;
+      vector<uint64_t> son_counts;
+      uint64_t         total_stake = 0;
+
+      vote_tally_buffers(const global_property_object& props)
+         : votes(props.next_available_vote_id),
+           witness_counts(props.parameters.maximum_witness_count / 2 + 1),
+           committee_counts(props.parameters.maximum_committee_count / 2 + 1),
+           son_counts(props.parameters.maximum_son_count() / 2 + 1) {}
+
+      void add(const vote_tally_buffers& other)
+      {
+         for( size_t i = 0; i < votes.size(); ++i )
+            votes[i] += other.votes[i];
+         for( size_t i = 0; i < witness_counts.size(); ++i )
+            witness_counts[i] += other.witness_counts[i];
+         for( size_t i = 0; i < committee_counts.size(); ++i )
+            committee_counts[i] += other.committee_counts[i];
+         for( size_t i = 0; i < son_counts.size(); ++i )
+            son_counts[i] += other.son_counts[i];
+         total_stake += other.total_stake;
+      }
+
+      bool operator==(const vote_tally_buffers& other)const
+      {
+         return votes == other.votes && witness_counts == other.witness_counts &&
+                committee_counts == other.committee_counts && son_counts == other.son_counts &&
+                total_stake == other.total_stake;
+      }
+   };
+
+   // calculate_vesting_factor() only depends on which GPOS subperiod the last vote falls in, so the factor
+   // of every subperiod is computed once, the same way calculate_vesting_factor() does it
+   struct vesting_factor_table {
+      fc::time_point_sec period_start;
+      uint32_t           subperiod;
+      uint32_t           current_subperiod;
+      bool               in_period;
+      bool               roll_in;
+      vector<double>     factors;
+
+      vesting_factor_table(database& d, const global_property_object& props)
+      {
+         const auto vesting_period = props.parameters.gpos_period();
+         subperiod = props.parameters.gpos_subperiod();
+         period_start = fc::time_point_sec(props.parameters.gpos_period_start());
+         const auto number_of_subperiods = vesting_period / subperiod;
+
+         current_subperiod = d.get_gpos_current_subperiod();
+         in_period = current_subperiod != 0 && current_subperiod <= number_of_subperiods;
+         roll_in = current_subperiod == 1 && d.head_block_time() >= HARDFORK_GPOS_TIME + vesting_period;
+         if( !in_period )
+            return;
+
+         // factors[s] is the factor of a last vote in subperiod s; factors[1] also covers votes in none of
+         // the subperiods calculate_vesting_factor() checks
+         factors.resize(current_subperiod + 1);
+         for( uint32_t s = 1; s <= current_subperiod; ++s )
+         {
+            double numerator = number_of_subperiods;
+            for( uint32_t sub = current_subperiod; sub > 1; --sub )
+            {
+               numerator--;
+               if( sub == s ) {
+                  numerator++;
+                  break;
+               }
+            }
+            factors[s] = numerator / number_of_subperiods;
+         }
+      }
+
+      double operator()(fc::time_point_sec last_date_voted)const
+      {
+         if( !in_period )
+            return 0;
+         if( roll_in && last_date_voted > period_start - subperiod )
+            return 1;
+         if( last_date_voted < period_start )
+            return 0;
+         // subperiod s spans (period_start + (s-1) * subperiod, period_start + s * subperiod]
+         uint64_t s = (uint64_t(last_date_voted.sec_since_epoch() - period_start.sec_since_epoch()) + subperiod - 1) / subperiod;
+         if( s < 2 || s > current_subperiod )
+            s = 1;
+         return factors[s];
+      }
+   };
+
    struct vote_tally_helper {
       database& d;
       const global_property_object& props;
       std::map<account_id_type, share_type> vesting_amounts;
+      vote_tally_buffers totals;
+
+      /// set when the voters are tallied on the vote tally pool once all accounts were visited
+      graphene::db::thread_pool* pool = nullptr;
+      bool cross_check = false;
+      vector<const account_object*> voters;
 
       vote_tally_helper(database& d, const global_property_object& gpo)
-         : d(d), props(gpo)
+         : d(d), props(gpo), totals(gpo)
       {
-         d._vote_tally_buffer.resize(props.next_available_vote_id);
-         d._witness_count_histogram_buffer.resize(props.parameters.maximum_witness_count / 2 + 1);
-         d._committee_count_histogram_buffer.resize(props.parameters.maximum_committee_count / 2 + 1);
-         d._son_count_histogram_buffer.resize(props.parameters.maximum_son_count() / 2 + 1);
-         d._total_voting_stake = 0;
-
          auto balance_type = vesting_balance_type::normal;
          if(d.head_block_time() >= HARDFORK_GPOS_TIME)
             balance_type = vesting_balance_type::gpos;
@@ -2088,9 +2188,71 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
                  ("amount", vesting_balance_obj.balance.amount));
          }
 
+         // Until half a subperiod after GPOS activation the stake also includes balances that processing
+         // the fees of other accounts in the same pass can change, so the tally has to stay interleaved
+         // with it. Later on it only reads state that pass leaves alone and may run after it.
+         if( d._vote_tally_pool && d.head_block_time() >= (HARDFORK_GPOS_TIME + props.parameters.gpos_subperiod()/2) )
+         {
+            pool = d._vote_tally_pool.get();
+            cross_check = d._vote_tally_cross_check;
+         }
+      }
+
+      void operator()( const account_object& stake_account, const account_statistics_object& )
+      {
+         if( !pool || cross_check )
+            tally( stake_account, totals, nullptr );
+         if( pool )
+            voters.push_back( &stake_account );
+      }
+
+      /// Tallies the collected voters in parallel if enabled and hands the result to the database
+      void finish()
+      {
+         if( pool && !voters.empty() )
+         {
+            const vesting_factor_table factors( d, props );
+            const size_t shard_count = std::min<size_t>( pool->size(), voters.size() );
+            vector<vote_tally_buffers> shards( shard_count, vote_tally_buffers( props ) );
+            pool->run( shard_count, [&]( size_t shard ) {
+               const size_t begin = voters.size() * shard / shard_count;
+               const size_t end = voters.size() * (shard + 1) / shard_count;
+               for( size_t i = begin; i < end; ++i )
+                  tally( *voters[i], shards[shard], &factors );
+            });
+
+            // unsigned sums do not depend on the order of the shards, they are merged in order regardless
+            vote_tally_buffers parallel_totals( props );
+            for( const vote_tally_buffers& shard : shards )
+               parallel_totals.add( shard );
+
+            if( !cross_check )
+               totals = std::move( parallel_totals );
+            else if( !(parallel_totals == totals) )
+            {
+               ++d._vote_tally_mismatches;
+               elog( "Parallel vote tally of block ${b} differs from the serial one, using the serial result",
+                     ("b", d.head_block_num()) );
+            }
+         }
+
+         d._vote_tally_buffer = std::move( totals.votes );
+         d._witness_count_histogram_buffer = std::move( totals.witness_counts );
+         d._committee_count_histogram_buffer = std::move( totals.committee_counts );
+         d._son_count_histogram_buffer = std::move( totals.son_counts );
+         d._total_voting_stake = totals.total_stake;
+      }
+
+      fc::time_point_sec last_vote_time( const account_object& stake_account )const
+      {
+         if( stake_account.options.voting_account == GRAPHENE_PROXY_TO_SELF_ACCOUNT )
+            return stake_account.statistics(d).last_vote_time;
+         return stake_account.options.voting_account(d).statistics(d).last_vote_time;
       }
 
-      void operator()( const account_object& stake_account, const account_statistics_object& stats )
+      /// Adds the stake of the account to the buffers; the vesting factor is looked up in factors if given
+      void tally( const account_object& stake_account, vote_tally_buffers& buffers,
+                  const vesting_factor_table* factors )const
       {
          if( props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time()) )
          {
@@ -2119,7 +2281,8 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
                if (itr == vesting_amounts.end() && d.head_block_time() >= (HARDFORK_GPOS_TIME + props.parameters.gpos_subperiod()/2))
                   return;
 
-               auto vesting_factor = d.calculate_vesting_factor(stake_account);
+               auto vesting_factor = factors ? (*factors)(last_vote_time(stake_account))
+                                             : d.calculate_vesting_factor(stake_account);
                voting_stake = (uint64_t)floor(voting_stake * vesting_factor);
 
                //Include votes(based on stake) for the period of gpos_subperiod()/2 as system has zero votes on GPOS activation
@@ -2141,51 +2304,53 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
             {
                uint32_t offset = id.instance();
                // if they somehow managed to specify an illegal offset, ignore it.
-               if( offset < d._vote_tally_buffer.size() )
-                  d._vote_tally_buffer[offset] += voting_stake;
+               if( offset < buffers.votes.size() )
+                  buffers.votes[offset] += voting_stake;
             }
 
             if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
             {
                uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
-                                          d._witness_count_histogram_buffer.size() - 1);
+                                          buffers.witness_counts.size() - 1);
                // votes for a number greater than maximum_witness_count
                // are turned into votes for maximum_witness_count.
                //
                // in particular, this takes care of the case where a
                // member was voting for a high number, then the
                // parameter was lowered.
-               d._witness_count_histogram_buffer[offset] += voting_stake;
+               buffers.witness_counts[offset] += voting_stake;
             }
             if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
             {
                uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
-                                          d._committee_count_histogram_buffer.size() - 1);
+                                          buffers.committee_counts.size() - 1);
                // votes for a number greater than maximum_committee_count
                // are turned into votes for maximum_committee_count.
                //
                // same rationale as for witnesses
-               d._committee_count_histogram_buffer[offset] += voting_stake;
+               buffers.committee_counts[offset] += voting_stake;
             }
             if( opinion_account.options.num_son <= props.parameters.maximum_son_count() )
             {
                uint16_t offset = std::min(size_t(opinion_account.options.num_son/2),
-                                          d._son_count_histogram_buffer.size() - 1);
+                                          buffers.son_counts.size() - 1);
                // votes for a number greater than maximum_son_count
                // are turned into votes for maximum_son_count.
                //
                // in particular, this takes care of the case where a
                // member was voting for a high number, then the
                // parameter was lowered.
-               d._son_count_histogram_buffer[offset] += voting_stake;
+               buffers.son_counts[offset] += voting_stake;
             }
 
-            d._total_voting_stake += voting_stake;
+            buffers.total_stake += voting_stake;
          }
       }
+
    } tally_helper(*this, gpo);
 
    perform_account_maintenance( tally_helper );
+   tally_helper.finish();
    struct clear_canary {
       clear_canary(vector<uint64_t>& target): target(target){}
       ~clear_canary() { target.clear(); }
@@ -31,8 +31,12 @@
 #include <graphene/chain/nft_object.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
 
+#include <graphene/db/thread_pool.hpp>
+
 #include <fc/io/fstream.hpp>
+#include <fc/thread/thread.hpp>
 
+#include <atomic>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -95,6 +99,124 @@ public:
     }
 };
 
+/// a block read and checked ahead of being applied during replay
+struct prefetched_block
+{
+   optional<signed_block> block;
+   bool                   merkle_ok = false;
+};
+
+/**
+ * Reads, unpacks and verifies the merkle root of upcoming blocks on a thread pool while the
+ * caller applies the previous ones. Nothing done here depends on chain state. Blocks are
+ * prepared in batches of queue_depth, one batch is in flight while the previous one is consumed.
+ */
+class replay_pipeline
+{
+public:
+   replay_pipeline( const block_database& blocks, uint32_t threads, uint32_t queue_depth,
+                    uint32_t first_block, uint32_t last_block ) :
+      _blocks( blocks ),
+      _pool( threads ),
+      _depth( std::max<uint32_t>( queue_depth, 1 ) ),
+      _next_num( first_block ),
+      _last_num( last_block )
+   {
+      if( threads > 0 )
+         _prefetch_thread.reset( new fc::thread( "replay_prefetch" ) );
+      schedule();
+   }
+
+   ~replay_pipeline()
+   {
+      try {
+         stop();
+      } FC_CAPTURE_AND_LOG( (_next_num) )
+   }
+
+   /// @return the block following the one returned by the previous call
+   prefetched_block take()
+   {
+      if( _pos == _current.size() )
+      {
+         const auto wait_start = fc::time_point::now();
+         stop();
+         _stall_us += ( fc::time_point::now() - wait_start ).count();
+         _current = std::move( _ready );
+         _ready = vector<prefetched_block>();
+         _pos = 0;
+         schedule();
+      }
+      return std::move( _current[_pos++] );
+   }
+
+   /// waits until no block is being read, must be called before modifying the block database
+   void stop()
+   {
+      if( _in_flight.valid() )
+      {
+         _in_flight.wait();
+         _in_flight = fc::future<void>();
+      }
+   }
+
+   /// wall time spent preparing blocks, in microseconds
+   int64_t  prefetch_us()const { return _prefetch_us; }
+   uint64_t prefetched()const  { return _prefetched; }
+   /// time the caller spent waiting for blocks to be prepared, in microseconds
+   int64_t  stall_us()const    { return _stall_us; }
+
+private:
+   void schedule()
+   {
+      if( _next_num > _last_num )
+         return;
+      const uint32_t start = _next_num;
+      const uint32_t count = std::min<uint64_t>( _depth, uint64_t(_last_num) - start + 1 );
+      _next_num += count;
+
+      auto job = [this,start,count]() {
+         const auto job_start = fc::time_point::now();
+         _ready.resize( count );
+         _pool.run( count, [this,start]( size_t i ) {
+            prefetched_block& item = _ready[i];
+            item.block = _blocks.fetch_by_number( start + i );
+            if( item.block.valid() )
+               item.merkle_ok = item.block->transaction_merkle_root == item.block->calculate_merkle_root();
+         });
+         _prefetch_us += ( fc::time_point::now() - job_start ).count();
+         _prefetched += count;
+      };
+      if( _prefetch_thread )
+         _in_flight = _prefetch_thread->async( job, "replay_prefetch" );
+      else
+         job();
+   }
+
+   const block_database&         _blocks;
+   graphene::db::thread_pool     _pool;
+   std::unique_ptr<fc::thread>   _prefetch_thread;
+   const uint32_t                _depth;
+   uint32_t                      _next_num;
+   const uint32_t                _last_num;
+
+   vector<prefetched_block>      _current;
+   size_t                        _pos = 0;
+   /// written by the prefetch job only while _in_flight is pending
+   vector<prefetched_block>      _ready;
+   fc::future<void>              _in_flight;
+
+   std::atomic<int64_t>          _prefetch_us{0};
+   std::atomic<uint64_t>         _prefetched{0};
+   int64_t                       _stall_us = 0;
+};
+
+void database::set_replay_pipeline( uint32_t threads, uint32_t queue_depth )
+{
+   _replay_threads = threads;
+   _replay_queue_depth = queue_depth;
+}
+
 void database::reindex( fc::path data_dir )
 { try {
    auto last_block = _block_id_to_block.last();
@@ -121,17 +243,32 @@ void database::reindex( fc::path data_dir )
    {
        undo.disable();
    }
-   for( uint32_t i = head_block_num() + 1; i <= last_block_num; ++i )
+   const uint32_t first_block_num = head_block_num() + 1;
+   replay_pipeline pipeline( _block_id_to_block, _replay_threads, _replay_queue_depth, first_block_num, last_block_num );
+   int64_t apply_us = 0;
+   auto log_replay_progress = [&]( uint32_t block_num ) {
+      const uint64_t applied = block_num - first_block_num + 1;
+      ilog( "Replayed block ${i} of ${l}: read+decode ${r} blocks/s, apply ${a} blocks/s, waited ${s} ms for blocks",
+            ("i",block_num)("l",last_block_num)
+            ("r",pipeline.prefetch_us() > 0 ? pipeline.prefetched() * 1000000 / pipeline.prefetch_us() : 0)
+            ("a",apply_us > 0 ? applied * 1000000 / apply_us : 0)
+            ("s",pipeline.stall_us() / 1000) );
+   };
+   for( uint32_t i = first_block_num; i <= last_block_num; ++i )
    {
       if( i % 1000000 == 0 )
       {
          ilog( "Writing database to disk at block ${i}", ("i",i) );
-         flush();
+         flush( head_block_num() );
          ilog( "Done" );
       }
-      fc::optional< signed_block > block = _block_id_to_block.fetch_by_number(i);
+      if( i % 100000 == 0 )
+         log_replay_progress( i );
+      prefetched_block prefetched = pipeline.take();
+      fc::optional< signed_block >& block = prefetched.block;
       if( !block.valid() )
       {
+         pipeline.stop();
          wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", i) );
          uint32_t dropped_count = 0;
          while( true )
@@ -149,26 +286,28 @@ void database::reindex( fc::path data_dir )
          wlog( "Dropped ${n} blocks from after the gap", ("n", dropped_count) );
          break;
       }
+      // the merkle root was already verified by the pipeline, a mismatch is reported by apply_block
+      const uint32_t skip = skip_witness_signature |
+                            skip_transaction_signatures |
+                            skip_transaction_dupe_check |
+                            skip_tapos_check |
+                            skip_witness_schedule_check |
+                            skip_authority_check |
+                            ( prefetched.merkle_ok ? skip_merkle_check : 0 );
+      const auto apply_start = fc::time_point::now();
       if( i < undo_point && !_slow_replays)
       {
-         apply_block(*block, skip_witness_signature |
-                             skip_transaction_signatures |
-                             skip_transaction_dupe_check |
-                             skip_tapos_check |
-                             skip_witness_schedule_check |
-                             skip_authority_check);
+         apply_block(*block, skip);
       }
       else
       {
          undo.enable();
-         push_block(*block, skip_witness_signature |
-                            skip_transaction_signatures |
-                            skip_transaction_dupe_check |
-                            skip_tapos_check |
-                            skip_witness_schedule_check |
-                            skip_authority_check);
+         push_block(*block, skip);
       }
+      apply_us += ( fc::time_point::now() - apply_start ).count();
    }
+   pipeline.stop();
+   log_replay_progress( head_block_num() );
    undo.enable();
    auto end = fc::time_point::now();
    ilog( "Done reindexing, elapsed time: ${t} sec", ("t",double((end-start).count())/1000000.0 ) );
@@ -224,6 +363,9 @@ void database::open(
          _p_chain_property_obj = &get( chain_property_id_type() );
          _p_dyn_global_prop_obj = &get( dynamic_global_property_id_type() );
          _p_witness_schedule_obj = &get( witness_schedule_id_type() );
+         if( get_snapshot_block_num() != 0 && get_snapshot_block_num() != head_block_num() )
+            wlog( "object_database manifest was written at block ${m} but the state is at block ${h}",
+                  ("m",get_snapshot_block_num())("h",head_block_num()) );
       }
 
       fc::optional<block_id_type> last_block = _block_id_to_block.last_id();
@@ -278,7 +420,7 @@ void database::close(bool rewind)
    // DB state (issue #336).
    clear_pending();
 
-   object_database::flush();
+   object_database::flush( head_block_num() );
    object_database::close();
 
    if( _block_id_to_block.is_open() )
@@ -299,14 +441,21 @@ void database::check_ending_lotteries()
 {
    try {
       const auto& lotteries_idx = get_index_type<asset_index>().indices().get<active_lotteries>();
-      for( auto checking_asset: lotteries_idx )
-      {
-         FC_ASSERT( checking_asset.is_lottery() );
-         FC_ASSERT( checking_asset.lottery_options->is_active );
-         FC_ASSERT( checking_asset.lottery_options->end_date != time_point_sec() );
-         if( checking_asset.lottery_options->end_date > head_block_time() ) continue;
-         checking_asset.end_lottery(*this);
-      }
+      // Active lotteries come first, the latest end date first, so the due ones start at the first active
+      // lottery not ending after the head block time. Ending a lottery moves it behind the active ones,
+      // where the walk over this index stopped, so at most one lottery ends per block.
+      asset_object probe;
+      probe.lottery_options = lottery_asset_options();
+      probe.lottery_options->is_active = true;
+      probe.lottery_options->end_date = head_block_time();
+      auto lottery_itr = lotteries_idx.lower_bound( probe );
+      if( lottery_itr == lotteries_idx.end() ) return;
+
+      asset_object checking_asset = *lottery_itr;
+      FC_ASSERT( checking_asset.is_lottery() );
+      FC_ASSERT( checking_asset.lottery_options->is_active );
+      FC_ASSERT( checking_asset.lottery_options->end_date != time_point_sec() );
+      checking_asset.end_lottery(*this);
    } catch( ... ) {}
 }
 
@@ -314,16 +463,75 @@ void database::check_ending_nft_lotteries()
 {
    try {
       const auto &nft_lotteries_idx = get_index_type<nft_metadata_index>().indices().get<active_nft_lotteries>();
-      for (auto checking_token : nft_lotteries_idx)
+
+      flat_set<nft_metadata_id_type> due_lotteries;
+      std::swap(due_lotteries, _nft_token_due_index->due_lotteries);
+      due_lotteries.insert(_nft_metadata_due_index->due_lotteries.begin(), _nft_metadata_due_index->due_lotteries.end());
+      _nft_metadata_due_index->due_lotteries.clear();
+      if (_nft_token_due_index->full_scan_pending || _nft_metadata_due_index->full_scan_pending)
+      {
+         // supplies changed before the indexes existed (e.g. before a restart) are unknown, so check every lottery once
+         const auto &by_lottery_idx = get_index_type<nft_metadata_index>().indices().get<by_nft_lottery>();
+         for (auto itr = by_lottery_idx.begin(); itr != by_lottery_idx.end() && itr->is_lottery(); ++itr)
+            due_lotteries.insert(itr->get_id());
+         _nft_token_due_index->full_scan_pending = false;
+         _nft_metadata_due_index->full_scan_pending = false;
+      }
+
+      // The lottery to end is the first active one, the latest end date first, that sold out or reached its
+      // end date. Ending it moves it behind the active ones, where the walk over this index stopped, so at most
+      // one lottery ends per block. Only lotteries whose supply changed can have sold out, and the ones past
+      // their end date start at the first active lottery not ending after the head block time.
+      nft_metadata_object probe;
+      probe.lottery_data = nft_lottery_data();
+      probe.lottery_data->lottery_options.is_active = true;
+      probe.lottery_data->lottery_options.ending_on_soldout = false;
+      probe.lottery_data->lottery_options.end_date = head_block_time();
+
+      optional<time_point_sec> end_date_to_check;
+      auto first_past_end_date = nft_lotteries_idx.lower_bound(probe);
+      if (first_past_end_date != nft_lotteries_idx.end() && first_past_end_date->is_lottery() &&
+          first_past_end_date->lottery_data->lottery_options.is_active &&
+          first_past_end_date->lottery_data->lottery_options.end_date != time_point_sec())
+         end_date_to_check = first_past_end_date->get_lottery_expiration();
+
+      flat_set<nft_metadata_id_type> sold_out;
+      for (const nft_metadata_id_type &lottery_id : due_lotteries)
+      {
+         const nft_metadata_object *lottery = find(lottery_id);
+         if (!lottery || !lottery->is_lottery() || !lottery->lottery_data->lottery_options.is_active ||
+             !lottery->lottery_data->lottery_options.ending_on_soldout)
+            continue;
+         if (lottery->get_token_current_supply(*this) != lottery->max_supply)
+            continue;
+         sold_out.insert(lottery_id);
+         if (!end_date_to_check || lottery->get_lottery_expiration() > *end_date_to_check)
+            end_date_to_check = lottery->get_lottery_expiration();
+      }
+      // a sold out lottery stays due until it has ended
+      _nft_token_due_index->due_lotteries.insert(sold_out.begin(), sold_out.end());
+      if (!end_date_to_check)
+         return;
+
+      // lotteries sharing that end date are checked in index order; without an end date that is every active
+      // lottery without one, so whether they sold out is looked up in the set above instead of counting tokens
+      const auto should_end = [this, &sold_out](const nft_metadata_object &lottery) {
+         const auto &lottery_options = lottery.lottery_data->lottery_options;
+         return (lottery_options.ending_on_soldout && sold_out.find(lottery.get_id()) != sold_out.end()) ||
+                (lottery_options.end_date != time_point_sec() && (lottery_options.end_date <= head_block_time()));
+      };
+      probe.lottery_data->lottery_options.end_date = *end_date_to_check;
+      auto range = nft_lotteries_idx.equal_range(probe);
+      for (auto itr = range.first; itr != range.second; ++itr)
       {
-         FC_ASSERT(checking_token.is_lottery());
-         const auto &lottery_options = checking_token.lottery_data->lottery_options;
-         FC_ASSERT(lottery_options.is_active);
-         // Check the current supply of lottery tokens
-         auto current_supply = checking_token.get_token_current_supply(*this);
-         if ((lottery_options.ending_on_soldout && (current_supply == checking_token.max_supply)) ||
-             (lottery_options.end_date != time_point_sec() && (lottery_options.end_date <= head_block_time())))
+         FC_ASSERT(itr->is_lottery());
+         FC_ASSERT(itr->lottery_data->lottery_options.is_active);
+         if (should_end(*itr))
+         {
+            nft_metadata_object checking_token = *itr;
             checking_token.end_lottery(*this);
+            break;
+         }
       }
    } catch( ... ) {}
 }
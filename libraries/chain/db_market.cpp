@@ -159,11 +159,13 @@ bool database::apply_order(const limit_order_object& new_order_object, bool allo
    const asset_object& sell_asset = get(new_order_object.amount_for_sale().asset_id);
    const asset_object& receive_asset = get(new_order_object.amount_to_receive().asset_id);
 
-   // Possible optimization: We only need to check calls if both are true:
-   //  - The new order is at the front of the book
-   //  - The new order is below the call limit price
-   bool called_some = check_call_orders(sell_asset, allow_black_swan);
-   called_some |= check_call_orders(receive_asset, allow_black_swan);
+   // Calls are only checked when the feed has reached the least collateralized call order.  Checking only
+   // when the new order also crosses it is not enough: a canceled bid may have left a black swan behind.
+   auto check_calls = [&]( const asset_object& mia ) {
+      return call_orders_may_trigger( mia ) && check_call_orders( mia, allow_black_swan );
+   };
+   bool called_some = check_calls(sell_asset);
+   called_some |= check_calls(receive_asset);
    if( called_some && !find_object(order_id) ) // then we were filled by call order
       return true;
 
@@ -189,8 +191,8 @@ bool database::apply_order(const limit_order_object& new_order_object, bool allo
 
    //Possible optimization: only check calls if the new order completely filled some old order
    //Do I need to check both assets?
-   check_call_orders(sell_asset, allow_black_swan);
-   check_call_orders(receive_asset, allow_black_swan);
+   check_calls(sell_asset);
+   check_calls(receive_asset);
 
    const limit_order_object* updated_order_object = find< limit_order_object >( order_id );
    if( updated_order_object == nullptr )
@@ -554,6 +556,39 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
     return margin_called;
 } FC_CAPTURE_AND_RETHROW() }
 
+bool database::call_orders_may_trigger( const asset_object& mia )
+{
+   if( !mia.is_market_issued() ) return false;
+
+   const asset_bitasset_data_object& bitasset = mia.bitasset_data(*this);
+   if( bitasset.has_settlement() ) return false;
+   const price& settle_price = bitasset.current_feed.settlement_price;
+   if( settle_price.is_null() ) return false;
+
+   const call_order_object* least_collateralized = find_least_collateralized_call( bitasset.options.short_backing_asset, mia.id );
+   if( least_collateralized == nullptr ) return false;
+
+   // check_for_blackswan() compares the call against the best bid when that is above the feed, so a
+   // black swan is impossible as long as the call is collateralized beyond the feed
+   if( !( ~least_collateralized->collateralization() < settle_price ) ) return true;
+   if( bitasset.is_prediction_market ) return false;
+
+   // after #436 a call the feed protects ends check_call_orders() before any bid is looked at
+   bool feed_protected = ( settle_price > ~least_collateralized->call_price );
+   return !( feed_protected && head_block_time() > HARDFORK_436_TIME );
+}
+
+const call_order_object* database::find_least_collateralized_call( asset_id_type collateral, asset_id_type debt )const
+{
+   // the first call order of the market by price, read from the index every time so that undo can not leave it stale
+   const auto& call_price_index = get_index_type<call_order_index>().indices().get<by_price>();
+   auto call_itr = call_price_index.lower_bound( price::min( collateral, debt ) );
+   if( call_itr == call_price_index.end() || call_itr->call_price.base.asset_id != collateral
+       || call_itr->call_price.quote.asset_id != debt )
+      return nullptr;
+   return &*call_itr;
+}
+
 void database::pay_order( const account_object& receiver, const asset& receives, const asset& pays )
 {
    const auto& balances = receiver.statistics(*this);
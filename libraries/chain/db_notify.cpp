@@ -43,6 +43,7 @@
 #include <graphene/chain/impacted.hpp>
 #include <graphene/chain/hardfork.hpp>
 #include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/account_role_object.hpp>
 #include <graphene/chain/son_object.hpp>
 #include <graphene/chain/sidechain_address_object.hpp>
@@ -602,6 +603,12 @@ void get_relevant_accounts( const object* obj, flat_set<account_id_type>& accoun
               break;
              case impl_nft_lottery_balance_object_type:
               break;
+             case impl_lottery_ticket_purchase_object_type:{
+              const auto& aobj = dynamic_cast<const lottery_ticket_purchase_object*>(obj);
+              assert( aobj != nullptr );
+              accounts.insert( aobj->buyer );
+              break;
+           }
             default:
               break;
       }
@@ -629,12 +636,13 @@ void database::notify_changed_objects()
       // New
       if( !new_objects.empty() )
       {
-        vector<object_id_type> new_ids;  new_ids.reserve(head_undo.new_ids.size());
+        // newest first, the order the undo state used to keep them in
+        vector<object_id_type> new_ids = head_undo.new_ids.sorted_ids();
+        std::reverse( new_ids.begin(), new_ids.end() );
         flat_set<account_id_type> new_accounts_impacted;
-        for( const auto& item : head_undo.new_ids )
+        for( const auto& id : new_ids )
         {
-          new_ids.push_back(item);
-          auto obj = find_object(item);
+          auto obj = find_object(id);
           if(obj != nullptr)
             get_relevant_accounts(obj, new_accounts_impacted, true);
         }
@@ -645,13 +653,10 @@ void database::notify_changed_objects()
       // Changed
       if( !changed_objects.empty() )
       {
-        vector<object_id_type> changed_ids;  changed_ids.reserve(head_undo.old_values.size());
+        vector<object_id_type> changed_ids = head_undo.old_values.sorted_ids();
         flat_set<account_id_type> changed_accounts_impacted;
-        for( const auto& item : head_undo.old_values )
-        {
-          changed_ids.push_back(item.first);
-          get_relevant_accounts(item.second.get(), changed_accounts_impacted, true);
-        }
+        for( const auto& id : changed_ids )
+          get_relevant_accounts(head_undo.old_values.find(id)->get(), changed_accounts_impacted, true);
 
         GRAPHENE_TRY_NOTIFY( changed_objects, changed_ids, changed_accounts_impacted)
       }
@@ -659,13 +664,12 @@ void database::notify_changed_objects()
       // Removed
       if( !removed_objects.empty() )
       {
-        vector<object_id_type> removed_ids; removed_ids.reserve( head_undo.removed.size() );
-        vector<const object*> removed; removed.reserve( head_undo.removed.size() );
+        vector<object_id_type> removed_ids = head_undo.removed.sorted_ids();
+        vector<const object*> removed; removed.reserve( removed_ids.size() );
         flat_set<account_id_type> removed_accounts_impacted;
-        for( const auto& item : head_undo.removed )
+        for( const auto& id : removed_ids )
         {
-          removed_ids.emplace_back( item.first );
-          auto obj = item.second.get();
+          auto obj = head_undo.removed.find( id )->get();
           removed.emplace_back( obj );
           get_relevant_accounts(obj, removed_accounts_impacted, true);
         }
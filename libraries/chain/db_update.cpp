@@ -584,17 +584,36 @@ void process_finished_matches(database& db)
 {
 }
 
-void process_in_progress_tournaments(database& db)
+void process_in_progress_tournaments(database& db, tournament_due_index& due_index)
 {
-   auto& start_time_index = db.get_index_type<tournament_index>().indices().get<by_start_time>();
-   auto start_iter = start_time_index.lower_bound(boost::make_tuple(tournament_state::in_progress));
-   while (start_iter != start_time_index.end() &&
-          start_iter->get_state() == tournament_state::in_progress)
+   if (due_index.full_scan_pending)
+   {
+      // changes made before the index existed (e.g. before a restart) are unknown, so check every tournament once
+      auto& start_time_index = db.get_index_type<tournament_index>().indices().get<by_start_time>();
+      auto start_iter = start_time_index.lower_bound(boost::make_tuple(tournament_state::in_progress));
+      while (start_iter != start_time_index.end() &&
+             start_iter->get_state() == tournament_state::in_progress)
+      {
+         due_index.due_tournaments.insert(start_iter->id);
+         ++start_iter;
+      }
+      due_index.full_scan_pending = false;
+   }
+
+   // Only a change to one of its matches can give a tournament a new match to start, and checking a
+   // tournament again without such a change would not modify anything
+   flat_set<tournament_id_type> due_tournaments;
+   std::swap(due_tournaments, due_index.due_tournaments);
+   due_index.checked_tournaments = due_tournaments.size();
+   for (const tournament_id_type& tournament_id : due_tournaments)
    {
-      auto next_iter = std::next(start_iter);
-      start_iter->check_for_new_matches_to_start(db);
-      start_iter = next_iter;
+      const tournament_object* tournament = db.find(tournament_id);
+      if (tournament && tournament->get_state() == tournament_state::in_progress)
+         tournament->check_for_new_matches_to_start(db);
    }
+   // the check rewrites matches of the tournament being checked, which must not make it due again
+   for (const tournament_id_type& tournament_id : due_tournaments)
+      due_index.due_tournaments.erase(tournament_id);
 }
 
 void cancel_expired_tournaments(database& db)
@@ -677,7 +696,7 @@ void database::update_tournaments()
    process_finished_matches(*this);
    cancel_expired_tournaments(*this);
    start_fully_registered_tournaments(*this);
-   process_in_progress_tournaments(*this);
+   process_in_progress_tournaments(*this, *_tournament_due_index);
    initiate_next_round_of_matches(*this);
    initiate_next_games(*this);
 }
@@ -409,6 +409,25 @@ namespace graphene { namespace chain {
          vector< vector< map< asset_id_type, const account_balance_object* > > > balances;
          std::stack< object_id_type > ids_being_modified;
    };
+
+   /**
+    *  @brief Keeps the number of accounts holding a non-zero balance of each asset
+    */
+   class asset_holders_count_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void about_to_modify( const object& before ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         uint64_t get_holders_count( const asset_id_type& asset )const;
+
+      private:
+         /** Maps each asset to the number of its non-zero balances */
+         flat_map< asset_id_type, uint64_t > holders_count;
+         std::stack< bool > held_before_modify;
+   };
    
    struct by_asset_balance;
    struct by_maintenance_flag;
@@ -134,7 +134,6 @@ namespace graphene { namespace chain {
          optional<lottery_asset_options> lottery_options;
          time_point_sec get_lottery_expiration() const;
          vector<account_id_type> get_holders( database& db ) const;
-         vector<uint64_t> get_ticket_ids( database& db ) const;
          void distribute_benefactors_part( database& db );
          map< account_id_type, vector< uint16_t > > distribute_winners_part( database& db );
          void distribute_sweeps_holders_part( database& db );
@@ -480,6 +479,55 @@ namespace graphene { namespace chain {
     */
    typedef generic_index<lottery_balance_object, lottery_balance_index_type> lottery_balance_index;
 
+   /**
+    * @brief A purchase of tickets of an active lottery
+    * @ingroup object
+    *
+    * Created by the ticket purchase evaluator and removed when the lottery ends. The purchases of a buyer
+    * cover consecutive ranges of the tickets that buyer bought from the lottery, so the purchase of a ticket
+    * is found without going through the buyer's account history.
+    */
+   class lottery_ticket_purchase_object : public abstract_object<lottery_ticket_purchase_object>
+   {
+      public:
+         static const uint8_t space_id = implementation_ids;
+         static const uint8_t type_id  = impl_lottery_ticket_purchase_object_type;
+
+         asset_id_type   lottery;
+         account_id_type buyer;
+         uint64_t        tickets = 0;
+         /// number of tickets of the lottery the buyer purchased before this purchase
+         uint64_t        buyer_tickets_before = 0;
+         /// block the purchase was applied in
+         uint32_t        block_num = 0;
+
+         uint64_t buyer_tickets_after()const { return buyer_tickets_before + tickets; }
+   };
+
+   struct by_lottery_buyer;
+
+   /**
+    * @ingroup object_index
+    */
+   typedef multi_index_container<
+      lottery_ticket_purchase_object,
+      indexed_by<
+         ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+         ordered_unique< tag<by_lottery_buyer>,
+            composite_key< lottery_ticket_purchase_object,
+               member< lottery_ticket_purchase_object, asset_id_type, &lottery_ticket_purchase_object::lottery >,
+               member< lottery_ticket_purchase_object, account_id_type, &lottery_ticket_purchase_object::buyer >,
+               member< lottery_ticket_purchase_object, uint64_t, &lottery_ticket_purchase_object::buyer_tickets_before >
+            >
+         >
+      >
+   > lottery_ticket_purchase_index_type;
+
+   /**
+    * @ingroup object_index
+    */
+   typedef generic_index<lottery_ticket_purchase_object, lottery_ticket_purchase_index_type> lottery_ticket_purchase_index;
+
 
    class sweeps_vesting_balance_object : public abstract_object<sweeps_vesting_balance_object>
    {
@@ -565,6 +613,9 @@ FC_REFLECT_DERIVED( graphene::chain::asset_object, (graphene::db::object),
 FC_REFLECT_DERIVED( graphene::chain::lottery_balance_object, (graphene::db::object),
                     (lottery_id)(balance) )
 
+FC_REFLECT_DERIVED( graphene::chain::lottery_ticket_purchase_object, (graphene::db::object),
+                    (lottery)(buyer)(tickets)(buyer_tickets_before)(block_num) )
+
 FC_REFLECT_DERIVED( graphene::chain::sweeps_vesting_balance_object, (graphene::db::object),
                     (owner)(balance)(asset_id)(last_claim_date) )
 
@@ -575,5 +626,6 @@ GRAPHENE_EXTERNAL_SERIALIZATION( extern, graphene::chain::asset_dividend_data_ob
 GRAPHENE_EXTERNAL_SERIALIZATION( extern, graphene::chain::total_distributed_dividend_balance_object )
 GRAPHENE_EXTERNAL_SERIALIZATION( extern, graphene::chain::asset_object )
 GRAPHENE_EXTERNAL_SERIALIZATION( extern, graphene::chain::lottery_balance_object )
+GRAPHENE_EXTERNAL_SERIALIZATION( extern, graphene::chain::lottery_ticket_purchase_object )
 GRAPHENE_EXTERNAL_SERIALIZATION( extern, graphene::chain::sweeps_vesting_balance_object )
 
@@ -22,17 +22,59 @@
  * THE SOFTWARE.
  */
 #pragma once
-#include <fstream>
 #include <graphene/chain/protocol/block.hpp>
 
 #include <fc/filesystem.hpp>
 
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
 namespace graphene { namespace chain {
-   class index_entry;
 
+   /** codec a block is stored with in the block log */
+   enum class block_codec : uint8_t
+   {
+      raw  = 0, ///< plain fc::raw::pack output
+      zstd = 1  ///< zstd frame of the packed block, only available if built with zstd
+   };
+
+   /** fixed-width record of the index file, the entry for block N is stored at offset N * sizeof(index_entry) */
+   struct index_entry
+   {
+      /// the low 56 bits hold the offset into the blocks file, the top byte the block_codec
+      uint64_t      block_pos = 0;
+      uint32_t      block_size = 0;
+      block_id_type block_id;
+
+      static const uint64_t offset_mask = ( uint64_t(1) << 56 ) - 1;
+
+      uint64_t    offset()const { return block_pos & offset_mask; }
+      block_codec codec()const  { return block_codec( block_pos >> 56 ); }
+      void        set_position( uint64_t offset, block_codec codec )
+      {
+         block_pos = ( offset & offset_mask ) | ( uint64_t(codec) << 56 );
+      }
+   };
+
+   /**
+    *  @class block_database
+    *  @brief append-only block log with a fixed-width index by block number
+    *
+    *  The index file is memory mapped and block bodies are read with positional reads,
+    *  so fetching blocks does not seek a shared stream; only the copy of an index entry
+    *  is locked against the entry being rewritten. Every stored block is written right away unless
+    *  set_group_commit() allows them to be written in groups; flush() and close() write
+    *  whatever is pending.
+    */
    class block_database 
    {
       public:
+         block_database();
+         ~block_database();
+
          void open( const fc::path& dbdir );
          bool is_open()const;
          void flush();
@@ -49,12 +91,77 @@ namespace graphene { namespace chain {
          optional<block_id_type> last_id()const;
 	 
          void set_replay_mode(bool mode);
+
+         /**
+          *  Stored blocks are written once max_blocks of them or max_bytes of block data are pending,
+          *  set max_blocks to 1 to write every block immediately, which is the default.  Blocks pending
+          *  when the process crashes are lost, so groups are meant for rebuilding a log, not for a live node.
+          */
+         void set_group_commit( uint32_t max_blocks, uint32_t max_bytes );
+
+         /**
+          *  Selects the codec used for blocks stored from now on. Blocks already in the log keep
+          *  the codec they were written with, so raw and compressed blocks can coexist.
+          *
+          *  Storing the first compressed block renames the blocks file to blocks_v2, which versions
+          *  that can not decompress blocks fail to open instead of misreading it.  There is no way
+          *  back: a log holding compressed blocks can only be turned raw by copying it with copy_from().
+          */
+         void set_compression( block_codec codec );
+         static bool is_codec_supported( block_codec codec );
+
+         /**
+          *  Copies every block of src into this database, re-encoding it with the current codec.
+          *  @return the number of blocks copied
+          */
+         uint32_t copy_from( const block_database& src );
+
       private:
+         struct index_mapping;
+
          bool replay_mode = false;
 
-         optional<index_entry> last_index_entry()const;
+         optional<index_entry>  last_index_entry()const;
+         optional<index_entry>  read_index_entry( uint32_t block_num )const;
+         optional<signed_block> read_block( const index_entry& e )const;
+         void                   write_index_entries( const std::map<uint32_t, index_entry>& entries )const;
+         void                   map_index( uint64_t min_entries )const;
+         void                   commit_pending()const;
+         void                   use_compressed_blocks_file();
+
          fc::path _index_filename;
-         mutable std::fstream _blocks;
-         mutable std::fstream _block_num_to_pos;
+         fc::path _blocks_filename;
+         int      _blocks_fd = -1;
+         int      _index_fd  = -1;
+
+         /// number of complete entries in the index file, readers never look past it
+         mutable std::atomic<uint64_t>                    _index_entries;
+         /// current mapping of the index file, replaced mappings stay valid until close()
+         mutable std::atomic<const index_mapping*>        _index_map;
+         mutable std::vector< std::unique_ptr<index_mapping> > _mappings;
+
+         /// stored blocks not yet written, guarded by _pending_mutex
+         mutable std::mutex                               _pending_mutex;
+         mutable std::atomic<bool>                        _has_pending;
+         mutable std::vector<char>                        _pending_blocks;
+         mutable std::map<uint32_t, index_entry>          _pending_index;
+         /// size of the blocks file, pending blocks are appended after it
+         mutable uint64_t                                 _blocks_size = 0;
+
+         /// guards the index entries against being read through the mapping while they are rewritten
+         mutable std::mutex                               _index_mutex;
+
+         uint32_t _max_pending_blocks = 1;
+         uint32_t _max_pending_bytes  = 4 * 1024 * 1024;
+
+         block_codec _codec = block_codec::raw;
+
+         /// recently decompressed blocks, most recently used first, guarded by _cache_mutex
+         mutable std::mutex                                                  _cache_mutex;
+         mutable std::list< signed_block >                                   _decoded_blocks;
+         mutable std::map< block_id_type, std::list<signed_block>::iterator > _decoded_by_id;
+         static const size_t                                                 _max_decoded_blocks = 256;
    };
 } }
+
+FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) );
@@ -34,6 +34,7 @@
 #include <graphene/db/object_database.hpp>
 #include <graphene/db/object.hpp>
 #include <graphene/db/simple_index.hpp>
+#include <graphene/db/thread_pool.hpp>
 #include <fc/signals.hpp>
 
 #include <fc/crypto/hash_ctr_rng.hpp>
@@ -51,9 +52,25 @@ namespace graphene { namespace chain {
    using graphene::db::object;
    class op_evaluator;
    class transaction_evaluation_state;
+   class tournament_due_index;
+   class nft_lottery_due_index;
 
    struct budget_record;
 
+   /**
+    * How the last generated block was put together and where the time went
+    */
+   struct block_generation_stats
+   {
+      fc::microseconds assembly_time;   ///< collecting and applying pending transactions
+      fc::microseconds sealing_time;    ///< filling in and signing the block header
+      fc::microseconds push_time;       ///< applying the block as the new head
+      uint32_t         included_transactions = 0;
+      uint32_t         postponed_transactions = 0;
+      bool             reused_pending_state = false; ///< pending results were taken as is, not applied again
+      bool             time_budget_exceeded = false;
+   };
+
    /**
     *   @class database
     *   @brief tracks the blockchain state in an extensible manner
@@ -108,6 +125,13 @@ namespace graphene { namespace chain {
           */
          void reindex(fc::path data_dir);
 
+         /**
+          * @brief Configure how reindex() reads blocks ahead of applying them
+          * @param threads number of threads reading, unpacking and checking upcoming blocks, 0 to do it inline
+          * @param queue_depth number of blocks prepared per batch while the previous batch is applied
+          */
+         void set_replay_pipeline( uint32_t threads, uint32_t queue_depth );
+
          /**
           * @brief wipe Delete database from disk, and potentially the raw chain as well.
           * @param include_blocks If true, delete the raw chain as well as the database.
@@ -474,6 +498,13 @@ namespace graphene { namespace chain {
 
          bool check_call_orders( const asset_object& mia, bool enable_black_swan = true, bool for_new_limit_order = false,
                                  const asset_bitasset_data_object* bitasset_ptr = nullptr );
+         /**
+          * @return false if check_call_orders() is sure to neither margin call nor globally settle the asset,
+          * whatever the limit orders on the books
+          */
+         bool call_orders_may_trigger( const asset_object& mia );
+         /// @return the call order with the lowest call price among those borrowing debt against collateral, or nullptr
+         const call_order_object* find_least_collateralized_call( asset_id_type collateral, asset_id_type debt )const;
 
          // helpers to fill_order
          void pay_order( const account_object& receiver, const asset& receives, const asset& pays );
@@ -499,6 +530,30 @@ namespace graphene { namespace chain {
           */
          /// Enable or disable tracking of votes of standby witnesses and committee members
          inline void enable_standby_votes_tracking(bool enable)  { _track_standby_votes = enable; }
+         /**
+          * Recovers the keys that signed the given transactions on the signature thread pool and caches
+          * them in each transaction's signees, so that verify_authority() finds them ready. Transactions
+          * with invalid signatures are left alone and fail later when they are applied.
+          */
+         void precompute_signees( const vector<const signed_transaction*>& trxs )const;
+         /// Number of threads used by precompute_signees(), 0 to recover keys serially while applying
+         void set_signature_threads( uint32_t threads );
+         /**
+          * Number of threads tallying votes during chain maintenance, 0 to tally while visiting the accounts.
+          * With cross_check set, the votes are tallied both ways and a difference is logged and counted;
+          * the serial result is the one used.
+          */
+         void set_vote_tally_threads( uint32_t threads, bool cross_check = false );
+         /// Number of maintenances in which a cross-checked parallel vote tally differed from the serial one
+         uint32_t get_vote_tally_mismatches()const { return _vote_tally_mismatches; }
+         /// Select the codec used for blocks written to the block log from now on
+         void set_block_compression( block_codec codec ) { _block_id_to_block.set_compression( codec ); }
+         /**
+          * Limit the time generate_block() spends collecting pending transactions. The ones left out stay
+          * pending for a later block. Zero, the default, means no limit.
+          */
+         void set_block_assembly_time_budget( fc::microseconds budget ) { _block_assembly_time_budget = budget; }
+         const block_generation_stats& get_last_block_generation_stats()const { return _last_block_generation_stats; }
    protected:
          //Mark pop_undo() as protected -- we do not want outside calling pop_undo(); it should call pop_block() instead
          void pop_undo() { object_database::pop_undo(); }
@@ -581,7 +636,7 @@ namespace graphene { namespace chain {
             uint32_t get_gpos_current_subperiod();
 
          template<class Type>
-         void perform_account_maintenance(Type tally_helper);
+         void perform_account_maintenance(Type& tally_helper);
          ///@}
          ///@}
 
@@ -628,6 +683,19 @@ namespace graphene { namespace chain {
 
          fc::hash_ctr_rng<secret_hash_type, 20> _random_number_generator;
          bool                              _slow_replays = false;
+         uint32_t                          _replay_threads = 0;
+         uint32_t                          _replay_queue_depth = 1000;
+         std::unique_ptr<graphene::db::thread_pool> _signature_pool;
+         std::unique_ptr<graphene::db::thread_pool> _vote_tally_pool;
+         bool                              _vote_tally_cross_check = false;
+         uint32_t                          _vote_tally_mismatches = 0;
+
+         fc::microseconds                  _block_assembly_time_budget;
+         block_generation_stats            _last_block_generation_stats;
+         /// Index in _pending_tx of the first transaction applied in _pending_tx_session
+         size_t                            _pending_tx_session_base = 0;
+         /// Skip flags any transaction of _pending_tx_session was applied with
+         uint32_t                          _pending_tx_session_skip = 0;
 
          /**
           * Whether database is successfully opened or not.
@@ -649,6 +717,15 @@ namespace graphene { namespace chain {
          const chain_property_object*           _p_chain_property_obj      = nullptr;
          const witness_schedule_object*         _p_witness_schedule_obj    = nullptr;
          ///@}
+
+         /// Owned by the match index, feeds update_tournaments()
+         tournament_due_index*                  _tournament_due_index      = nullptr;
+
+         /// Owned by the NFT metadata and token indexes, feed check_ending_nft_lotteries()
+         ///@{
+         nft_lottery_due_index*                 _nft_metadata_due_index    = nullptr;
+         nft_lottery_due_index*                 _nft_token_due_index       = nullptr;
+         ///@}
    };
 
    namespace detail
@@ -76,6 +76,17 @@ struct pending_transactions_restorer
 
    ~pending_transactions_restorer()
    {
+      vector<const signed_transaction*> trxs;
+      trxs.reserve( _db._popped_tx.size() + _pending_transactions.size() );
+      for( const auto& tx : _db._popped_tx )
+         trxs.push_back( &tx );
+      for( const auto& tx : _pending_transactions )
+         trxs.push_back( &tx );
+      try {
+         _db.precompute_signees( trxs );
+      } catch( const fc::exception& ) {
+      }
+
       for( const auto& tx : _db._popped_tx )
       {
          try {
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <fc/exception/exception.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+/**
+ * Picks distinct numbers out of [minimum, maximum): each pick takes the number at a given position among the
+ * numbers not picked yet, in ascending order, just like erasing it from a vector holding the whole range.
+ *
+ * Only the picked numbers are stored, in a treap ordered by value that counts the picked numbers in each
+ * subtree, so a pick costs O(log k) expected time after k picks regardless of the size of the range.
+ */
+class distinct_number_picker
+{
+   public:
+      distinct_number_picker( uint64_t minimum, uint64_t maximum )
+         : _minimum( minimum ), _count( maximum > minimum ? maximum - minimum : 0 ) {}
+
+      /// Numbers left to pick
+      uint64_t remaining()const { return _count - _nodes.size(); }
+
+      /// Picks the number at position index (0 based) among the numbers not picked yet
+      uint64_t pick( uint64_t index )
+      {
+         FC_ASSERT( index < remaining() );
+         // count the picked numbers below the result on the way down; going right passes them
+         uint64_t picked_below = 0;
+         uint32_t n = _root;
+         while( n != none )
+         {
+            const node& current = _nodes[n];
+            const uint64_t free_below = current.value - _minimum - picked_below - size( current.left );
+            if( index < free_below )
+               n = current.left;
+            else
+            {
+               picked_below += size( current.left ) + 1;
+               n = current.right;
+            }
+         }
+         const uint64_t value = _minimum + index + picked_below;
+
+         // the tree shape does not affect the result, so the priorities only need to be well mixed
+         _seed ^= _seed << 13;
+         _seed ^= _seed >> 7;
+         _seed ^= _seed << 17;
+         _nodes.push_back( node{ value, _seed, none, none, 1 } );
+         uint32_t less, rest;
+         split( _root, value, less, rest );
+         _root = merge( merge( less, uint32_t( _nodes.size() - 1 ) ), rest );
+         return value;
+      }
+
+   private:
+      enum : uint32_t { none = 0xffffffff };
+
+      struct node
+      {
+         uint64_t value;
+         uint64_t priority;
+         uint32_t left;
+         uint32_t right;
+         uint32_t size;
+      };
+
+      uint32_t size( uint32_t n )const { return n == none ? 0 : _nodes[n].size; }
+
+      void update( uint32_t n )
+      {
+         _nodes[n].size = size( _nodes[n].left ) + size( _nodes[n].right ) + 1;
+      }
+
+      /// Splits the subtree at n into the numbers below value and the rest
+      void split( uint32_t n, uint64_t value, uint32_t& less, uint32_t& rest )
+      {
+         if( n == none )
+         {
+            less = rest = none;
+            return;
+         }
+         if( _nodes[n].value < value )
+         {
+            uint32_t right_less;
+            split( _nodes[n].right, value, right_less, rest );
+            _nodes[n].right = right_less;
+            less = n;
+         }
+         else
+         {
+            uint32_t left_rest;
+            split( _nodes[n].left, value, less, left_rest );
+            _nodes[n].left = left_rest;
+            rest = n;
+         }
+         update( n );
+      }
+
+      /// Joins two subtrees, all numbers in a being below those in b
+      uint32_t merge( uint32_t a, uint32_t b )
+      {
+         if( a == none )
+            return b;
+         if( b == none )
+            return a;
+         if( _nodes[a].priority > _nodes[b].priority )
+         {
+            const uint32_t right = merge( _nodes[a].right, b );
+            _nodes[a].right = right;
+            update( a );
+            return a;
+         }
+         const uint32_t left = merge( a, _nodes[b].left );
+         _nodes[b].left = left;
+         update( b );
+         return b;
+      }
+
+      uint64_t          _minimum;
+      uint64_t          _count;
+      std::vector<node> _nodes;
+      uint32_t          _root = none;
+      uint64_t          _seed = 0x9e3779b97f4a7c15ULL;
+};
+
+} } // graphene::chain
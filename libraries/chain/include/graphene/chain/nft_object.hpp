@@ -167,6 +167,30 @@ namespace graphene { namespace chain {
    >;
    using nft_index = generic_index<nft_object, nft_multi_index_type>;
 
+   /**
+    *  @brief Tracks the NFT lotteries that may have sold out.
+    *
+    *  Attached to both the token and the metadata index: a token being minted or removed (including by
+    *  undo) marks its lottery as due, and so does a change to the lottery itself, which covers a lottery
+    *  made active again by undo.  The per-block check for sold out lotteries then only visits the due ones
+    *  instead of counting the tokens of every active lottery.  The set is not persisted, so it starts out
+    *  requesting one full scan.
+    */
+   class nft_lottery_due_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         /// lotteries whose tokens or options changed since they were last checked
+         flat_set<nft_metadata_id_type> due_lotteries;
+         /// set until the first check after the index was created
+         bool full_scan_pending = true;
+      private:
+         void mark_due( const object& obj );
+   };
+
    using nft_lottery_balance_index_type = multi_index_container<
       nft_lottery_balance_object,
       indexed_by<
@@ -230,6 +230,12 @@ namespace graphene { namespace chain {
       vector<operation_result> operation_results;
 
       digest_type merkle_digest()const;
+
+      /// Size of the packed transaction; it is computed once, so the transaction must not change afterwards
+      size_t get_packed_size()const;
+
+   private:
+      mutable size_t _packed_size = 0;
    };
 
    /// @} transactions group
@@ -229,6 +229,29 @@ namespace graphene { namespace chain {
 
          flat_set<account_id_type> before_account_ids;
    };
+
+   /**
+    *  @brief Tracks the tournaments that may have a match to start.
+    *
+    *  Attached to the match index; any match being created, changed or removed (including by undo)
+    *  marks its tournament as due, so the per-block tournament processing only visits tournaments
+    *  whose matches changed instead of every tournament in progress.  The set is not persisted, so
+    *  it starts out requesting one full scan.
+    */
+   class tournament_due_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         /// tournaments with a match changed since they were last checked
+         flat_set<tournament_id_type> due_tournaments;
+         /// set until the first check after the index was created
+         bool full_scan_pending = true;
+         /// number of tournaments checked on the last block
+         uint32_t checked_tournaments = 0;
+   };
 } }
 
 FC_REFLECT_DERIVED(graphene::chain::tournament_details_object, (graphene::db::object),
@@ -60,6 +60,24 @@ void_result ticket_purchase_evaluator::do_apply( const ticket_purchase_operation
    db().modify( *asset_dynamic_data, [&]( asset_dynamic_data_object& data ){
       data.current_supply += op.tickets_to_buy;
    });
+
+   const auto& purchases = db().get_index_type<lottery_ticket_purchase_index>().indices().get<by_lottery_buyer>();
+   uint64_t tickets_before = 0;
+   auto last_purchase = purchases.upper_bound( boost::make_tuple( op.lottery, op.buyer ) );
+   if( last_purchase != purchases.begin() )
+   {
+      --last_purchase;
+      if( last_purchase->lottery == op.lottery && last_purchase->buyer == op.buyer )
+         tickets_before = last_purchase->buyer_tickets_after();
+   }
+   db().create<lottery_ticket_purchase_object>( [&]( lottery_ticket_purchase_object& purchase ) {
+      purchase.lottery = op.lottery;
+      purchase.buyer = op.buyer;
+      purchase.tickets = op.tickets_to_buy;
+      purchase.buyer_tickets_before = tickets_before;
+      purchase.block_num = db().head_block_num() + 1;
+   });
+
    db().check_lottery_end_by_participants( op.lottery );
    return void_result();
 } FC_CAPTURE_AND_RETHROW( (op) ) }
@@ -109,6 +127,15 @@ void_result lottery_end_evaluator::do_apply( const lottery_end_operation& op )
    db().modify( *lottery, [](asset_object& ao) {
       ao.lottery_options->is_active = false;
    });
+
+   const auto& purchases = db().get_index_type<lottery_ticket_purchase_index>().indices().get<by_lottery_buyer>();
+   auto purchase_itr = purchases.lower_bound( boost::make_tuple( op.lottery ) );
+   while( purchase_itr != purchases.end() && purchase_itr->lottery == op.lottery )
+   {
+      const lottery_ticket_purchase_object& purchase = *purchase_itr;
+      ++purchase_itr;
+      db().remove( purchase );
+   }
    return void_result();
 } FC_CAPTURE_AND_RETHROW( (op) ) }
 
@@ -167,5 +167,28 @@ namespace graphene
             end_op.lottery_id = get_id();
             db.apply_operation(eval, end_op);
         }
+
+        void nft_lottery_due_index::mark_due(const object &obj)
+        {
+            if (obj.id.type() == nft_object_type)
+                due_lotteries.insert(static_cast<const nft_object &>(obj).nft_metadata_id);
+            else if (static_cast<const nft_metadata_object &>(obj).is_lottery())
+                due_lotteries.insert(nft_metadata_id_type(obj.id));
+        }
+
+        void nft_lottery_due_index::object_inserted(const object &obj)
+        {
+            mark_due(obj);
+        }
+
+        void nft_lottery_due_index::object_removed(const object &obj)
+        {
+            mark_due(obj);
+        }
+
+        void nft_lottery_due_index::object_modified(const object &after)
+        {
+            mark_due(after);
+        }
     } // namespace chain
 } // namespace graphene
@@ -37,6 +37,13 @@ digest_type processed_transaction::merkle_digest()const
    return enc.result();
 }
 
+size_t processed_transaction::get_packed_size()const
+{
+   if( _packed_size == 0 )
+      _packed_size = fc::raw::pack_size( *this );
+   return _packed_size;
+}
+
 digest_type transaction::digest()const
 {
    digest_type::encoder enc;
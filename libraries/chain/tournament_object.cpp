@@ -653,6 +653,24 @@ namespace graphene { namespace chain {
    }
 
 
+   void tournament_due_index::object_inserted(const object& obj)
+   {
+      assert( dynamic_cast<const match_object*>(&obj) ); // for debug only
+      due_tournaments.insert(static_cast<const match_object&>(obj).tournament_id);
+   }
+
+   void tournament_due_index::object_removed(const object& obj)
+   {
+      assert( dynamic_cast<const match_object*>(&obj) ); // for debug only
+      due_tournaments.insert(static_cast<const match_object&>(obj).tournament_id);
+   }
+
+   void tournament_due_index::object_modified(const object& after)
+   {
+      assert( dynamic_cast<const match_object*>(&after) ); // for debug only
+      due_tournaments.insert(static_cast<const match_object&>(after).tournament_id);
+   }
+
    vector<tournament_id_type> tournament_players_index::get_registered_tournaments_for_account( const account_id_type& a )const
    {
       auto iter = account_to_joined_tournaments.find(a);
@@ -98,6 +98,16 @@ namespace graphene { namespace db {
          virtual void open( const fc::path& db ) = 0;
          virtual void save( const fc::path& db ) = 0;
 
+         /**
+          *  Splits open() in two phases. stage_open() decodes the file into a staging area without
+          *  touching the index or any shared state, so that the files of different indexes can be
+          *  decoded concurrently. finish_open() then inserts the staged objects into the index.
+          *
+          *  @return the number of objects inserted by finish_open()
+          */
+         virtual void   stage_open( const fc::path& db ) = 0;
+         virtual size_t finish_open() = 0;
+
 
 
          /** @return the object with id or nullptr if not found */
@@ -343,22 +353,49 @@ namespace graphene { namespace db {
          }
 
          virtual void open( const path& db )override
-         { 
+         {
+            stage_open( db );
+            finish_open();
+         }
+
+         virtual void stage_open( const path& db )override
+         {
+            _staged_objects.clear();
+            _staged_next_id.reset();
             if( !fc::exists( db ) ) return;
             fc::file_mapping fm( db.generic_string().c_str(), fc::read_only );
             fc::mapped_region mr( fm, fc::read_only, 0, fc::file_size(db) );
             fc::datastream<const char*> ds( (const char*)mr.get_address(), mr.get_size() );
             fc::sha256 open_ver;
+            object_id_type next_id;
 
-            fc::raw::unpack(ds, _next_id);
+            fc::raw::unpack(ds, next_id);
             fc::raw::unpack(ds, open_ver);
             FC_ASSERT( open_ver == get_object_version(), "Incompatible Version, the serialization of objects in this index has changed" );
             vector<char> tmp;
             while( ds.remaining() > 0 ) 
             {
                fc::raw::unpack( ds, tmp );
-               load( tmp );
+               _staged_objects.emplace_back( fc::raw::unpack<object_type>( tmp ) );
             }
+            _staged_next_id = next_id;
+         }
+
+         virtual size_t finish_open()override
+         {
+            if( _staged_next_id.valid() )
+               _next_id = *_staged_next_id;
+            const size_t count = _staged_objects.size();
+            for( auto& obj : _staged_objects )
+            {
+               const auto& result = DerivedIndex::insert( std::move( obj ) );
+               for( const auto& item : _sindex )
+                  item->object_inserted( result );
+            }
+            _staged_objects.clear();
+            _staged_objects.shrink_to_fit();
+            _staged_next_id.reset();
+            return count;
          }
 
          virtual void save( const path& db ) override 
@@ -384,6 +421,15 @@ namespace graphene { namespace db {
             return result;
          }
 
+         /** puts back an object that was removed, as undo does, so secondary indexes have to hear of it as well */
+         virtual const object&  insert( object&& obj )override
+         {
+            const auto& result = DerivedIndex::insert( std::move( obj ) );
+            for( const auto& item : _sindex )
+               item->object_inserted( result );
+            return result;
+         }
+
 
          virtual const object&  create(const std::function<void(object&)>& constructor )override
          {
@@ -439,6 +485,10 @@ namespace graphene { namespace db {
       private:
          object_id_type                                 _next_id;
          const direct_index< object_type, DirectBits >* _direct_by_id = nullptr;
+
+         /// filled by stage_open(), consumed by finish_open()
+         vector< object_type >                          _staged_objects;
+         fc::optional< object_id_type >                 _staged_next_id;
    };
 
 } } // graphene::db
@@ -28,10 +28,26 @@
 
 #include <fc/log/logger.hpp>
 
+#include <array>
+#include <bitset>
 #include <map>
 
 namespace graphene { namespace db {
 
+   /**
+    *  @brief describes the snapshot currently stored in the object_database directory
+    *
+    *  A snapshot consists of a full base (one file per index) plus an ordered list
+    *  of deltas. Each delta directory only contains the indexes that were modified
+    *  since the previous checkpoint; when opening, the most recent copy of every
+    *  index wins.
+    */
+   struct object_database_manifest
+   {
+      uint32_t              block_num = 0;  ///< head block the snapshot was taken at, 0 if unknown
+      std::vector<uint32_t> deltas;         ///< delta directories to apply on top of the base, oldest first
+   };
+
    /**
     *   @class object_database
     *   @brief maintains a set of indexed objects that can be modified with multi-level rollback support
@@ -47,9 +63,27 @@ namespace graphene { namespace db {
          void open(const fc::path& data_dir );
 
          /**
-          * Saves the complete state of the object_database to disk, this could take a while
+          * Saves the state of the object_database to disk. If incremental snapshots are enabled
+          * and a consistent base exists, only the indexes modified since the last checkpoint are
+          * written, otherwise the complete state is rewritten, which could take a while.
+          *
+          * @param block_num the head block the state corresponds to, recorded in the manifest
+          */
+         void flush( uint32_t block_num = 0 );
+
+         /**
+          * @param max_deltas number of incremental snapshots allowed on top of a full base before
+          *        the next flush() rewrites everything; 0 disables incremental snapshots
+          * @param threads number of worker threads used to serialize indexes, 0 to use the caller's thread
           */
-         void flush();
+         void set_snapshot_options( uint32_t max_deltas, uint32_t threads );
+
+         /** @param threads number of worker threads used by open() to decode index files, 0 to use the caller's thread */
+         void set_load_threads( uint32_t threads );
+
+         /** @return the block number recorded in the manifest of the snapshot that was opened or last written */
+         uint32_t get_snapshot_block_num()const { return _manifest.block_num; }
+
          void wipe(const fc::path& data_dir); // remove from disk
          void close();
 
@@ -84,7 +118,7 @@ namespace graphene { namespace db {
          /// in order to maintain proper undo history.
          ///@{
 
-         const object& insert( object&& obj ) { return get_mutable_index(obj.id).insert( std::move(obj) ); }
+         const object& insert( object&& obj ) { mark_dirty( obj.id ); return get_mutable_index(obj.id).insert( std::move(obj) ); }
          void          remove( const object& obj ) { get_mutable_index(obj.id).remove( obj ); }
          template<typename T, typename Lambda>
          void modify( const T& obj, const Lambda& m ) {
@@ -164,10 +198,24 @@ namespace graphene { namespace db {
          void save_undo_add( const object& obj );
          void save_undo_remove( const object& obj );
 
+         void mark_dirty( object_id_type id ) { _dirty_indexes[id.space()].set( id.type() ); }
+         void clear_dirty();
+         size_t save_indexes( const fc::path& dir, bool dirty_only );
+
          fc::path                                                  _data_dir;
          vector< vector< unique_ptr<index> > >                     _index;
+
+         object_database_manifest                                  _manifest;
+         /// true if the files on disk plus _dirty_indexes describe the current state
+         bool                                                      _snapshot_valid = false;
+         uint32_t                                                  _snapshot_max_deltas = 0;
+         uint32_t                                                  _snapshot_threads = 0;
+         uint32_t                                                  _load_threads = 0;
+         std::array< std::bitset<256>, 256 >                       _dirty_indexes;
    };
 
 } } // graphene::db
 
+FC_REFLECT( graphene::db::object_database_manifest, (block_num)(deltas) )
+
 
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   /**
+    * @class thread_pool
+    * @brief a fixed set of threads that independent jobs can be fanned out to
+    *
+    * run() blocks the calling thread without yielding to the fc scheduler, so no other fc task
+    * can be interleaved with the caller; it is safe to use in the middle of applying a block.
+    * A pool of size 0 runs every job inline on the calling thread.
+    */
+   class thread_pool
+   {
+      public:
+         explicit thread_pool( uint32_t num_threads );
+         ~thread_pool();
+
+         uint32_t size()const { return _threads.size(); }
+
+         /**
+          *  Calls job(i) for every i in [0,count), distributing the calls across the
+          *  threads of the pool, and blocks until all of them are done. Jobs are handed
+          *  out in ascending order, so callers should sort the most expensive ones first.
+          *  If a job throws, the thread that ran it stops picking up new jobs and the
+          *  first exception is rethrown once all threads have returned.
+          */
+         void run( size_t count, const std::function<void(size_t)>& job );
+
+      private:
+         void worker_loop();
+
+         std::vector<std::thread>            _threads;
+         std::mutex                          _run_mutex;
+
+         std::mutex                          _mutex;
+         std::condition_variable             _work_ready;
+         std::condition_variable             _work_done;
+         const std::function<void(size_t)>*  _job = nullptr;
+         size_t                              _count = 0;
+         std::atomic<size_t>                 _next;
+         size_t                              _active = 0;
+         uint64_t                            _generation = 0;
+         bool                                _stopping = false;
+         std::exception_ptr                  _error;
+   };
+
+} } // graphene::db
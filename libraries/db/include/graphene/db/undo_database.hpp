@@ -23,7 +23,9 @@
  */
 #pragma once
 #include <graphene/db/object.hpp>
+#include <algorithm>
 #include <deque>
+#include <vector>
 #include <fc/exception/exception.hpp>
 
 namespace graphene { namespace db {
@@ -32,12 +34,183 @@ namespace graphene { namespace db {
    using fc::flat_set;
    class object_database;
 
+   /**
+    * @brief map from object id to V, stored in one flat vector plus an open addressing index
+    *
+    * Entries are kept in insertion order and never move while a session records changes; erasing
+    * leaves a tombstone that iteration skips. Compared to a node based map this costs two amortized
+    * allocations per state instead of one per entry, and whole maps can be moved between states.
+    * Where the order of the entries can be observed, walk them by sorted_ids() instead.
+    */
+   template<typename V>
+   class flat_undo_map
+   {
+      public:
+         struct entry
+         {
+            entry( object_id_type i, V&& v ) : first( i ), second( std::move(v) ) {}
+            object_id_type first;
+            V              second;
+         };
+
+         template<typename Entry, typename Map>
+         class iterator_base
+         {
+            public:
+               iterator_base( Map& m, size_t pos ) : _map( m ), _pos( pos ) { skip(); }
+               Entry& operator*()const  { return _map._entries[_pos]; }
+               Entry* operator->()const { return &_map._entries[_pos]; }
+               iterator_base& operator++() { ++_pos; skip(); return *this; }
+               bool operator==( const iterator_base& o )const { return _pos == o._pos; }
+               bool operator!=( const iterator_base& o )const { return _pos != o._pos; }
+            private:
+               void skip() { while( _pos < _map._entries.size() && _map._erased[_pos] ) ++_pos; }
+               Map&   _map;
+               size_t _pos;
+         };
+         typedef iterator_base<entry, flat_undo_map>                   iterator;
+         typedef iterator_base<const entry, const flat_undo_map>       const_iterator;
+
+         iterator       begin()       { return iterator( *this, 0 ); }
+         iterator       end()         { return iterator( *this, _entries.size() ); }
+         const_iterator begin()const  { return const_iterator( *this, 0 ); }
+         const_iterator end()const    { return const_iterator( *this, _entries.size() ); }
+
+         size_t size()const  { return _live; }
+         bool   empty()const { return _live == 0; }
+
+         V* find( object_id_type id )
+         {
+            const size_t slot = find_slot( id );
+            return slot == npos ? nullptr : &_entries[_slots[slot] - 1].second;
+         }
+         const V* find( object_id_type id )const { return const_cast<flat_undo_map*>(this)->find( id ); }
+         bool contains( object_id_type id )const { return find_slot( id ) != npos; }
+
+         /** like std::map::emplace, value is dropped if id is contained already
+          *  @return the value stored for id */
+         V& insert( object_id_type id, V&& value )
+         {
+            if( V* existing = find( id ) )
+               return *existing;
+            if( ( _used_slots + 1 ) * 4 > _slots.size() * 3 )
+               rehash( std::max<size_t>( 16, _live * 4 ) );
+            _entries.emplace_back( id, std::move(value) );
+            _erased.push_back( false );
+            size_t slot = home_slot( id );
+            while( _slots[slot] != empty_slot && _slots[slot] != erased_slot )
+               slot = ( slot + 1 ) & ( _slots.size() - 1 );
+            if( _slots[slot] == empty_slot )
+               ++_used_slots;
+            _slots[slot] = _entries.size();
+            ++_live;
+            return _entries.back().second;
+         }
+
+         /** @return true if id was contained */
+         bool erase( object_id_type id )
+         {
+            const size_t slot = find_slot( id );
+            if( slot == npos )
+               return false;
+            _erased[_slots[slot] - 1] = true;
+            _slots[slot] = erased_slot;
+            --_live;
+            return true;
+         }
+
+         /** ids of all entries in ascending order */
+         std::vector<object_id_type> sorted_ids()const
+         {
+            std::vector<object_id_type> ids;
+            ids.reserve( _live );
+            for( const auto& item : *this )
+               ids.push_back( item.first );
+            std::sort( ids.begin(), ids.end() );
+            return ids;
+         }
+
+         void clear()
+         {
+            _entries.clear();
+            _erased.clear();
+            _slots.clear();
+            _live = 0;
+            _used_slots = 0;
+         }
+
+      private:
+         static const size_t npos = size_t(-1);
+         enum : uint32_t { empty_slot = 0, erased_slot = 0xffffffff };
+
+         size_t home_slot( object_id_type id )const
+         {
+            // fibonacci hashing spreads the instance, space and type bits over the table
+            return size_t( ( id.number * 0x9E3779B97F4A7C15ull ) >> 32 ) & ( _slots.size() - 1 );
+         }
+
+         size_t find_slot( object_id_type id )const
+         {
+            if( _slots.empty() )
+               return npos;
+            size_t slot = home_slot( id );
+            while( _slots[slot] != empty_slot )
+            {
+               if( _slots[slot] != erased_slot && _entries[_slots[slot] - 1].first == id )
+                  return slot;
+               slot = ( slot + 1 ) & ( _slots.size() - 1 );
+            }
+            return npos;
+         }
+
+         /// rebuilds the index for at least min_slots slots and drops tombstones
+         void rehash( size_t min_slots )
+         {
+            size_t slots = 16;
+            while( slots < min_slots )
+               slots *= 2;
+            if( _live != _entries.size() )
+            {
+               size_t out = 0;
+               for( size_t in = 0; in < _entries.size(); ++in )
+                  if( !_erased[in] )
+                  {
+                     if( out != in )
+                        _entries[out] = std::move( _entries[in] );
+                     ++out;
+                  }
+               _entries.erase( _entries.begin() + out, _entries.end() );
+               _erased.assign( out, false );
+            }
+            _slots.assign( slots, empty_slot );
+            for( size_t i = 0; i < _entries.size(); ++i )
+            {
+               size_t slot = home_slot( _entries[i].first );
+               while( _slots[slot] != empty_slot )
+                  slot = ( slot + 1 ) & ( slots - 1 );
+               _slots[slot] = i + 1;
+            }
+            _used_slots = _entries.size();
+         }
+
+         std::vector<entry>    _entries;
+         std::vector<bool>     _erased;
+         std::vector<uint32_t> _slots;
+         size_t                _live = 0;
+         size_t                _used_slots = 0;
+   };
+
    struct undo_state
    {
-      unordered_map<object_id_type, unique_ptr<object> >       old_values;
-      unordered_map<object_id_type, object_id_type>            old_index_next_ids;
-      std::set<object_id_type, std::greater<object_id_type> >  new_ids;
-      unordered_map<object_id_type, unique_ptr<object> >       removed;
+      flat_undo_map< unique_ptr<object> >  old_values;
+      flat_undo_map< object_id_type >      old_index_next_ids;
+      flat_undo_map< bool >                new_ids;
+      flat_undo_map< unique_ptr<object> >  removed;
+
+      bool empty()const
+      {
+         return old_values.empty() && old_index_next_ids.empty() && new_ids.empty() && removed.empty();
+      }
    };
 
 
@@ -126,6 +299,8 @@ namespace graphene { namespace db {
          void undo();
          void merge();
          void commit();
+         /// reverts the database to the contents recorded in state
+         void restore( undo_state& state );
 
          uint32_t                _active_sessions = 0;
          bool                    _disabled = true;
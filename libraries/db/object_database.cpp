@@ -22,13 +22,54 @@
  * THE SOFTWARE.
  */
 #include <graphene/db/object_database.hpp>
+#include <graphene/db/thread_pool.hpp>
 
 #include <fc/io/raw.hpp>
+#include <fc/io/fstream.hpp>
 #include <fc/container/flat.hpp>
 #include <fc/uint128.hpp>
 
+#include <algorithm>
+#include <fstream>
+
 namespace graphene { namespace db {
 
+namespace {
+
+   fc::path delta_path( const fc::path& db_dir, uint32_t delta )
+   {
+      return db_dir / ( "delta." + fc::to_string( uint64_t(delta) ) );
+   }
+
+   void write_manifest( const fc::path& db_dir, const object_database_manifest& manifest )
+   {
+      const auto packed = fc::raw::pack( manifest );
+      {
+         std::ofstream out( (db_dir / "manifest.tmp").generic_string(),
+                            std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+         FC_ASSERT( out );
+         out.write( packed.data(), packed.size() );
+         out.flush();
+         FC_ASSERT( out, "Unable to write object_database manifest" );
+      }
+      // the rename is what commits a delta, anything not listed in the manifest is ignored
+      fc::rename( db_dir / "manifest.tmp", db_dir / "manifest" );
+   }
+
+   object_database_manifest read_manifest( const fc::path& db_dir )
+   {
+      object_database_manifest result;
+      if( !fc::exists( db_dir / "manifest" ) )
+         return result;
+      std::string data;
+      fc::read_file_contents( db_dir / "manifest", data );
+      fc::datastream<const char*> ds( data.data(), data.size() );
+      fc::raw::unpack( ds, result );
+      return result;
+   }
+
+}
+
 object_database::object_database()
 :_undo_db(*this)
 {
@@ -68,29 +109,95 @@ index& object_database::get_mutable_index(uint8_t space_id, uint8_t type_id)
    return *idx;
 }
 
-void object_database::flush()
+void object_database::set_snapshot_options( uint32_t max_deltas, uint32_t threads )
 {
-//   ilog("Save object_database in ${d}", ("d", _data_dir));
-   fc::create_directories( _data_dir / "object_database.tmp" / "lock" );
+   _snapshot_max_deltas = max_deltas;
+   _snapshot_threads = threads;
+}
+
+void object_database::set_load_threads( uint32_t threads )
+{
+   _load_threads = threads;
+}
+
+void object_database::clear_dirty()
+{
+   for( auto& space : _dirty_indexes )
+      space.reset();
+}
+
+size_t object_database::save_indexes( const fc::path& dir, bool dirty_only )
+{
+   vector<index*> to_save;
    for( uint32_t space = 0; space < _index.size(); ++space )
    {
-      fc::create_directories( _data_dir / "object_database.tmp" / fc::to_string(space) );
+      if( !dirty_only )
+         fc::create_directories( dir / fc::to_string(space) );
       const auto types = _index[space].size();
       for( uint32_t type = 0; type  <  types; ++type )
-         if( _index[space][type] )
-            _index[space][type]->save( _data_dir / "object_database.tmp" / fc::to_string(space)/fc::to_string(type) );
+         if( _index[space][type] && ( !dirty_only || _dirty_indexes[space].test(type) ) )
+            to_save.push_back( _index[space][type].get() );
+   }
+   if( dirty_only )
+      for( const index* idx : to_save )
+         fc::create_directories( dir / fc::to_string(idx->object_space_id()) );
+
+   // indexes are independent of each other, and nothing modifies them while we wait here
+   thread_pool pool( std::min<size_t>( _snapshot_threads, to_save.size() ) );
+   pool.run( to_save.size(), [&to_save,&dir]( size_t i ) {
+      index* idx = to_save[i];
+      idx->save( dir / fc::to_string(idx->object_space_id()) / fc::to_string(idx->object_type_id()) );
+   });
+   return to_save.size();
+}
+
+void object_database::flush( uint32_t block_num )
+{
+//   ilog("Save object_database in ${d}", ("d", _data_dir));
+   const auto start = fc::time_point::now();
+   const fc::path db_dir = _data_dir / "object_database";
+   object_database_manifest manifest;
+   manifest.block_num = block_num;
+
+   if( _snapshot_valid && _manifest.deltas.size() < _snapshot_max_deltas && fc::exists( db_dir ) )
+   {
+      manifest.deltas = _manifest.deltas;
+      const uint32_t delta = manifest.deltas.empty() ? 1 : manifest.deltas.back() + 1;
+      // a directory with this number can only be left over from an interrupted flush
+      fc::remove_all( delta_path( db_dir, delta ) );
+      fc::create_directories( delta_path( db_dir, delta ) );
+      const size_t written = save_indexes( delta_path( db_dir, delta ), true );
+      manifest.deltas.push_back( delta );
+      write_manifest( db_dir, manifest );
+      ilog( "Wrote object_database delta ${n} with ${c} modified indexes in ${t} ms",
+            ("n",delta)("c",written)("t",(fc::time_point::now() - start).count() / 1000) );
    }
-   fc::remove_all( _data_dir / "object_database.tmp" / "lock" );
-   if( fc::exists( _data_dir / "object_database" ) )
-      fc::rename( _data_dir / "object_database", _data_dir / "object_database.old" );
-   fc::rename( _data_dir / "object_database.tmp", _data_dir / "object_database" );
-   fc::remove_all( _data_dir / "object_database.old" );
+   else
+   {
+      _snapshot_valid = false;
+      fc::create_directories( _data_dir / "object_database.tmp" / "lock" );
+      const size_t written = save_indexes( _data_dir / "object_database.tmp", false );
+      write_manifest( _data_dir / "object_database.tmp", manifest );
+      fc::remove_all( _data_dir / "object_database.tmp" / "lock" );
+      if( fc::exists( db_dir ) )
+         fc::rename( db_dir, _data_dir / "object_database.old" );
+      fc::rename( _data_dir / "object_database.tmp", db_dir );
+      fc::remove_all( _data_dir / "object_database.old" );
+      ilog( "Wrote full object_database snapshot with ${c} indexes in ${t} ms",
+            ("c",written)("t",(fc::time_point::now() - start).count() / 1000) );
+   }
+
+   _manifest = std::move( manifest );
+   _snapshot_valid = true;
+   clear_dirty();
 }
 
 void object_database::wipe(const fc::path& data_dir)
 {
    close();
    ilog("Wiping object database...");
+   _manifest = object_database_manifest();
+   _snapshot_valid = false;
    fc::remove_all(data_dir / "object_database");
    ilog("Done wiping object databse.");
 }
@@ -98,17 +205,65 @@ void object_database::wipe(const fc::path& data_dir)
 void object_database::open(const fc::path& data_dir)
 { try {
    _data_dir = data_dir;
-   if( fc::exists( _data_dir / "object_database" / "lock" ) )
+   _manifest = object_database_manifest();
+   _snapshot_valid = false;
+   const fc::path db_dir = _data_dir / "object_database";
+   if( fc::exists( db_dir / "lock" ) )
    {
        wlog("Ignoring locked object_database");
        return;
    }
    ilog("Opening object database from ${d} ...", ("d", data_dir));
+   _manifest = read_manifest( db_dir );
+   vector< std::pair<index*, fc::path> > to_open;
    for( uint32_t space = 0; space < _index.size(); ++space )
       for( uint32_t type = 0; type  < _index[space].size(); ++type )
          if( _index[space][type] )
-            _index[space][type]->open( _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type) );
-   ilog( "Done opening object database." );
+         {
+            // the newest delta containing the index wins over older deltas and the base
+            fc::path file = db_dir / fc::to_string(space) / fc::to_string(type);
+            for( auto ritr = _manifest.deltas.rbegin(); ritr != _manifest.deltas.rend(); ++ritr )
+            {
+               const fc::path candidate = delta_path( db_dir, *ritr ) / fc::to_string(space) / fc::to_string(type);
+               if( fc::exists( candidate ) )
+               {
+                  file = candidate;
+                  break;
+               }
+            }
+            to_open.emplace_back( _index[space][type].get(), file );
+         }
+
+   // Decoding the files is independent per index and can run on the pool, inserting into
+   // the containers and secondary indexes happens on this thread in the usual order.
+   const auto start = fc::time_point::now();
+   vector<int64_t> decode_us( to_open.size() );
+   {
+      thread_pool pool( std::min<size_t>( _load_threads, to_open.size() ) );
+      pool.run( to_open.size(), [&to_open,&decode_us]( size_t i ) {
+         const auto decode_start = fc::time_point::now();
+         to_open[i].first->stage_open( to_open[i].second );
+         decode_us[i] = (fc::time_point::now() - decode_start).count();
+      });
+   }
+   const auto decoded = fc::time_point::now();
+   for( size_t i = 0; i < to_open.size(); ++i )
+   {
+      index* idx = to_open[i].first;
+      const auto insert_start = fc::time_point::now();
+      const size_t count = idx->finish_open();
+      if( count > 0 )
+         ilog( "Loaded ${c} objects into index ${s}.${t}: decode ${d} ms, insert ${i} ms",
+               ("c",count)("s",idx->object_space_id())("t",idx->object_type_id())
+               ("d",decode_us[i] / 1000)("i",(fc::time_point::now() - insert_start).count() / 1000) );
+   }
+   ilog( "Loaded ${n} indexes using ${w} threads: decode ${d} ms, insert ${i} ms",
+         ("n",to_open.size())("w",_load_threads)
+         ("d",(decoded - start).count() / 1000)("i",(fc::time_point::now() - decoded).count() / 1000) );
+   clear_dirty();
+   _snapshot_valid = fc::exists( db_dir );
+   ilog( "Done opening object database at block ${b} with ${d} deltas.",
+         ("b",_manifest.block_num)("d",_manifest.deltas.size()) );
 
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
 
@@ -120,16 +275,19 @@ void object_database::pop_undo()
 
 void object_database::save_undo( const object& obj )
 {
+   mark_dirty( obj.id );
    _undo_db.on_modify( obj );
 }
 
 void object_database::save_undo_add( const object& obj )
 {
+   mark_dirty( obj.id );
    _undo_db.on_create( obj );
 }
 
 void object_database::save_undo_remove(const object& obj)
 {
+   mark_dirty( obj.id );
    _undo_db.on_remove( obj );
 }
 
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/db/thread_pool.hpp>
+
+namespace graphene { namespace db {
+
+thread_pool::thread_pool( uint32_t num_threads )
+: _next( 0 )
+{
+   _threads.reserve( num_threads );
+   for( uint32_t i = 0; i < num_threads; ++i )
+      _threads.emplace_back( [this]() { worker_loop(); } );
+}
+
+thread_pool::~thread_pool()
+{
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _stopping = true;
+   }
+   _work_ready.notify_all();
+   for( auto& t : _threads )
+      t.join();
+}
+
+void thread_pool::worker_loop()
+{
+   uint64_t seen = 0;
+   std::unique_lock<std::mutex> lock( _mutex );
+   while( true )
+   {
+      _work_ready.wait( lock, [this,&seen]() { return _stopping || _generation != seen; } );
+      if( _stopping )
+         return;
+      seen = _generation;
+      const auto* job = _job;
+      const size_t count = _count;
+      lock.unlock();
+
+      std::exception_ptr error;
+      try {
+         for( size_t i = _next++; i < count; i = _next++ )
+            (*job)( i );
+      } catch( ... ) {
+         error = std::current_exception();
+      }
+
+      lock.lock();
+      if( error && !_error )
+         _error = error;
+      if( --_active == 0 )
+         _work_done.notify_one();
+   }
+}
+
+void thread_pool::run( size_t count, const std::function<void(size_t)>& job )
+{
+   if( count == 0 ) return;
+   if( _threads.empty() || count == 1 )
+   {
+      for( size_t i = 0; i < count; ++i )
+         job( i );
+      return;
+   }
+
+   std::lock_guard<std::mutex> run_lock( _run_mutex );
+   std::exception_ptr error;
+   {
+      std::unique_lock<std::mutex> lock( _mutex );
+      _job = &job;
+      _count = count;
+      _next = 0;
+      _active = _threads.size();
+      _error = nullptr;
+      ++_generation;
+      _work_ready.notify_all();
+      _work_done.wait( lock, [this]() { return _active == 0; } );
+      _job = nullptr;
+      error = _error;
+      _error = nullptr;
+   }
+   if( error )
+      std::rethrow_exception( error );
+}
+
+} } // graphene::db
@@ -64,10 +64,9 @@ void undo_database::on_create( const object& obj )
       _stack.emplace_back();
    auto& state = _stack.back();
    auto index_id = object_id_type( obj.id.space(), obj.id.type(), 0 );
-   auto itr = state.old_index_next_ids.find( index_id );
-   if( itr == state.old_index_next_ids.end() )
-      state.old_index_next_ids[index_id] = obj.id;
-   state.new_ids.insert(obj.id);
+   if( !state.old_index_next_ids.contains( index_id ) )
+      state.old_index_next_ids.insert( index_id, object_id_type( obj.id ) );
+   state.new_ids.insert( obj.id, true );
 }
 void undo_database::on_modify( const object& obj )
 {
@@ -76,11 +75,10 @@ void undo_database::on_modify( const object& obj )
    if( _stack.empty() )
       _stack.emplace_back();
    auto& state = _stack.back();
-   if( state.new_ids.find(obj.id) != state.new_ids.end() )
+   if( state.new_ids.contains(obj.id) )
       return;
-   auto itr =  state.old_values.find(obj.id);
-   if( itr != state.old_values.end() ) return;
-   state.old_values[obj.id] = obj.clone();
+   if( state.old_values.contains(obj.id) ) return;
+   state.old_values.insert( obj.id, obj.clone() );
 }
 void undo_database::on_remove( const object& obj )
 {
@@ -89,19 +87,16 @@ void undo_database::on_remove( const object& obj )
    if( _stack.empty() )
       _stack.emplace_back();
    undo_state& state = _stack.back();
-   if( state.new_ids.count(obj.id) )
-   {
-      state.new_ids.erase(obj.id);
+   if( state.new_ids.erase(obj.id) )
       return;
-   }
-   if( state.old_values.count(obj.id) )
+   if( auto old_value = state.old_values.find(obj.id) )
    {
-      state.removed[obj.id] = std::move(state.old_values[obj.id]);
+      state.removed.insert( obj.id, std::move(*old_value) );
       state.old_values.erase(obj.id);
       return;
    }
-   if( state.removed.count(obj.id) ) return;
-   state.removed[obj.id] = obj.clone();
+   if( state.removed.contains(obj.id) ) return;
+   state.removed.insert( obj.id, obj.clone() );
 }
 
 void undo_database::undo()
@@ -110,24 +105,7 @@ void undo_database::undo()
    FC_ASSERT( _active_sessions > 0 );
    disable();
 
-   auto& state = _stack.back();
-   for( auto& item : state.old_values )
-   {
-      _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
-   }
-
-   for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
-   {
-      _db.remove( _db.get_object(*ritr) );
-   }
-
-   for( auto& item : state.old_index_next_ids )
-   {
-      _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
-   }
-
-   for( auto& item : state.removed )
-      _db.insert( std::move(*item.second) );
+   restore( _stack.back() );
 
    _stack.pop_back();
    enable();
@@ -147,6 +125,16 @@ void undo_database::merge()
    auto& state = _stack.back();
    auto& prev_state = _stack[_stack.size()-2];
 
+   // Nothing in prev_state to reconcile against, so every entry of state is type B: take its
+   // containers over as a whole instead of re-inserting entry by entry.
+   if( prev_state.empty() )
+   {
+      prev_state = std::move( state );
+      _stack.pop_back();
+      --_active_sessions;
+      return;
+   }
+
    // An object's relationship to a state can be:
    // in new_ids            : new
    // in old_values (was=X) : upd(was=X)
@@ -192,33 +180,33 @@ void undo_database::merge()
    // *+upd
    for( auto& obj : state.old_values )
    {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
+      if( prev_state.new_ids.contains(obj.first) )
       {
          // new+upd -> new, type A
          continue;
       }
-      if( prev_state.old_values.find(obj.second->id) != prev_state.old_values.end() )
+      if( prev_state.old_values.contains(obj.first) )
       {
          // upd(was=X) + upd(was=Y) -> upd(was=X), type A
          continue;
       }
       // del+upd -> N/A
-      assert( prev_state.removed.find(obj.second->id) == prev_state.removed.end() );
+      assert( !prev_state.removed.contains(obj.first) );
       // nop+upd(was=Y) -> upd(was=Y), type B
-      prev_state.old_values[obj.second->id] = std::move(obj.second);
+      prev_state.old_values.insert( obj.first, std::move(obj.second) );
    }
 
    // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
-   for( auto id : state.new_ids )
-      prev_state.new_ids.insert(id);
+   for( auto& item : state.new_ids )
+      prev_state.new_ids.insert( item.first, true );
 
    // old_index_next_ids can only be updated, iterate over *+upd cases
    for( auto& item : state.old_index_next_ids )
    {
-      if( prev_state.old_index_next_ids.find( item.first ) == prev_state.old_index_next_ids.end() )
+      if( !prev_state.old_index_next_ids.contains( item.first ) )
       {
          // nop+upd(was=Y) -> upd(was=Y), type B
-         prev_state.old_index_next_ids[item.first] = item.second;
+         prev_state.old_index_next_ids.insert( item.first, object_id_type( item.second ) );
          continue;
       }
       else
@@ -232,24 +220,22 @@ void undo_database::merge()
    // *+del
    for( auto& obj : state.removed )
    {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
+      if( prev_state.new_ids.erase(obj.first) )
       {
          // new + del -> nop (type C)
-         prev_state.new_ids.erase(obj.second->id);
          continue;
       }
-      auto it = prev_state.old_values.find(obj.second->id);
-      if( it != prev_state.old_values.end() )
+      if( auto old_value = prev_state.old_values.find(obj.first) )
       {
          // upd(was=X) + del(was=Y) -> del(was=X)
-         prev_state.removed[obj.second->id] = std::move(it->second);
-         prev_state.old_values.erase(obj.second->id);
+         prev_state.removed.insert( obj.first, std::move(*old_value) );
+         prev_state.old_values.erase(obj.first);
          continue;
       }
       // del + del -> N/A
-      assert( prev_state.removed.find( obj.second->id ) == prev_state.removed.end() );
+      assert( !prev_state.removed.contains( obj.first ) );
       // nop + del(was=Y) -> del(was=Y)
-      prev_state.removed[obj.second->id] = std::move(obj.second);
+      prev_state.removed.insert( obj.first, std::move(obj.second) );
    }
    _stack.pop_back();
    --_active_sessions;
@@ -267,26 +253,7 @@ void undo_database::pop_commit()
 
    disable();
    try {
-      auto& state = _stack.back();
-
-      for( auto& item : state.old_values )
-      {
-         _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
-      }
-
-      for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
-      {
-         _db.remove( _db.get_object(*ritr) );
-      }
-
-      for( auto& item : state.old_index_next_ids )
-      {
-         _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
-      }
-
-      for( auto& item : state.removed )
-         _db.insert( std::move(*item.second) );
-
+      restore( _stack.back() );
       _stack.pop_back();
    }
    catch ( const fc::exception& e )
@@ -297,6 +264,31 @@ void undo_database::pop_commit()
    }
    enable();
 }
+void undo_database::restore( undo_state& state )
+{
+   // secondary indexes see the changes in id order, whatever order they were recorded in
+   for( const auto& id : state.old_values.sorted_ids() )
+   {
+      auto& old_value = *state.old_values.find( id );
+      _db.modify( _db.get_object( id ), [&]( object& obj ){ obj.move_from( *old_value ); } );
+   }
+
+   // remove the newest objects first, as the ordered set used to
+   const auto new_ids = state.new_ids.sorted_ids();
+   for( auto id = new_ids.rbegin(); id != new_ids.rend(); ++id )
+   {
+      _db.remove( _db.get_object(*id) );
+   }
+
+   for( auto& item : state.old_index_next_ids )
+   {
+      _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
+   }
+
+   for( const auto& id : state.removed.sorted_ids() )
+      _db.insert( std::move(**state.removed.find( id )) );
+}
+
 const undo_state& undo_database::head()const
 {
    FC_ASSERT( !_stack.empty() );
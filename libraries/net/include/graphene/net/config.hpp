@@ -37,6 +37,12 @@
  * 2MiB
  */
 #define MAX_MESSAGE_SIZE                                     1024*1024*2
+
+/**
+ * Size of the buffers the encrypted sockets read into and write from.
+ * One read usually brings in several small messages or a large part of a block.
+ */
+#define GRAPHENE_NET_SOCKET_BUFFER_SIZE                      (64*1024)
 #define GRAPHENE_NET_DEFAULT_PEER_CONNECTION_RETRY_TIME      30 // seconds
 
 /**
@@ -71,6 +77,12 @@
  */
 #define GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS        5
 
+/**
+ * Default number of bytes of message bodies the message cache may hold before it evicts the
+ * least recently used messages, even if they are younger than the cache duration
+ */
+#define GRAPHENE_NET_DEFAULT_MESSAGE_CACHE_SIZE_LIMIT        (64*1024*1024)
+
 /**
  * We prevent a peer from offering us a list of blocks which, if we fetched them
  * all, would result in a blockchain that extended into the future.
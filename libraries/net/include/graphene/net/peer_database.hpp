@@ -99,7 +99,11 @@ namespace graphene { namespace net {
     peer_database();
     ~peer_database();
 
-    void open(const fc::path& databaseFilename);
+    /**
+     * Loads the binary peer database at @p databaseFilename. If it does not exist yet, the peers are
+     * migrated from @p legacy_json_filename, which is renamed once they are saved in binary form.
+     */
+    void open(const fc::path& databaseFilename, const fc::path& legacy_json_filename = fc::path());
     void close();
     void clear();
 
@@ -109,6 +113,13 @@ namespace graphene { namespace net {
     potential_peer_record lookup_or_create_entry_for_endpoint(const fc::ip::endpoint& endpointToLookup);
     fc::optional<potential_peer_record> lookup_entry_for_endpoint(const fc::ip::endpoint& endpointToLookup);
 
+    /**
+     * Peers worth a connection attempt at @p now: those whose last attempt did not fail, least recently
+     * tried first, then failed ones whose retry delay of (number_of_failed_connection_attempts + 1) *
+     * @p retry_timeout seconds has passed. Only the failed peers that may be due are looked at.
+     */
+    std::vector<potential_peer_record> get_connection_candidates(fc::time_point now, uint32_t retry_timeout) const;
+
     typedef detail::peer_database_iterator iterator;
     iterator begin() const;
     iterator end() const;
@@ -33,6 +33,7 @@
 #include <graphene/net/config.hpp>
 
 #include <atomic>
+#include <vector>
 
 #ifdef DEFAULT_LOGGER
 # undef DEFAULT_LOGGER
@@ -68,7 +69,16 @@ namespace graphene { namespace net {
       fc::thread* _thread;
 #endif
 
+      /// decrypted bytes read ahead from the socket; [_read_buffer_begin, _read_buffer_end) is not parsed yet
+      std::vector<char> _read_buffer;
+      size_t _read_buffer_begin;
+      size_t _read_buffer_end;
+      /// padded frame of the message being sent, reused across send_message() calls
+      std::vector<char> _send_buffer;
+
       void read_loop();
+      void read_message(message& m);
+      void fill_read_buffer(size_t needed);
       void start_read_loop();
     public:
       fc::tcp_socket& get_socket();
@@ -104,6 +114,9 @@ namespace graphene { namespace net {
 #ifndef NDEBUG
       ,_thread(&fc::thread::current())
 #endif
+      ,_read_buffer(GRAPHENE_NET_SOCKET_BUFFER_SIZE),
+      _read_buffer_begin(0),
+      _read_buffer_end(0)
     {
     }
     message_oriented_connection_impl::~message_oriented_connection_impl()
@@ -155,13 +168,68 @@ namespace graphene { namespace net {
       }
     };
 
+    /**
+     * Makes sure at least @p needed bytes, which must fit in _read_buffer, are buffered from
+     * _read_buffer_begin on. Socket reads ask for all the free space so that one read brings in as
+     * many frames as the peer has sent.
+     */
+    void message_oriented_connection_impl::fill_read_buffer(size_t needed)
+    {
+      assert(needed <= _read_buffer.size() && needed % 16 == 0);
+      const size_t buffered = _read_buffer_end - _read_buffer_begin;
+      if (buffered >= needed)
+        return;
+
+      if (_read_buffer.size() - _read_buffer_begin < needed)
+      {
+        // move the partial frame to the front to make room for the rest of it
+        memmove(_read_buffer.data(), _read_buffer.data() + _read_buffer_begin, buffered);
+        _read_buffer_begin = 0;
+        _read_buffer_end = buffered;
+      }
+
+      while (_read_buffer_end - _read_buffer_begin < needed)
+        _read_buffer_end += _sock.readsome(_read_buffer.data() + _read_buffer_end, _read_buffer.size() - _read_buffer_end);
+    }
+
+    /**
+     * Parses the next frame into @p m. Frames that fit in _read_buffer are copied out of it; the
+     * payload of a larger frame is read straight into the message once the buffered part is taken.
+     */
+    void message_oriented_connection_impl::read_message(message& m)
+    {
+      if (_read_buffer_begin == _read_buffer_end)
+        _read_buffer_begin = _read_buffer_end = 0;
+
+      fill_read_buffer(16);
+      memcpy((char*)&m, _read_buffer.data() + _read_buffer_begin, sizeof(message_header));
+
+      FC_ASSERT( m.size <= MAX_MESSAGE_SIZE, "", ("m.size",m.size)("MAX_MESSAGE_SIZE",MAX_MESSAGE_SIZE) );
+
+      const size_t frame_size = 16 * ((sizeof(message_header) + m.size + 15) / 16);
+      m.data.resize(frame_size - sizeof(message_header)); // the padding added in send call is truncated below
+      if (frame_size <= _read_buffer.size())
+      {
+        fill_read_buffer(frame_size);
+        const char* payload = _read_buffer.data() + _read_buffer_begin + sizeof(message_header);
+        std::copy(payload, payload + m.data.size(), m.data.begin());
+        _read_buffer_begin += frame_size;
+      }
+      else
+      {
+        const size_t buffered = _read_buffer_end - _read_buffer_begin;
+        const char* payload = _read_buffer.data() + _read_buffer_begin + sizeof(message_header);
+        std::copy(payload, payload + buffered - sizeof(message_header), m.data.begin());
+        _read_buffer_begin = _read_buffer_end = 0;
+        _sock.read(&m.data[buffered - sizeof(message_header)], frame_size - buffered);
+      }
+      _bytes_received += frame_size;
+      m.data.resize(m.size);
+    }
+
     void message_oriented_connection_impl::read_loop()
     {
       VERIFY_CORRECT_THREAD();
-      const int BUFFER_SIZE = 16;
-      const int LEFTOVER = BUFFER_SIZE - sizeof(message_header);
-      static_assert(BUFFER_SIZE >= sizeof(message_header), "insufficient buffer");
-
       no_parallel_execution_guard guard( &_read_loop_in_progress );
       _connected_time = fc::time_point::now();
 
@@ -173,22 +241,7 @@ namespace graphene { namespace net {
         message m;
         while( true )
         {
-          char buffer[BUFFER_SIZE];
-          _sock.read(buffer, BUFFER_SIZE);
-          _bytes_received += BUFFER_SIZE;
-          memcpy((char*)&m, buffer, sizeof(message_header));
-
-          FC_ASSERT( m.size <= MAX_MESSAGE_SIZE, "", ("m.size",m.size)("MAX_MESSAGE_SIZE",MAX_MESSAGE_SIZE) );
-
-          size_t remaining_bytes_with_padding = 16 * ((m.size - LEFTOVER + 15) / 16);
-          m.data.resize(LEFTOVER + remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
-          std::copy(buffer + sizeof(message_header), buffer + sizeof(buffer), m.data.begin());
-          if (remaining_bytes_with_padding)
-          {
-            _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
-            _bytes_received += remaining_bytes_with_padding;
-          }
-          m.data.resize(m.size); // truncate off the padding bytes
+          read_message(m);
 
           _last_message_received_time = fc::time_point::now();
 
@@ -268,18 +321,23 @@ namespace graphene { namespace net {
            elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
         //pad the message we send to a multiple of 16 bytes
         size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
-        std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
+        _send_buffer.resize(size_with_padding);
+        char* padded_message = _send_buffer.data();
 
-        memcpy(padded_message.get(), (char*)&message_to_send, sizeof(message_header));
-        memcpy(padded_message.get() + sizeof(message_header), message_to_send.data.data(), message_to_send.size );
-        char* paddingSpace = padded_message.get() + sizeof(message_header) + message_to_send.size;
+        memcpy(padded_message, (char*)&message_to_send, sizeof(message_header));
+        memcpy(padded_message + sizeof(message_header), message_to_send.data.data(), message_to_send.size );
+        char* paddingSpace = padded_message + sizeof(message_header) + message_to_send.size;
         size_t toClean = size_with_padding - size_of_message_and_header;
         memset(paddingSpace, 0, toClean);
 
-        _sock.write(padded_message.get(), size_with_padding);
+        _sock.write(padded_message, size_with_padding);
         _sock.flush();
         _bytes_sent += size_with_padding;
         _last_message_sent_time = fc::time_point::now();
+
+        // keep the buffer for the next message unless an oversized one blew it up
+        if (_send_buffer.capacity() > MAX_MESSAGE_SIZE)
+          std::vector<char>().swap(_send_buffer);
       } FC_RETHROW_EXCEPTIONS( warn, "unable to send message" );
     }
 
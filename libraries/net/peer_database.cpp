@@ -26,26 +26,39 @@
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/mem_fun.hpp>
+#include <boost/multi_index/global_fun.hpp>
+#include <boost/multi_index/composite_key.hpp>
 #include <boost/multi_index/tag.hpp>
 
 #include <fc/io/raw.hpp>
 #include <fc/io/raw_variant.hpp>
 #include <fc/log/logger.hpp>
 #include <fc/io/json.hpp>
+#include <fc/filesystem.hpp>
 
 #include <graphene/net/peer_database.hpp>
 #include <graphene/net/config.hpp>
 
+#include <fstream>
+
 namespace graphene { namespace net {
   namespace detail
   {
     using namespace boost::multi_index;
 
+    bool last_connection_failed_or_rejected(const potential_peer_record& record)
+    {
+      return record.last_connection_disposition == last_connection_failed ||
+             record.last_connection_disposition == last_connection_rejected ||
+             record.last_connection_disposition == last_connection_handshaking_failed;
+    }
+
     class peer_database_impl
     {
     public:
       struct last_seen_time_index {};
       struct endpoint_index {};
+      struct connection_candidate_index {};
       typedef boost::multi_index_container<potential_peer_record, 
                                            indexed_by<ordered_non_unique<tag<last_seen_time_index>, 
                                                                          member<potential_peer_record, 
@@ -55,20 +68,46 @@ namespace graphene { namespace net {
                                                                     member<potential_peer_record, 
                                                                            fc::ip::endpoint, 
                                                                            &potential_peer_record::endpoint>, 
-                                                                    std::hash<fc::ip::endpoint> > > > potential_peer_set;
+                                                                    std::hash<fc::ip::endpoint> >,
+                                                      ordered_non_unique<tag<connection_candidate_index>,
+                                                                         composite_key<potential_peer_record,
+                                                                                       global_fun<const potential_peer_record&, bool,
+                                                                                                  &last_connection_failed_or_rejected>,
+                                                                                       member<potential_peer_record,
+                                                                                              fc::time_point_sec,
+                                                                                              &potential_peer_record::last_connection_attempt_time> > > > > potential_peer_set;
 
     private:
+      /// kinds of entries in the binary peer log
+      enum log_entry_type : uint8_t
+      {
+        entry_updated = 1,
+        entry_erased = 2
+      };
+      static const uint32_t log_magic = 0x50454552; // "PEER"
+
       potential_peer_set     _potential_peer_set;
       fc::path _peer_database_filename;
+      std::ofstream _log;
+      /// entries in the log file, live or superseded
+      size_t _log_entries = 0;
+      /// set when an append failed, the log then misses entries until it is rewritten
+      bool _needs_compaction = false;
+
+      bool load_log();
+      void load_json(const fc::path& json_filename);
+      void append_to_log(log_entry_type type, const std::vector<char>& payload);
+      void compact();
 
     public:
-      void open(const fc::path& databaseFilename);
+      void open(const fc::path& databaseFilename, const fc::path& legacy_json_filename);
       void close();
       void clear();
       void erase(const fc::ip::endpoint& endpointToErase);
       void update_entry(const potential_peer_record& updatedRecord);
       potential_peer_record lookup_or_create_entry_for_endpoint(const fc::ip::endpoint& endpointToLookup);
       fc::optional<potential_peer_record> lookup_entry_for_endpoint(const fc::ip::endpoint& endpointToLookup);
+      std::vector<potential_peer_record> get_connection_candidates(fc::time_point now, uint32_t retry_timeout) const;
 
       peer_database::iterator begin() const;
       peer_database::iterator end() const;
@@ -87,43 +126,197 @@ namespace graphene { namespace net {
     peer_database_iterator::peer_database_iterator( const peer_database_iterator& c ) :
       boost::iterator_facade<peer_database_iterator, const potential_peer_record, boost::forward_traversal_tag>(c){}
 
-    void peer_database_impl::open(const fc::path& peer_database_filename)
+    /**
+     * Replays the log: a magic number followed by entries, each an entry type and the packed record
+     * (or endpoint, for erasures) as a length prefixed blob. A torn entry at the end, left by a crash
+     * in the middle of an append, ends the replay.
+     */
+    bool peer_database_impl::load_log()
+    {
+      std::ifstream in(_peer_database_filename.generic_string(), std::ios::binary);
+      std::vector<char> contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+      fc::datastream<const char*> ds(contents.data(), contents.size());
+
+      uint32_t magic = 0;
+      fc::raw::unpack(ds, magic);
+      FC_ASSERT(magic == log_magic, "not a peer database");
+      try
+      {
+        while (ds.remaining())
+        {
+          uint8_t type;
+          std::vector<char> payload;
+          fc::raw::unpack(ds, type);
+          fc::raw::unpack(ds, payload);
+          if (type == entry_updated)
+          {
+            potential_peer_record record = fc::raw::unpack<potential_peer_record>(payload);
+            auto& endpoints = _potential_peer_set.get<endpoint_index>();
+            auto iter = endpoints.find(record.endpoint);
+            if (iter != endpoints.end())
+              endpoints.replace(iter, record);
+            else
+              endpoints.insert(record);
+          }
+          else if (type == entry_erased)
+            _potential_peer_set.get<endpoint_index>().erase(fc::raw::unpack<fc::ip::endpoint>(payload));
+          ++_log_entries;
+        }
+      }
+      catch (const fc::exception&)
+      {
+        wlog("peer database ${file} ends with an incomplete entry, ignoring it", ("file", _peer_database_filename));
+        return false;
+      }
+      return true;
+    }
+
+    void peer_database_impl::load_json(const fc::path& json_filename)
+    {
+      std::vector<potential_peer_record> peer_records = fc::json::from_file(json_filename).as<std::vector<potential_peer_record> >( GRAPHENE_NET_MAX_NESTED_OBJECTS );
+      std::copy(peer_records.begin(), peer_records.end(), std::inserter(_potential_peer_set, _potential_peer_set.end()));
+    }
+
+    void peer_database_impl::append_to_log(log_entry_type type, const std::vector<char>& payload)
+    {
+      if (!_log.is_open())
+        return;
+      try
+      {
+        std::vector<char> entry = fc::raw::pack(uint8_t(type));
+        std::vector<char> packed_payload = fc::raw::pack(payload);
+        entry.insert(entry.end(), packed_payload.begin(), packed_payload.end());
+        _log.write(entry.data(), entry.size());
+        // peers change rarely, so every entry goes to the file right away instead of waiting for close()
+        _log.flush();
+        FC_ASSERT(_log, "unable to write ${file}", ("file", _peer_database_filename));
+        ++_log_entries;
+
+        // superseded entries make up most of the log, rewrite it with the live ones
+        if (_log_entries > 2 * _potential_peer_set.size() + MAXIMUM_PEERDB_SIZE)
+          compact();
+      }
+      catch (const fc::exception& e)
+      {
+        // the peers in memory are still right, stop logging and rewrite the whole file at close() or the next open()
+        elog("error saving peer database to file ${peer_database_filename}: ${e}",
+             ("peer_database_filename", _peer_database_filename)("e", e.to_detail_string()));
+        if (_log.is_open())
+          _log.close();
+        _needs_compaction = true;
+      }
+    }
+
+    /// rewrites the log with one entry per known peer, replacing the old file only once the new one is complete
+    void peer_database_impl::compact()
+    {
+      if (_log.is_open())
+        _log.close();
+
+      fc::path temp_filename = _peer_database_filename.generic_string() + ".tmp";
+      {
+        std::ofstream out(temp_filename.generic_string(), std::ios::binary | std::ios::trunc);
+        FC_ASSERT(out, "unable to write ${file}", ("file", temp_filename));
+        std::vector<char> magic = fc::raw::pack(uint32_t(log_magic));
+        out.write(magic.data(), magic.size());
+        for (const potential_peer_record& record : _potential_peer_set)
+        {
+          std::vector<char> entry = fc::raw::pack(uint8_t(entry_updated));
+          std::vector<char> packed_record = fc::raw::pack(fc::raw::pack(record));
+          entry.insert(entry.end(), packed_record.begin(), packed_record.end());
+          out.write(entry.data(), entry.size());
+        }
+        out.flush();
+        FC_ASSERT(out, "unable to write ${file}", ("file", temp_filename));
+      }
+      fc::rename(temp_filename, _peer_database_filename);
+      _log_entries = _potential_peer_set.size();
+      _needs_compaction = false;
+
+      _log.open(_peer_database_filename.generic_string(), std::ios::binary | std::ios::app);
+    }
+
+    void peer_database_impl::open(const fc::path& peer_database_filename, const fc::path& legacy_json_filename)
     {
       _peer_database_filename = peer_database_filename;
+      _log_entries = 0;
+      bool needs_compaction = _needs_compaction;
       if (fc::exists(_peer_database_filename))
       {
         try
         {
-          std::vector<potential_peer_record> peer_records = fc::json::from_file(_peer_database_filename).as<std::vector<potential_peer_record> >( GRAPHENE_NET_MAX_NESTED_OBJECTS );
-          std::copy(peer_records.begin(), peer_records.end(), std::inserter(_potential_peer_set, _potential_peer_set.end()));
-          if (_potential_peer_set.size() > MAXIMUM_PEERDB_SIZE)
-          {
-            // prune database to a reasonable size
-            auto iter = _potential_peer_set.begin();
-            std::advance(iter, MAXIMUM_PEERDB_SIZE);
-            _potential_peer_set.erase(iter, _potential_peer_set.end());
-          }
+          needs_compaction = !load_log();
         }
         catch (const fc::exception& e)
         {
           elog("error opening peer database file ${peer_database_filename}, starting with a clean database", 
                ("peer_database_filename", _peer_database_filename));
+          _potential_peer_set.clear();
+          needs_compaction = true;
+        }
+      }
+      else
+      {
+        needs_compaction = true;
+        if (!legacy_json_filename.empty() && fc::exists(legacy_json_filename))
+        {
+          try
+          {
+            load_json(legacy_json_filename);
+            ilog("migrated ${n} peers from ${json} to ${file}",
+                 ("n", _potential_peer_set.size())("json", legacy_json_filename)("file", _peer_database_filename));
+          }
+          catch (const fc::exception& e)
+          {
+            elog("error opening peer database file ${peer_database_filename}, starting with a clean database", 
+                 ("peer_database_filename", legacy_json_filename));
+          }
         }
       }
-    }
 
-    void peer_database_impl::close()
-    {
-      std::vector<potential_peer_record> peer_records;
-      peer_records.reserve(_potential_peer_set.size());
-      std::copy(_potential_peer_set.begin(), _potential_peer_set.end(), std::back_inserter(peer_records));
+      if (_potential_peer_set.size() > MAXIMUM_PEERDB_SIZE)
+      {
+        // prune database to a reasonable size
+        auto iter = _potential_peer_set.begin();
+        std::advance(iter, MAXIMUM_PEERDB_SIZE);
+        _potential_peer_set.erase(iter, _potential_peer_set.end());
+        needs_compaction = true;
+      }
 
       try
       {
         fc::path peer_database_filename_dir = _peer_database_filename.parent_path();
         if (!fc::exists(peer_database_filename_dir))
           fc::create_directories(peer_database_filename_dir);
-        fc::json::save_to_file( peer_records, _peer_database_filename, GRAPHENE_NET_MAX_NESTED_OBJECTS );
+        if (needs_compaction)
+        {
+          compact();
+          if (!legacy_json_filename.empty() && fc::exists(legacy_json_filename))
+          {
+            fc::rename(legacy_json_filename, legacy_json_filename.generic_string() + ".migrated");
+          }
+        }
+        else
+          _log.open(_peer_database_filename.generic_string(), std::ios::binary | std::ios::app);
+      }
+      catch (const fc::exception& e)
+      {
+        elog("error saving peer database to file ${peer_database_filename}", 
+             ("peer_database_filename", _peer_database_filename));
+      }
+    }
+
+    void peer_database_impl::close()
+    {
+      try
+      {
+        if (_log.is_open())
+          _log.close();
+        if (_needs_compaction || _log_entries > _potential_peer_set.size() + MAXIMUM_PEERDB_SIZE / 10)
+        {
+          compact();
+          _log.close();
+        }
       }
       catch (const fc::exception& e)
       {
@@ -136,13 +329,28 @@ namespace graphene { namespace net {
     void peer_database_impl::clear()
     {
       _potential_peer_set.clear();
+      if (!_log.is_open())
+        return;
+      try
+      {
+        compact();
+      }
+      catch (const fc::exception& e)
+      {
+        elog("error saving peer database to file ${peer_database_filename}: ${e}",
+             ("peer_database_filename", _peer_database_filename)("e", e.to_detail_string()));
+        _needs_compaction = true;
+      }
     }
 
     void peer_database_impl::erase(const fc::ip::endpoint& endpointToErase)
     {
       auto iter = _potential_peer_set.get<endpoint_index>().find(endpointToErase);
       if (iter != _potential_peer_set.get<endpoint_index>().end())
+      {
         _potential_peer_set.get<endpoint_index>().erase(iter);
+        append_to_log(entry_erased, fc::raw::pack(endpointToErase));
+      }
     }
 
     void peer_database_impl::update_entry(const potential_peer_record& updatedRecord)
@@ -152,6 +360,7 @@ namespace graphene { namespace net {
         _potential_peer_set.get<endpoint_index>().modify(iter, [&updatedRecord](potential_peer_record& record) { record = updatedRecord; });
       else
         _potential_peer_set.get<endpoint_index>().insert(updatedRecord);
+      append_to_log(entry_updated, fc::raw::pack(updatedRecord));
     }
 
     potential_peer_record peer_database_impl::lookup_or_create_entry_for_endpoint(const fc::ip::endpoint& endpointToLookup)
@@ -170,6 +379,27 @@ namespace graphene { namespace net {
       return fc::optional<potential_peer_record>();
     }
 
+    std::vector<potential_peer_record> peer_database_impl::get_connection_candidates(fc::time_point now, uint32_t retry_timeout) const
+    {
+      const auto& candidates = _potential_peer_set.get<connection_candidate_index>();
+      std::vector<potential_peer_record> result;
+
+      // peers whose last attempt did not fail can be tried right away
+      auto failed_begin = candidates.lower_bound(boost::make_tuple(true));
+      result.insert(result.end(), candidates.begin(), failed_begin);
+
+      // a failed peer waits (number_of_failed_connection_attempts + 1) * retry_timeout, so none attempted
+      // within the last retry_timeout can be due
+      auto failed_end = candidates.upper_bound(boost::make_tuple(true, fc::time_point_sec(now - fc::seconds(retry_timeout))));
+      for (auto iter = failed_begin; iter != failed_end; ++iter)
+      {
+        fc::microseconds delay_until_retry = fc::seconds((iter->number_of_failed_connection_attempts + 1) * retry_timeout);
+        if ((now - iter->last_connection_attempt_time) > delay_until_retry)
+          result.push_back(*iter);
+      }
+      return result;
+    }
+
     peer_database::iterator peer_database_impl::begin() const
     {
       return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<last_seen_time_index>().begin()));
@@ -223,9 +453,9 @@ namespace graphene { namespace net {
   peer_database::~peer_database()
   {}
 
-  void peer_database::open(const fc::path& databaseFilename)
+  void peer_database::open(const fc::path& databaseFilename, const fc::path& legacy_json_filename)
   {
-    my->open(databaseFilename);
+    my->open(databaseFilename, legacy_json_filename);
   }
 
   void peer_database::close()
@@ -258,6 +488,11 @@ namespace graphene { namespace net {
     return my->lookup_entry_for_endpoint(endpoint_to_lookup);
   }
 
+  std::vector<potential_peer_record> peer_database::get_connection_candidates(fc::time_point now, uint32_t retry_timeout) const
+  {
+    return my->get_connection_candidates(now, retry_timeout);
+  }
+
   peer_database::iterator peer_database::begin() const
   {
     return my->begin();
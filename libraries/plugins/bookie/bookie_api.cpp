@@ -24,6 +24,7 @@
 #include <fc/filesystem.hpp>
 #include <fc/optional.hpp>
 #include <fc/variant_object.hpp>
+#include <fc/thread/thread.hpp>
 
 #include <graphene/app/application.hpp>
 
@@ -43,29 +44,52 @@ namespace graphene { namespace bookie {
 
 namespace detail {
 
-class bookie_api_impl
+class bookie_api_impl : public std::enable_shared_from_this<bookie_api_impl>
 {
    public:
       bookie_api_impl(graphene::app::application& _app);
 
       binned_order_book get_binned_order_book(graphene::chain::betting_market_id_type betting_market_id, int32_t precision);
+      void subscribe_to_binned_order_book(std::function<void(const variant&)> callback, betting_market_id_type betting_market_id, int32_t precision);
+      void unsubscribe_from_binned_order_book(betting_market_id_type betting_market_id);
       std::shared_ptr<graphene::bookie::bookie_plugin> get_plugin();
       asset get_total_matched_bet_amount_for_betting_market_group(betting_market_group_id_type group_id);
-      std::vector<event_object> get_events_containing_sub_string(const std::string& sub_string, const std::string& language);
+      std::vector<event_object> get_events_containing_sub_string(const std::string& sub_string, const std::string& language, unsigned limit);
       fc::variants get_objects(const vector<object_id_type>& ids) const;
       std::vector<matched_bet_object> get_matched_bets_for_bettor(account_id_type bettor_id) const;
       std::vector<matched_bet_object> get_all_matched_bets_for_bettor(account_id_type bettor_id, bet_id_type start, unsigned limit) const;
       graphene::app::application& app;
+
+   private:
+      struct order_book_subscription
+      {
+         std::function<void(const variant&)> callback;
+         int32_t precision;
+         /// revision of the betting market's levels the order book was binned from
+         uint64_t revision;
+         /// the order book as last seen by the subscriber
+         binned_order_book order_book;
+      };
+
+      void on_applied_block();
+
+      map<betting_market_id_type, order_book_subscription> _order_book_subscriptions;
+      boost::signals2::scoped_connection _applied_block_connection;
 };
 
 bookie_api_impl::bookie_api_impl(graphene::app::application& _app) : app(_app)
 {}
 
 
+static const bet_order_book_index& get_order_book_index(const graphene::chain::database& db)
+{
+   const auto &aidx = dynamic_cast<const base_primary_index &>(db.get_index_type<bet_object_index>());
+   return aidx.get_secondary_index<bet_order_book_index>();
+}
+
 binned_order_book bookie_api_impl::get_binned_order_book(graphene::chain::betting_market_id_type betting_market_id, int32_t precision)
 {
     std::shared_ptr<graphene::chain::database> db = app.chain_database();
-    const auto& bet_odds_idx = db->get_index_type<graphene::chain::bet_object_index>().indices().get<graphene::chain::by_odds>();
     const chain_parameters& current_params = db->get_global_properties().parameters;
 
     graphene::chain::bet_multiplier_type bin_size = GRAPHENE_BETTING_ODDS_PRECISION;
@@ -82,69 +106,120 @@ binned_order_book bookie_api_impl::get_binned_order_book(graphene::chain::bettin
 
     binned_order_book result; 
 
-    // use a bet_object here for convenience. we really only use it to track the amount, odds, and back_or_lay
-    fc::optional<bet_object> current_bin;
+    const auto& order_books = get_order_book_index(*db).order_books;
+    auto book_iter = order_books.find(betting_market_id);
+    if (book_iter == order_books.end())
+        return result;
 
-    auto flush_current_bin = [&current_bin, &result]()
+    // the levels of one bin are adjacent, so the bins are built in one pass over both sides of the order book
+    // (backs at increasing odds then lays at decreasing odds)
+    auto add_to_bin = [](std::vector<order_bin>& bins, graphene::chain::bet_multiplier_type backer_multiplier, share_type amount)
     {
-        if (current_bin) // do nothing if the current bin is empty
+        if (bins.empty() || bins.back().backer_multiplier != backer_multiplier)
         {
-            order_bin current_order_bin;
-
-            current_order_bin.backer_multiplier = current_bin->backer_multiplier;
-            current_order_bin.amount_to_bet = current_bin->amount_to_bet.amount;
-            //idump((*current_bin)(current_order_bin));
-            if (current_bin->back_or_lay == bet_type::back)
-                result.aggregated_back_bets.emplace_back(std::move(current_order_bin));
-            else // current_bin is aggregating back positions
-                result.aggregated_lay_bets.emplace_back(std::move(current_order_bin));
-
-            current_bin.reset();
+            bins.emplace_back();
+            bins.back().backer_multiplier = backer_multiplier;
+            bins.back().amount_to_bet = 0;
         }
+        bins.back().amount_to_bet += amount;
     };
 
-    // iterate through both sides of the order book (backs at increasing odds then lays at decreasing odds)
-    for (auto bet_odds_iter = bet_odds_idx.lower_bound(std::make_tuple(betting_market_id));
-         bet_odds_iter != bet_odds_idx.end() && betting_market_id == bet_odds_iter->betting_market_id;
-         ++bet_odds_iter)
+    // for back bets, we want to group all bets with odds from 3.0001 to 4 into the "4" bin
+    // for lay bets, we want to group all bets with odds from 3 to 3.9999 into the "3" bin
+    for (const auto& level : book_iter->second.back_bets)
     {
-        if (current_bin && 
-            (bet_odds_iter->back_or_lay != current_bin->back_or_lay /* we have switched from back to lay bets */ ||
-             (bet_odds_iter->back_or_lay == bet_type::back ? bet_odds_iter->backer_multiplier > current_bin->backer_multiplier :
-                                                             bet_odds_iter->backer_multiplier < current_bin->backer_multiplier)))
-            flush_current_bin();
+        graphene::chain::bet_multiplier_type backer_multiplier = (level.first + bin_size - 1) / bin_size * bin_size;
+        backer_multiplier = std::min<graphene::chain::bet_multiplier_type>(backer_multiplier, current_params.max_bet_multiplier());
+        add_to_bin(result.aggregated_back_bets, backer_multiplier, level.second);
+    }
+    for (auto level = book_iter->second.lay_bets.rbegin(); level != book_iter->second.lay_bets.rend(); ++level)
+    {
+        graphene::chain::bet_multiplier_type backer_multiplier = level->first / bin_size * bin_size;
+        backer_multiplier = std::max<graphene::chain::bet_multiplier_type>(backer_multiplier, current_params.min_bet_multiplier());
+        add_to_bin(result.aggregated_lay_bets, backer_multiplier, level->second);
+    }
 
-        if (!current_bin)
-        {
-            // if there is no current bin, create one appropriate for the bet we're processing
-            current_bin = graphene::chain::bet_object();
-
-            // for back bets, we want to group all bets with odds from 3.0001 to 4 into the "4" bin
-            // for lay bets, we want to group all bets with odds from 3 to 3.9999 into the "3" bin
-            if (bet_odds_iter->back_or_lay == bet_type::back)
-            {
-               current_bin->backer_multiplier = (bet_odds_iter->backer_multiplier + bin_size - 1) / bin_size * bin_size;
-               current_bin->backer_multiplier = std::min<graphene::chain::bet_multiplier_type>(current_bin->backer_multiplier, current_params.max_bet_multiplier());
-               current_bin->back_or_lay = bet_type::back;
-            }
-            else
-            {
-               current_bin->backer_multiplier = bet_odds_iter->backer_multiplier / bin_size * bin_size;
-               current_bin->backer_multiplier = std::max<graphene::chain::bet_multiplier_type>(current_bin->backer_multiplier, current_params.min_bet_multiplier());
-               current_bin->back_or_lay = bet_type::lay;
-            }
+    return result;
+}
 
-            current_bin->amount_to_bet.amount = 0;
-        }
+/// the bins of new_bins that differ from old_bins, followed by the bins that emptied with an amount of zero
+static std::vector<order_bin> get_changed_bins(const std::vector<order_bin>& old_bins, const std::vector<order_bin>& new_bins)
+{
+    std::map<graphene::chain::bet_multiplier_type, share_type> old_amounts;
+    for (const order_bin& bin : old_bins)
+        old_amounts[bin.backer_multiplier] = bin.amount_to_bet;
 
-        current_bin->amount_to_bet.amount += bet_odds_iter->amount_to_bet.amount;
+    std::vector<order_bin> result;
+    for (const order_bin& bin : new_bins)
+    {
+        auto old_iter = old_amounts.find(bin.backer_multiplier);
+        if (old_iter == old_amounts.end() || old_iter->second != bin.amount_to_bet)
+            result.push_back(bin);
+        if (old_iter != old_amounts.end())
+            old_amounts.erase(old_iter);
+    }
+    for (const auto& emptied_bin : old_amounts)
+    {
+        order_bin bin;
+        bin.backer_multiplier = emptied_bin.first;
+        bin.amount_to_bet = 0;
+        result.push_back(bin);
     }
-    if (current_bin)
-        flush_current_bin();
-
     return result;
 }
 
+void bookie_api_impl::subscribe_to_binned_order_book(std::function<void(const variant&)> callback, betting_market_id_type betting_market_id, int32_t precision)
+{
+    std::shared_ptr<graphene::chain::database> db = app.chain_database();
+    order_book_subscription subscription;
+    subscription.callback = callback;
+    subscription.precision = precision;
+    subscription.revision = get_order_book_index(*db).get_revision(betting_market_id);
+    subscription.order_book = get_binned_order_book(betting_market_id, precision);
+    _order_book_subscriptions[betting_market_id] = std::move(subscription);
+
+    if (!_applied_block_connection.connected())
+        _applied_block_connection = db->applied_block.connect([this](const signed_block&) { on_applied_block(); });
+}
+
+void bookie_api_impl::unsubscribe_from_binned_order_book(betting_market_id_type betting_market_id)
+{
+    _order_book_subscriptions.erase(betting_market_id);
+}
+
+void bookie_api_impl::on_applied_block()
+{
+    std::shared_ptr<graphene::chain::database> db = app.chain_database();
+    const bet_order_book_index& order_book_index = get_order_book_index(*db);
+
+    std::vector<std::pair<std::function<void(const variant&)>, binned_order_book>> updates;
+    for (auto& item : _order_book_subscriptions)
+    {
+        order_book_subscription& subscription = item.second;
+        uint64_t revision = order_book_index.get_revision(item.first);
+        if (revision == subscription.revision)
+            continue;
+
+        binned_order_book order_book = get_binned_order_book(item.first, subscription.precision);
+        binned_order_book changes;
+        changes.aggregated_back_bets = get_changed_bins(subscription.order_book.aggregated_back_bets, order_book.aggregated_back_bets);
+        changes.aggregated_lay_bets = get_changed_bins(subscription.order_book.aggregated_lay_bets, order_book.aggregated_lay_bets);
+        subscription.revision = revision;
+        subscription.order_book = std::move(order_book);
+        if (!changes.aggregated_back_bets.empty() || !changes.aggregated_lay_bets.empty())
+            updates.emplace_back(subscription.callback, std::move(changes));
+    }
+    if (updates.empty())
+        return;
+
+    /// we need to ensure the bookie_api is not deleted for the life of the async operation
+    auto capture_this = shared_from_this();
+    fc::async([capture_this, updates]() {
+        for (const auto& update : updates)
+            update.first(fc::variant(update.second, GRAPHENE_MAX_NESTED_OBJECTS));
+    });
+}
+
 fc::variants bookie_api_impl::get_objects(const vector<object_id_type>& ids) const
 {
    std::shared_ptr<graphene::chain::database> db = app.chain_database();
@@ -160,9 +235,9 @@ fc::variants bookie_api_impl::get_objects(const vector<object_id_type>& ids) con
             const auto &idx = db->get_index_type<event_object_index>();
             const auto &aidx = dynamic_cast<const base_primary_index &>(idx);
             const auto &refs = aidx.get_secondary_index<detail::persistent_event_index>();
-            auto iter = refs.ephemeral_event_object.find(id.as<event_id_type>());
-            if (iter != refs.ephemeral_event_object.end())
-               return iter->second.to_variant();
+            auto object = refs.ephemeral_event_object.find(id.as<event_id_type>());
+            if (object)
+               return object->to_variant();
             else
                return {};
          }
@@ -171,9 +246,9 @@ fc::variants bookie_api_impl::get_objects(const vector<object_id_type>& ids) con
             const auto &idx = db->get_index_type<bet_object_index>();
             const auto &aidx = dynamic_cast<const base_primary_index &>(idx);
             const auto &refs = aidx.get_secondary_index<detail::persistent_bet_index>();
-            auto iter = refs.internal.find(id.as<bet_id_type>());
-            if (iter != refs.internal.end())
-               return iter->second.ephemeral_bet_object.to_variant();
+            auto object = refs.internal.find(id.as<bet_id_type>());
+            if (object)
+               return object->ephemeral_bet_object.to_variant();
             else
                return {};
          }
@@ -182,9 +257,9 @@ fc::variants bookie_api_impl::get_objects(const vector<object_id_type>& ids) con
             const auto &idx = db->get_index_type<betting_market_object_index>();
             const auto &aidx = dynamic_cast<const base_primary_index &>(idx);
             const auto &refs = aidx.get_secondary_index<detail::persistent_betting_market_index>();
-            auto iter = refs.ephemeral_betting_market_object.find(id.as<betting_market_id_type>());
-            if (iter != refs.ephemeral_betting_market_object.end())
-               return iter->second.to_variant();
+            auto object = refs.ephemeral_betting_market_object.find(id.as<betting_market_id_type>());
+            if (object)
+               return object->to_variant();
             else
                return {};
          }
@@ -193,9 +268,9 @@ fc::variants bookie_api_impl::get_objects(const vector<object_id_type>& ids) con
             const auto &idx = db->get_index_type<betting_market_group_object_index>();
             const auto &aidx = dynamic_cast<const base_primary_index &>(idx);
             const auto &refs = aidx.get_secondary_index<detail::persistent_betting_market_group_index>();
-            auto iter = refs.internal.find(id.as<betting_market_group_id_type>());
-            if (iter != refs.internal.end())
-               return iter->second.ephemeral_betting_market_group_object.to_variant();
+            auto object = refs.internal.find(id.as<betting_market_group_id_type>());
+            if (object)
+               return object->ephemeral_betting_market_group_object.to_variant();
             else
                return {};
          }
@@ -207,6 +282,20 @@ fc::variants bookie_api_impl::get_objects(const vector<object_id_type>& ids) con
    return result;
 }
 
+static matched_bet_object make_matched_bet_object(const detail::persistent_bet_index::internal_type& bet)
+{
+   matched_bet_object match;
+   match.id = bet.ephemeral_bet_object.id;
+   match.bettor_id = bet.ephemeral_bet_object.bettor_id;
+   match.betting_market_id = bet.ephemeral_bet_object.betting_market_id;
+   match.amount_to_bet = bet.ephemeral_bet_object.amount_to_bet;
+   match.back_or_lay = bet.ephemeral_bet_object.back_or_lay;
+   match.end_of_delay = bet.ephemeral_bet_object.end_of_delay;
+   match.amount_matched = bet.amount_matched;
+   match.associated_operations = bet.associated_operations;
+   return match;
+}
+
 std::vector<matched_bet_object> bookie_api_impl::get_matched_bets_for_bettor(account_id_type bettor_id) const
 {
    std::vector<matched_bet_object> result;
@@ -215,22 +304,13 @@ std::vector<matched_bet_object> bookie_api_impl::get_matched_bets_for_bettor(acc
    const auto &aidx = dynamic_cast<const base_primary_index &>(idx);
    const auto &refs = aidx.get_secondary_index<detail::persistent_bet_index>();
 
-   for( const auto& bet_pair : refs.internal )
+   auto bettor_iter = refs.bets_by_bettor.lower_bound( std::make_pair( bettor_id, bet_id_type() ) );
+   for( ; bettor_iter != refs.bets_by_bettor.end() && bettor_iter->first == bettor_id; ++bettor_iter )
    {
-      const auto& bet = bet_pair.second;
-      if( bet.get_bettor_id() == bettor_id && bet.is_matched() )
-      {
-         matched_bet_object match;
-         match.id = bet.ephemeral_bet_object.id;
-         match.bettor_id = bet.ephemeral_bet_object.bettor_id;
-         match.betting_market_id = bet.ephemeral_bet_object.betting_market_id;
-         match.amount_to_bet = bet.ephemeral_bet_object.amount_to_bet;
-         match.back_or_lay = bet.ephemeral_bet_object.back_or_lay;
-         match.end_of_delay = bet.ephemeral_bet_object.end_of_delay;
-         match.amount_matched = bet.amount_matched;
-         match.associated_operations = bet.associated_operations;
-         result.emplace_back(std::move(match));
-      }
+      fc::optional<detail::persistent_bet_index::internal_type> bet = refs.internal.find( bettor_iter->second );
+      FC_ASSERT( bet.valid() );
+      if( bet->is_matched() )
+         result.emplace_back( make_matched_bet_object( *bet ) );
    }
 
    return result;
@@ -246,26 +326,14 @@ std::vector<matched_bet_object> bookie_api_impl::get_all_matched_bets_for_bettor
    const auto &aidx = dynamic_cast<const base_primary_index &>(idx);
    const auto &refs = aidx.get_secondary_index<detail::persistent_bet_index>();
 
-   for( const auto& bet_pair : refs.internal )
+   // start is the last bet of the previous page, so the page begins right after it
+   auto bettor_iter = refs.bets_by_bettor.upper_bound( std::make_pair( bettor_id, start ) );
+   for( ; bettor_iter != refs.bets_by_bettor.end() && bettor_iter->first == bettor_id && result.size() < limit; ++bettor_iter )
    {
-      const auto& bet_id = bet_pair.first;
-      const auto& bet = bet_pair.second;
-      if( bet.get_bettor_id() == bettor_id &&
-          bet.is_matched() &&
-          bet_id > start &&
-          result.size() < limit )
-      {
-         matched_bet_object match;
-         match.id = bet.ephemeral_bet_object.id;
-         match.bettor_id = bet.ephemeral_bet_object.bettor_id;
-         match.betting_market_id = bet.ephemeral_bet_object.betting_market_id;
-         match.amount_to_bet = bet.ephemeral_bet_object.amount_to_bet;
-         match.back_or_lay = bet.ephemeral_bet_object.back_or_lay;
-         match.end_of_delay = bet.ephemeral_bet_object.end_of_delay;
-         match.amount_matched = bet.amount_matched;
-         match.associated_operations = bet.associated_operations;
-         result.emplace_back(std::move(match));
-      }
+      fc::optional<detail::persistent_bet_index::internal_type> bet = refs.internal.find( bettor_iter->second );
+      FC_ASSERT( bet.valid() );
+      if( bet->is_matched() )
+         result.emplace_back( make_matched_bet_object( *bet ) );
    }
 
    return result;
@@ -281,9 +349,10 @@ asset bookie_api_impl::get_total_matched_bet_amount_for_betting_market_group(bet
     return get_plugin()->get_total_matched_bet_amount_for_betting_market_group(group_id);
 }
 
-std::vector<event_object> bookie_api_impl::get_events_containing_sub_string(const std::string& sub_string, const std::string& language)
+std::vector<event_object> bookie_api_impl::get_events_containing_sub_string(const std::string& sub_string, const std::string& language, unsigned limit)
 {
-   return get_plugin()->get_events_containing_sub_string(sub_string, language);
+   FC_ASSERT(limit <= 1000, "You may request at most 1000 events at a time");
+   return get_plugin()->get_events_containing_sub_string(sub_string, language, limit);
 }
 
 } // detail
@@ -298,6 +367,16 @@ binned_order_book bookie_api::get_binned_order_book(graphene::chain::betting_mar
    return my->get_binned_order_book(betting_market_id, precision);
 }
 
+void bookie_api::subscribe_to_binned_order_book(std::function<void(const variant&)> callback, betting_market_id_type betting_market_id, int32_t precision)
+{
+   my->subscribe_to_binned_order_book(callback, betting_market_id, precision);
+}
+
+void bookie_api::unsubscribe_from_binned_order_book(betting_market_id_type betting_market_id)
+{
+   my->unsubscribe_from_binned_order_book(betting_market_id);
+}
+
 asset bookie_api::get_total_matched_bet_amount_for_betting_market_group(betting_market_group_id_type group_id)
 {
     return my->get_total_matched_bet_amount_for_betting_market_group(group_id);
@@ -305,7 +384,13 @@ asset bookie_api::get_total_matched_bet_amount_for_betting_market_group(betting_
 
 std::vector<event_object> bookie_api::get_events_containing_sub_string(const std::string& sub_string, const std::string& language)
 {
-   return my->get_events_containing_sub_string(sub_string, language);
+   return my->get_events_containing_sub_string(sub_string, language, 1000);
+}
+
+std::vector<event_object> bookie_api::get_first_events_containing_sub_string(const std::string& sub_string, const std::string& language,
+                                                                              unsigned limit)
+{
+   return my->get_events_containing_sub_string(sub_string, language, limit);
 }
 
 fc::variants bookie_api::get_objects(const vector<object_id_type>& ids) const
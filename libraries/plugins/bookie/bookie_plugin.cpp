@@ -35,6 +35,7 @@
 #include <graphene/chain/transaction_evaluation_state.hpp>
 
 #include <boost/algorithm/string/case_conv.hpp>
+#include <boost/filesystem/path.hpp>
 
 #include <fc/thread/thread.hpp>
 
@@ -63,18 +64,67 @@ namespace detail
 void persistent_bet_index::object_inserted(const object& obj)
 {
    const bet_object& bet_obj = *boost::polymorphic_downcast<const bet_object*>(&obj);
-   if(0 == internal.count(bet_obj.id))
-      internal.insert( {bet_obj.id, bet_obj} );
-   else
-      internal[bet_obj.id] = bet_obj;
+   if (!internal.modify(bet_obj.id, [&](internal_type& bet) { bet = bet_obj; }))
+      internal.store(bet_obj.id, bet_obj);
+   bets_by_bettor.insert( {bet_obj.bettor_id, bet_obj.id} );
 }
 void persistent_bet_index::object_modified(const object& after)
 {
    const bet_object& bet_obj = *boost::polymorphic_downcast<const bet_object*>(&after);
-   auto iter = internal.find(bet_obj.id);
-   assert (iter != internal.end());
-   if (iter != internal.end())
-      iter->second = bet_obj;
+   bool found = internal.modify(bet_obj.id, [&](internal_type& bet) {
+      if (bet.get_bettor_id() != bet_obj.bettor_id)
+         bets_by_bettor.erase( {bet.get_bettor_id(), bet_obj.id} );
+      bet = bet_obj;
+   });
+   if (!found && internal.contains(bet_obj.id))
+   {
+      // it could not be read back from the history log, start over from the current object
+      internal.store(bet_obj.id, bet_obj);
+      found = true;
+   }
+   assert(found);
+   if (found)
+      bets_by_bettor.insert( {bet_obj.bettor_id, bet_obj.id} );
+}
+
+void bet_order_book_index::adjust(const bet_object& bet, bool add)
+{
+   if (bet.end_of_delay)
+      return;
+   order_book_levels& book = order_books[bet.betting_market_id];
+   auto& levels = bet.back_or_lay == bet_type::back ? book.back_bets : book.lay_bets;
+   share_type& level = levels[bet.backer_multiplier];
+   if (add)
+      level += bet.amount_to_bet.amount;
+   else
+      level -= bet.amount_to_bet.amount;
+   if (level == 0)
+      levels.erase(bet.backer_multiplier);
+   if (book.back_bets.empty() && book.lay_bets.empty())
+      order_books.erase(bet.betting_market_id);
+   else
+      book.revision = ++_last_revision;
+}
+void bet_order_book_index::object_inserted(const object& obj)
+{
+   adjust(*boost::polymorphic_downcast<const bet_object*>(&obj), true);
+}
+void bet_order_book_index::object_removed(const object& obj)
+{
+   adjust(*boost::polymorphic_downcast<const bet_object*>(&obj), false);
+}
+void bet_order_book_index::about_to_modify(const object& before)
+{
+   adjust(*boost::polymorphic_downcast<const bet_object*>(&before), false);
+}
+void bet_order_book_index::object_modified(const object& after)
+{
+   adjust(*boost::polymorphic_downcast<const bet_object*>(&after), true);
+}
+uint64_t bet_order_book_index::get_revision(betting_market_id_type betting_market_id) const
+{
+   auto iter = order_books.find(betting_market_id);
+   return iter == order_books.end() ? 0 : iter->second.revision;
 }
 
 //////////// end bet_object ///////////////////
@@ -82,19 +132,14 @@ void persistent_bet_index::object_modified(const object& after)
 void persistent_betting_market_index::object_inserted(const object& obj)
 {
    const betting_market_object& betting_market_obj = *boost::polymorphic_downcast<const betting_market_object*>(&obj);
-   if(0 == ephemeral_betting_market_object.count(betting_market_obj.id))
-      ephemeral_betting_market_object.insert( {betting_market_obj.id, betting_market_obj} );
-   else
-      ephemeral_betting_market_object[betting_market_obj.id] = betting_market_obj;
-
+   ephemeral_betting_market_object.store(betting_market_obj.id, betting_market_obj);
 }
 void persistent_betting_market_index::object_modified(const object& after)
 {
    const betting_market_object& betting_market_obj = *boost::polymorphic_downcast<const betting_market_object*>(&after);
-   auto iter = ephemeral_betting_market_object.find(betting_market_obj.id);
-   assert (iter != ephemeral_betting_market_object.end());
-   if (iter != ephemeral_betting_market_object.end())
-      iter->second = betting_market_obj;
+   assert(ephemeral_betting_market_object.contains(betting_market_obj.id));
+   if (ephemeral_betting_market_object.contains(betting_market_obj.id))
+      ephemeral_betting_market_object.store(betting_market_obj.id, betting_market_obj);
 }
 
 //////////// end betting_market_object ///////////////////
@@ -102,18 +147,16 @@ void persistent_betting_market_index::object_modified(const object& after)
 void persistent_betting_market_group_index::object_inserted(const object& obj)
 {
    const betting_market_group_object& betting_market_group_obj = *boost::polymorphic_downcast<const betting_market_group_object*>(&obj);
-   if(0 == internal.count(betting_market_group_obj.id))
-      internal.insert( {betting_market_group_obj.id, betting_market_group_obj} );
-   else
-      internal[betting_market_group_obj.id] = betting_market_group_obj;
+   if (!internal.modify(betting_market_group_obj.id, [&](internal_type& group) { group = betting_market_group_obj; }))
+      internal.store(betting_market_group_obj.id, betting_market_group_obj);
 }
 void persistent_betting_market_group_index::object_modified(const object& after)
 {
    const betting_market_group_object& betting_market_group_obj = *boost::polymorphic_downcast<const betting_market_group_object*>(&after);
-   auto iter = internal.find(betting_market_group_obj.id);
-   assert (iter != internal.end());
-   if (iter != internal.end())
-      iter->second = betting_market_group_obj;
+   assert(internal.contains(betting_market_group_obj.id));
+   if (!internal.modify(betting_market_group_obj.id, [&](internal_type& group) { group = betting_market_group_obj; }) &&
+       internal.contains(betting_market_group_obj.id))
+      internal.store(betting_market_group_obj.id, betting_market_group_obj);
 }
 
 //////////// end betting_market_group_object ///////////////////
@@ -121,18 +164,109 @@ void persistent_betting_market_group_index::object_modified(const object& after)
 void persistent_event_index::object_inserted(const object& obj)
 {
    const event_object& event_obj = *boost::polymorphic_downcast<const event_object*>(&obj);
-   if(0 == ephemeral_event_object.count(event_obj.id))
-      ephemeral_event_object.insert( {event_obj.id, event_obj} );
-   else
-      ephemeral_event_object[event_obj.id] = event_obj;
+   ephemeral_event_object.store(event_obj.id, event_obj);
 }
 void persistent_event_index::object_modified(const object& after)
 {
    const event_object& event_obj = *boost::polymorphic_downcast<const event_object*>(&after);
-   auto iter = ephemeral_event_object.find(event_obj.id);
-   assert (iter != ephemeral_event_object.end());
-   if (iter != ephemeral_event_object.end())
-      iter->second = event_obj;
+   assert(ephemeral_event_object.contains(event_obj.id));
+   if (ephemeral_event_object.contains(event_obj.id))
+      ephemeral_event_object.store(event_obj.id, event_obj);
+}
+
+static flat_set<uint32_t> get_trigrams(const std::string& s)
+{
+   flat_set<uint32_t> trigrams;
+   for (size_t i = 0; i + 3 <= s.size(); ++i)
+      trigrams.insert((uint32_t(uint8_t(s[i])) << 16) | (uint32_t(uint8_t(s[i + 1])) << 8) | uint32_t(uint8_t(s[i + 2])));
+   return trigrams;
+}
+
+void event_name_index::add(const event_object& event_obj)
+{
+   remove(event_obj.id);
+   for (const std::pair<std::string, std::string>& pair : event_obj.name)
+   {
+      language_index& language = languages[pair.first];
+      std::string lower_case_name = boost::algorithm::to_lower_copy(pair.second);
+      for (uint32_t trigram : get_trigrams(lower_case_name))
+         language.events_by_trigram[trigram].insert(event_obj.id);
+      language.names[event_obj.id] = std::move(lower_case_name);
+   }
+}
+void event_name_index::remove(event_id_type event_id)
+{
+   for (auto language_iter = languages.begin(); language_iter != languages.end(); )
+   {
+      language_index& language = language_iter->second;
+      auto name_iter = language.names.find(event_id);
+      if (name_iter != language.names.end())
+      {
+         for (uint32_t trigram : get_trigrams(name_iter->second))
+         {
+            auto trigram_iter = language.events_by_trigram.find(trigram);
+            trigram_iter->second.erase(event_id);
+            if (trigram_iter->second.empty())
+               language.events_by_trigram.erase(trigram_iter);
+         }
+         language.names.erase(name_iter);
+      }
+      if (language.names.empty())
+         language_iter = languages.erase(language_iter);
+      else
+         ++language_iter;
+   }
+}
+void event_name_index::object_inserted(const object& obj)
+{
+   add(*boost::polymorphic_downcast<const event_object*>(&obj));
+}
+void event_name_index::object_removed(const object& obj)
+{
+   remove(obj.id);
+}
+void event_name_index::object_modified(const object& after)
+{
+   add(*boost::polymorphic_downcast<const event_object*>(&after));
+}
+vector<event_id_type> event_name_index::find_events(const std::string& sub_string, const std::string& language, size_t limit) const
+{
+   vector<event_id_type> result;
+   auto language_iter = languages.find(language);
+   if (language_iter == languages.end())
+      return result;
+   const language_index& index = language_iter->second;
+   std::string lower_case_sub_string = boost::algorithm::to_lower_copy(sub_string);
+
+   // too short to have a trigram, so every name has to be checked
+   if (lower_case_sub_string.size() < 3)
+   {
+      for (auto name_iter = index.names.begin(); name_iter != index.names.end() && result.size() < limit; ++name_iter)
+         if (name_iter->second.find(lower_case_sub_string) != std::string::npos)
+            result.push_back(name_iter->first);
+      return result;
+   }
+
+   vector<const flat_set<event_id_type>*> events_by_trigram;
+   for (uint32_t trigram : get_trigrams(lower_case_sub_string))
+   {
+      auto trigram_iter = index.events_by_trigram.find(trigram);
+      if (trigram_iter == index.events_by_trigram.end())
+         return result;
+      events_by_trigram.push_back(&trigram_iter->second);
+   }
+   std::sort(events_by_trigram.begin(), events_by_trigram.end(),
+             [](const flat_set<event_id_type>* a, const flat_set<event_id_type>* b) { return a->size() < b->size(); });
+
+   for (auto event_iter = events_by_trigram.front()->begin(); event_iter != events_by_trigram.front()->end() && result.size() < limit; ++event_iter)
+   {
+      bool has_all_trigrams = std::all_of(events_by_trigram.begin() + 1, events_by_trigram.end(),
+                                          [&](const flat_set<event_id_type>* events) { return events->count(*event_iter) != 0; });
+      // the trigrams may be spread over the name, so the name itself decides
+      if (has_all_trigrams && index.names.at(*event_iter).find(lower_case_sub_string) != std::string::npos)
+         result.push_back(*event_iter);
+   }
+   return result;
 }
 
 //////////// end event_object ///////////////////
@@ -160,29 +294,13 @@ class bookie_plugin_impl
 
       asset get_total_matched_bet_amount_for_betting_market_group(betting_market_group_id_type group_id);
 
-      void fill_localized_event_strings();
-
-      std::vector<event_object> get_events_containing_sub_string(const std::string& sub_string, const std::string& language);
+      std::vector<event_object> get_events_containing_sub_string(const std::string& sub_string, const std::string& language, unsigned limit);
 
       graphene::chain::database& database()
       {
          return _self.database();
       }
 
-      //                1.18.          "Washington Capitals/Chicago Blackhawks"
-      typedef std::pair<event_id_type, std::string> event_string;
-      struct event_string_less : public std::less<const event_string&>
-      {
-          bool operator()(const event_string &_left, const event_string &_right) const
-          {
-              return (_left.first.instance < _right.first.instance);
-          }
-      };
-
-      typedef flat_set<event_string, event_string_less> event_string_set;
-      //       "en"
-      std::map<std::string, event_string_set> localized_event_strings;
-
       bookie_plugin& _self;
       flat_set<account_id_type> _tracked_accounts;
 };
@@ -240,67 +358,45 @@ void bookie_plugin_impl::on_block_applied( const signed_block& )
          const auto &refs_bet_object = aidx_bet_object.get_secondary_index<detail::persistent_bet_index>();
          auto& nonconst_refs_bet_object = const_cast<persistent_bet_index&>(refs_bet_object);
 
-         auto bet_iter = nonconst_refs_bet_object.internal.find(bet_matched_op.bet_id);
-         assert(bet_iter != nonconst_refs_bet_object.internal.end());
-         if (bet_iter != nonconst_refs_bet_object.internal.end())
-         {
-            bet_iter->second.amount_matched += amount_bet.amount;
+         betting_market_id_type betting_market_id;
+         bool found = nonconst_refs_bet_object.internal.modify(bet_matched_op.bet_id, [&](persistent_bet_index::internal_type& bet) {
+            bet.amount_matched += amount_bet.amount;
             if (is_operation_history_object_stored(op.id))
-               bet_iter->second.associated_operations.emplace_back(op.id);
-
-            const bet_object& bet_obj = bet_iter->second.ephemeral_bet_object;
-
+               bet.associated_operations.emplace_back(op.id);
+            betting_market_id = bet.ephemeral_bet_object.betting_market_id;
+         });
+         assert(found);
+         if (found)
+         {
             const auto &idx_betting_market = db.get_index_type<betting_market_object_index>();
             const auto &aidx_betting_market = dynamic_cast<const base_primary_index &>(idx_betting_market);
             const auto &refs_betting_market = aidx_betting_market.get_secondary_index<detail::persistent_betting_market_index>();
-            auto persistent_betting_market_object_iter = refs_betting_market.ephemeral_betting_market_object.find(bet_obj.betting_market_id);
-            FC_ASSERT(persistent_betting_market_object_iter != refs_betting_market.ephemeral_betting_market_object.end());
-            const betting_market_object& betting_market = persistent_betting_market_object_iter->second;
+            fc::optional<betting_market_object> betting_market = refs_betting_market.ephemeral_betting_market_object.find(betting_market_id);
+            if (!betting_market.valid())
+            {
+               elog("bookie plugin: betting market ${m} of bet ${b} is missing from the history, not counting its matched amount",
+                    ("m", betting_market_id)("b", bet_matched_op.bet_id));
+               continue;
+            }
 
             const auto &idx_betting_market_group = db.get_index_type<betting_market_group_object_index>();
             const auto &aidx_betting_market_group = dynamic_cast<const base_primary_index &>(idx_betting_market_group);
             const auto &refs_betting_market_group = aidx_betting_market_group.get_secondary_index<detail::persistent_betting_market_group_index>();
             auto& nonconst_refs_betting_market_group = const_cast<persistent_betting_market_group_index&>(refs_betting_market_group);
-            auto persistent_betting_market_group_object_iter = nonconst_refs_betting_market_group.internal.find(betting_market.group_id);
-            FC_ASSERT(persistent_betting_market_group_object_iter != nonconst_refs_betting_market_group.internal.end());
-            const betting_market_group_object& betting_market_group = persistent_betting_market_group_object_iter->second.ephemeral_betting_market_group_object;
+            FC_ASSERT(nonconst_refs_betting_market_group.internal.contains(betting_market->group_id));
 
             // if the object is still in the main database, keep the running total there
             // otherwise, add it directly to the persistent version
             auto& betting_market_group_idx = db.get_index_type<betting_market_group_object_index>().indices().get<by_id>();
-            auto betting_market_group_iter = betting_market_group_idx.find(betting_market_group.id);
+            auto betting_market_group_iter = betting_market_group_idx.find(betting_market->group_id);
             if (betting_market_group_iter != betting_market_group_idx.end())
                db.modify( *betting_market_group_iter, [&]( betting_market_group_object& obj ){
                   obj.total_matched_bets_amount += amount_bet.amount;
                });
             else
-               persistent_betting_market_group_object_iter->second.total_matched_bets_amount += amount_bet.amount;
-         }
-      }
-      else if( op.op.which() == operation::tag<event_create_operation>::value )
-      {
-         FC_ASSERT(op.result.which() == operation_result::tag<object_id_type>::value);
-         //object_id_type object_id = op.result.get<object_id_type>();
-         event_id_type object_id = op.result.get<object_id_type>();
-         FC_ASSERT( db.find_object(object_id), "invalid event specified" );
-         const event_create_operation& event_create_op = op.op.get<event_create_operation>();
-         for(const std::pair<std::string, std::string>& pair : event_create_op.name)
-            localized_event_strings[pair.first].insert(event_string(object_id, pair.second));
-      }
-      else if( op.op.which() == operation::tag<event_update_operation>::value )
-      {
-         const event_update_operation& event_create_op = op.op.get<event_update_operation>();
-         if (!event_create_op.new_name.valid())
-            continue;
-         event_id_type event_id = event_create_op.event_id;
-         for(const std::pair<std::string, std::string>& pair : *event_create_op.new_name)
-         {
-            // try insert
-            std::pair<event_string_set::iterator, bool> result =
-               localized_event_strings[pair.first].insert(event_string(event_id, pair.second));
-            if (!result.second)
-               //  update string only
-               result.first->second = pair.second;
+               nonconst_refs_betting_market_group.internal.modify(betting_market->group_id, [&](persistent_betting_market_group_index::internal_type& group) {
+                  group.total_matched_bets_amount += amount_bet.amount;
+               });
          }
       }
       else if ( op.op.which() == operation::tag<bet_canceled_operation>::value )
@@ -311,14 +407,12 @@ void bookie_plugin_impl::on_block_applied( const signed_block& )
          const auto &refs_bet_object = aidx_bet_object.get_secondary_index<detail::persistent_bet_index>();
          auto& nonconst_refs_bet_object = const_cast<persistent_bet_index&>(refs_bet_object);
 
-         auto bet_iter = nonconst_refs_bet_object.internal.find(bet_canceled_op.bet_id);
-         assert(bet_iter != nonconst_refs_bet_object.internal.end());
-         if (bet_iter != nonconst_refs_bet_object.internal.end())
-         {
+         assert(nonconst_refs_bet_object.internal.contains(bet_canceled_op.bet_id));
+         nonconst_refs_bet_object.internal.modify(bet_canceled_op.bet_id, [&](persistent_bet_index::internal_type& bet) {
             // ilog("Adding bet_canceled_operation ${canceled_id} to bet ${bet_id}'s associated operations", 
             //     ("canceled_id", op.id)("bet_id", bet_canceled_op.bet_id));
-            bet_iter->second.associated_operations.emplace_back(op.id);
-         }
+            bet.associated_operations.emplace_back(op.id);
+         });
       }
       else if ( op.op.which() == operation::tag<bet_adjusted_operation>::value )
       {
@@ -328,50 +422,25 @@ void bookie_plugin_impl::on_block_applied( const signed_block& )
          const auto &refs_bet_object = aidx_bet_object.get_secondary_index<detail::persistent_bet_index>();
          auto& nonconst_refs_bet_object = const_cast<persistent_bet_index&>(refs_bet_object);
 
-         auto bet_iter = nonconst_refs_bet_object.internal.find(bet_adjusted_op.bet_id);
-         assert(bet_iter != nonconst_refs_bet_object.internal.end());
-         if (bet_iter != nonconst_refs_bet_object.internal.end())
-         {
+         assert(nonconst_refs_bet_object.internal.contains(bet_adjusted_op.bet_id));
+         nonconst_refs_bet_object.internal.modify(bet_adjusted_op.bet_id, [&](persistent_bet_index::internal_type& bet) {
             // ilog("Adding bet_adjusted_operation ${adjusted_id} to bet ${bet_id}'s associated operations", 
             //     ("adjusted_id", op.id)("bet_id", bet_adjusted_op.bet_id));
-            bet_iter->second.associated_operations.emplace_back(op.id);
-         }
+            bet.associated_operations.emplace_back(op.id);
+         });
       }
 
    }
 } FC_RETHROW_EXCEPTIONS( warn, "" ) }
 
-void bookie_plugin_impl::fill_localized_event_strings()
-{
-       graphene::chain::database& db = database();
-       const auto& event_index = db.get_index_type<event_object_index>().indices().get<by_id>();
-       auto event_itr = event_index.cbegin();
-       while (event_itr != event_index.cend())
-       {
-           const event_object& event_obj = *event_itr;
-           ++event_itr;
-           for(const std::pair<std::string, std::string>& pair : event_obj.name)
-           {
-                localized_event_strings[pair.first].insert(event_string(event_obj.id, pair.second));
-           }
-       }
-}
-
-std::vector<event_object> bookie_plugin_impl::get_events_containing_sub_string(const std::string& sub_string, const std::string& language)
+std::vector<event_object> bookie_plugin_impl::get_events_containing_sub_string(const std::string& sub_string, const std::string& language, unsigned limit)
 {
    graphene::chain::database& db = database();
+   const auto &aidx = dynamic_cast<const base_primary_index &>(db.get_index_type<event_object_index>());
+   const auto &event_names = aidx.get_secondary_index<detail::event_name_index>();
    std::vector<event_object> events;
-   if (localized_event_strings.find(language) != localized_event_strings.end())
-   {
-      std::string lower_case_sub_string = boost::algorithm::to_lower_copy(sub_string);
-      const event_string_set& language_set = localized_event_strings[language];
-      for (const event_string& pair : language_set)
-      {
-         std::string lower_case_string = boost::algorithm::to_lower_copy(pair.second);
-         if (lower_case_string.find(lower_case_sub_string) != std::string::npos)
-            events.push_back(pair.first(db));
-      }
-   }
+   for (event_id_type event_id : event_names.find_events(sub_string, language, limit))
+      events.push_back(event_id(db));
    return events;
 }
 
@@ -404,7 +473,15 @@ void bookie_plugin::plugin_set_program_options(boost::program_options::options_d
    //cli.add_options()
    //      ("track-account", boost::program_options::value<std::vector<std::string>>()->composing()->multitoken(), "Account ID to track history for (may specify multiple times)")
    //      ;
-   //cfg.add(cli);
+   cli.add_options()
+         ("bookie-history-dir", boost::program_options::value<boost::filesystem::path>(),
+          "Directory to keep the bookie history of bets, betting markets and events in, rebuilt from the chain on every start. "
+          "Defaults to bookie under the data dir; an empty value, or running without a data dir, keeps the history in memory "
+          "as earlier versions did")
+         ("bookie-history-cache-size", boost::program_options::value<uint32_t>()->default_value(256),
+          "Memory budget in MiB for the bookie history objects cached out of the bookie-history-dir")
+         ;
+   cfg.add(cli);
 }
 
 void bookie_plugin::plugin_initialize(const boost::program_options::variables_map& options)
@@ -418,19 +495,46 @@ void bookie_plugin::plugin_initialize(const boost::program_options::variables_ma
 
     const primary_index<bet_object_index>& bet_object_idx = database().get_index_type<primary_index<bet_object_index> >();
     primary_index<bet_object_index>& nonconst_bet_object_idx = const_cast<primary_index<bet_object_index>&>(bet_object_idx);
-    nonconst_bet_object_idx.add_secondary_index<detail::persistent_bet_index>();
+    detail::persistent_bet_index* bet_history = nonconst_bet_object_idx.add_secondary_index<detail::persistent_bet_index>();
+    nonconst_bet_object_idx.add_secondary_index<detail::bet_order_book_index>();
 
     const primary_index<betting_market_object_index>& betting_market_object_idx = database().get_index_type<primary_index<betting_market_object_index> >();
     primary_index<betting_market_object_index>& nonconst_betting_market_object_idx = const_cast<primary_index<betting_market_object_index>&>(betting_market_object_idx);
-    nonconst_betting_market_object_idx.add_secondary_index<detail::persistent_betting_market_index>();
+    detail::persistent_betting_market_index* betting_market_history = nonconst_betting_market_object_idx.add_secondary_index<detail::persistent_betting_market_index>();
 
     const primary_index<betting_market_group_object_index>& betting_market_group_object_idx = database().get_index_type<primary_index<betting_market_group_object_index> >();
     primary_index<betting_market_group_object_index>& nonconst_betting_market_group_object_idx = const_cast<primary_index<betting_market_group_object_index>&>(betting_market_group_object_idx);
-    nonconst_betting_market_group_object_idx.add_secondary_index<detail::persistent_betting_market_group_index>();
+    detail::persistent_betting_market_group_index* betting_market_group_history = nonconst_betting_market_group_object_idx.add_secondary_index<detail::persistent_betting_market_group_index>();
 
     const primary_index<event_object_index>& event_object_idx = database().get_index_type<primary_index<event_object_index> >();
     primary_index<event_object_index>& nonconst_event_object_idx = const_cast<primary_index<event_object_index>&>(event_object_idx);
-    nonconst_event_object_idx.add_secondary_index<detail::persistent_event_index>();
+    detail::persistent_event_index* event_history = nonconst_event_object_idx.add_secondary_index<detail::persistent_event_index>();
+    nonconst_event_object_idx.add_secondary_index<detail::event_name_index>();
+
+    fc::path history_dir;
+    if (options.count("bookie-history-dir"))
+       history_dir = options.at("bookie-history-dir").as<boost::filesystem::path>();
+    else if (options.count("data-dir"))
+       history_dir = fc::path(options.at("data-dir").as<boost::filesystem::path>()) / "bookie";
+    if (history_dir != fc::path())
+    {
+       // bets make up most of the history, the rest of the budget is shared by the others
+       size_t cache_size = size_t(options.at("bookie-history-cache-size").as<uint32_t>()) * 1024 * 1024;
+       try
+       {
+          bet_history->internal.open(history_dir / "bets.log", cache_size / 2);
+          betting_market_history->ephemeral_betting_market_object.open(history_dir / "betting_markets.log", cache_size / 6);
+          betting_market_group_history->internal.open(history_dir / "betting_market_groups.log", cache_size / 6);
+          event_history->ephemeral_event_object.open(history_dir / "events.log", cache_size / 6);
+          ilog("bookie plugin: keeping history in ${d}", ("d", history_dir));
+       }
+       catch (const fc::exception& e)
+       {
+          // the histories that could not be opened are kept in memory, as they are without a history dir
+          elog("bookie plugin: unable to keep all of the history in ${d}, keeping the rest in memory: ${e}",
+               ("d", history_dir)("e", e.to_detail_string()));
+       }
+    }
 
     ilog("bookie plugin: plugin_startup() end");
  }
@@ -438,7 +542,6 @@ void bookie_plugin::plugin_initialize(const boost::program_options::variables_ma
 void bookie_plugin::plugin_startup()
 {
    ilog("bookie plugin: plugin_startup()");
-    my->fill_localized_event_strings();
 }
 
 flat_set<account_id_type> bookie_plugin::tracked_accounts() const
@@ -451,10 +554,10 @@ asset bookie_plugin::get_total_matched_bet_amount_for_betting_market_group(betti
      ilog("bookie plugin: get_total_matched_bet_amount_for_betting_market_group($group_id)", ("group_d", group_id));
      return my->get_total_matched_bet_amount_for_betting_market_group(group_id);
 }
-std::vector<event_object> bookie_plugin::get_events_containing_sub_string(const std::string& sub_string, const std::string& language)
+std::vector<event_object> bookie_plugin::get_events_containing_sub_string(const std::string& sub_string, const std::string& language, unsigned limit)
 {
-    ilog("bookie plugin: get_events_containing_sub_string(${sub_string}, ${language})", (sub_string)(language));
-    return my->get_events_containing_sub_string(sub_string, language);
+    ilog("bookie plugin: get_events_containing_sub_string(${sub_string}, ${language}, ${limit})", (sub_string)(language)(limit));
+    return my->get_events_containing_sub_string(sub_string, language, limit);
 }
 
 } }
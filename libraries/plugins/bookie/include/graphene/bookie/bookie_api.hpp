@@ -88,8 +88,23 @@ class bookie_api
        * precision = 2 would bin on (1 - 1.01], (1.01 - 1.02]
        */
       binned_order_book get_binned_order_book(graphene::chain::betting_market_id_type betting_market_id, int32_t precision);
+      /**
+       * Calls callback after each block that changed the binned order book of the betting market, with a
+       * binned_order_book holding only the bins that changed.  Bins that emptied are sent with an amount of zero.
+       * Subscribing to a betting market again replaces its callback and precision.
+       */
+      void subscribe_to_binned_order_book(std::function<void(const variant&)> callback, graphene::chain::betting_market_id_type betting_market_id, int32_t precision);
+      void unsubscribe_from_binned_order_book(graphene::chain::betting_market_id_type betting_market_id);
       asset get_total_matched_bet_amount_for_betting_market_group(betting_market_group_id_type group_id);
+      /**
+       * Returns the first 1000 events whose name in the language contains sub_string, ignoring case, in id order.
+       */
       std::vector<event_object> get_events_containing_sub_string(const std::string& sub_string, const std::string& language);
+      /**
+       * Returns the first limit events whose name in the language contains sub_string, ignoring case, in id order.
+       * A limit of at most 1000 may be requested; a result of limit events may have left out further matches.
+       */
+      std::vector<event_object> get_first_events_containing_sub_string(const std::string& sub_string, const std::string& language, unsigned limit);
       fc::variants get_objects(const vector<object_id_type>& ids)const;
       std::vector<matched_bet_object> get_matched_bets_for_bettor(account_id_type bettor_id) const;
       std::vector<matched_bet_object> get_all_matched_bets_for_bettor(account_id_type bettor_id, bet_id_type start = bet_id_type(), unsigned limit = 1000) const;
@@ -104,8 +119,11 @@ FC_REFLECT(graphene::bookie::matched_bet_object, (id)(bettor_id)(betting_market_
 
 FC_API(graphene::bookie::bookie_api,
        (get_binned_order_book)
+       (subscribe_to_binned_order_book)
+       (unsubscribe_from_binned_order_book)
        (get_total_matched_bet_amount_for_betting_market_group)
        (get_events_containing_sub_string)
+       (get_first_events_containing_sub_string)
        (get_objects)
        (get_matched_bets_for_bettor)
        (get_all_matched_bets_for_bettor))
@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <fc/exception/exception.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/optional.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <vector>
+
+namespace graphene { namespace bookie { namespace detail {
+
+/**
+ *  @brief Keeps the latest version of each object of a bookie history, either in memory or in a log file
+ *
+ *  Until open() is called everything is kept in memory, which is what the history has always done.
+ *  Once opened, every version stored is appended to the log and only its location in the log is kept
+ *  for each key, next to a cache of the most recently used objects that is kept within the given
+ *  memory budget.  Once superseded versions make up most of the log, a copy with just the latest
+ *  versions is written on a thread of its own and takes the place of the log at a later store().
+ *
+ *  The history is filled from secondary index callbacks while blocks are applied, so I/O errors are
+ *  logged and never thrown: an object that can not be written is kept in memory instead, and one that
+ *  can not be read back is reported as missing.
+ *
+ *  The history is rebuilt from the chain every time the node starts, so the log is emptied on open().
+ */
+template<typename Key, typename Value>
+class history_store
+{
+public:
+   ~history_store()
+   {
+      try {
+         close();
+      } FC_CAPTURE_AND_LOG( (_filename) )
+   }
+
+   void open( const fc::path& filename, size_t cache_size_limit )
+   { try {
+      close();
+      if( filename.parent_path() != fc::path() )
+         fc::create_directories( filename.parent_path() );
+      _filename = filename;
+      _cache_size_limit = cache_size_limit;
+      _file.open( _filename.generic_string(), std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc );
+      FC_ASSERT( _file.is_open(), "Unable to open bookie history file ${f}", ("f", _filename) );
+      _is_open = true;
+      _file_size = 0;
+      _live_size = 0;
+      // objects stored so far were only ever kept in memory, move them to the log
+      std::map<Key, cache_entry> in_memory;
+      std::swap( in_memory, _cache );
+      _lru.clear();
+      _cache_size = 0;
+      for( const auto& item : in_memory )
+         store( item.first, item.second.value );
+   } FC_CAPTURE_AND_RETHROW( (filename) ) }
+
+   void close()
+   {
+      if( !_is_open )
+         return;
+      // a compaction still running is of no use any more
+      if( _compaction.valid() )
+         _compaction.wait();
+      _compaction = std::future<compaction_result>();
+      _is_open = false;
+      _file.close();
+      fc::remove_all( _filename );
+      fc::remove_all( temp_filename() );
+      _locations.clear();
+      _unlogged.clear();
+      _cache.clear();
+      _lru.clear();
+      _cache_size = 0;
+   }
+
+   bool is_open() const { return _is_open; }
+
+   size_t size() const { return is_open() ? _locations.size() + _unlogged.size() : _cache.size(); }
+
+   bool contains( const Key& key ) const
+   {
+      if( !is_open() )
+         return _cache.count( key ) != 0;
+      return _locations.count( key ) != 0 || _unlogged.count( key ) != 0;
+   }
+
+   /// the latest version stored for the key, read back from the log if it is not cached
+   fc::optional<Value> find( const Key& key ) const
+   {
+      auto unlogged_iter = _unlogged.find( key );
+      if( unlogged_iter != _unlogged.end() )
+         return unlogged_iter->second;
+      auto cache_iter = _cache.find( key );
+      if( cache_iter != _cache.end() )
+      {
+         touch( cache_iter->second );
+         return cache_iter->second.value;
+      }
+      if( !is_open() )
+         return fc::optional<Value>();
+      auto location_iter = _locations.find( key );
+      if( location_iter == _locations.end() )
+         return fc::optional<Value>();
+
+      try
+      {
+         std::vector<char> packed( location_iter->second.size );
+         _file.seekg( location_iter->second.offset );
+         _file.read( packed.data(), packed.size() );
+         FC_ASSERT( _file.good(), "Unable to read from bookie history file ${f}", ("f", _filename) );
+         Value value = fc::raw::unpack<Value>( packed );
+         cache( key, value, packed.size() );
+         return value;
+      }
+      catch( const fc::exception& e )
+      {
+         elog( "Unable to read ${k} back from bookie history file ${f}: ${e}", ("k", key)("f", _filename)("e", e.to_detail_string()) );
+         _file.clear();
+         return fc::optional<Value>();
+      }
+   }
+
+   void store( const Key& key, const Value& value )
+   {
+      size_t packed_size = fc::raw::pack_size( value );
+      if( is_open() )
+      {
+         finish_compaction();
+         std::vector<char> packed = fc::raw::pack( value );
+         _file.seekp( _file_size );
+         _file.write( packed.data(), packed.size() );
+         // flushed right away, so that a failure is put down to the object that was not written
+         _file.flush();
+         auto location_iter = _locations.find( key );
+         if( location_iter != _locations.end() )
+         {
+            _live_size -= location_iter->second.size;
+            _locations.erase( location_iter );
+         }
+         if( !_file.good() )
+         {
+            elog( "Unable to write ${k} to bookie history file ${f}, keeping it in memory", ("k", key)("f", _filename) );
+            _file.clear();
+            uncache( key );
+            _unlogged[key] = value;
+            return;
+         }
+         _unlogged.erase( key );
+         _locations[key] = record_location{ _file_size, packed.size() };
+         _file_size += packed.size();
+         _live_size += packed.size();
+      }
+      cache( key, value, packed_size );
+      if( is_open() && !_compaction.valid() && _file_size > 2 * _live_size + min_compaction_size )
+         start_compaction();
+   }
+
+   /// applies the modifier to the latest version and stores the result, returns false if there is none
+   bool modify( const Key& key, const std::function<void(Value&)>& modifier )
+   {
+      fc::optional<Value> value = find( key );
+      if( !value )
+         return false;
+      modifier( *value );
+      store( key, *value );
+      return true;
+   }
+
+   /// waits for a compaction that is running and puts its copy in place of the log
+   void wait_for_compaction()
+   {
+      if( !_compaction.valid() )
+         return;
+      _compaction.wait();
+      finish_compaction();
+   }
+
+private:
+   struct record_location
+   {
+      uint64_t offset;
+      size_t size;
+   };
+   struct cache_entry
+   {
+      Value value;
+      size_t size;
+      typename std::list<Key>::iterator lru_position;
+   };
+   struct compaction_result
+   {
+      /// where the copied records are in the copy, in the order of their offsets in the log
+      std::vector<std::pair<Key, record_location>> locations;
+      uint64_t size = 0;
+   };
+
+   /// a log smaller than this is never compacted
+   static const uint64_t min_compaction_size = 1024 * 1024;
+
+   fc::path temp_filename() const { return _filename.generic_string() + ".tmp"; }
+
+   void touch( cache_entry& entry ) const
+   {
+      _lru.splice( _lru.begin(), _lru, entry.lru_position );
+   }
+
+   void cache( const Key& key, const Value& value, size_t packed_size ) const
+   {
+      size_t entry_size = sizeof(Key) + sizeof(cache_entry) + packed_size;
+      auto cache_iter = _cache.find( key );
+      if( cache_iter != _cache.end() )
+      {
+         _cache_size -= cache_iter->second.size;
+         cache_iter->second.value = value;
+         cache_iter->second.size = entry_size;
+         touch( cache_iter->second );
+      }
+      else
+      {
+         _lru.push_front( key );
+         _cache.emplace( key, cache_entry{ value, entry_size, _lru.begin() } );
+      }
+      _cache_size += entry_size;
+
+      // everything stays cached until there is a log to read evicted objects back from
+      while( is_open() && _cache_size > _cache_size_limit && _lru.size() > 1 )
+      {
+         auto evicted = _cache.find( _lru.back() );
+         _cache_size -= evicted->second.size;
+         _cache.erase( evicted );
+         _lru.pop_back();
+      }
+   }
+
+   void remove_temp_file()
+   {
+      try {
+         fc::remove_all( temp_filename() );
+      } FC_CAPTURE_AND_LOG( (_filename) )
+   }
+
+   void uncache( const Key& key )
+   {
+      auto cache_iter = _cache.find( key );
+      if( cache_iter == _cache.end() )
+         return;
+      _cache_size -= cache_iter->second.size;
+      _lru.erase( cache_iter->second.lru_position );
+      _cache.erase( cache_iter );
+   }
+
+   /// copies the latest versions to a new file on a thread of its own, the log stays in use meanwhile
+   void start_compaction()
+   {
+      _file.flush();
+      if( !_file.good() )
+      {
+         _file.clear();
+         return;
+      }
+      std::vector<std::pair<Key, record_location>> records( _locations.begin(), _locations.end() );
+      _compaction_start_size = _file_size;
+      const fc::path filename = _filename;
+      const fc::path temp = temp_filename();
+      _compaction = std::async( std::launch::async, [filename, temp, records]() mutable {
+         return compact( filename, temp, std::move( records ) );
+      } );
+   }
+
+   static compaction_result compact( const fc::path& filename, const fc::path& temp,
+                                     std::vector<std::pair<Key, record_location>> records )
+   {
+      // in log order, so the log is read front to back
+      std::sort( records.begin(), records.end(), []( const std::pair<Key, record_location>& a,
+                                                     const std::pair<Key, record_location>& b ) {
+         return a.second.offset < b.second.offset;
+      } );
+      std::ifstream in( filename.generic_string(), std::ios::binary );
+      std::ofstream out( temp.generic_string(), std::ios::binary | std::ios::trunc );
+      FC_ASSERT( in.is_open() && out.is_open(), "Unable to open bookie history file ${f}", ("f", temp) );
+
+      compaction_result result;
+      result.locations.reserve( records.size() );
+      std::vector<char> packed;
+      uint64_t read_position = 0;
+      for( const auto& record : records )
+      {
+         if( record.second.offset != read_position )
+            in.seekg( record.second.offset );
+         packed.resize( record.second.size );
+         in.read( packed.data(), packed.size() );
+         out.write( packed.data(), packed.size() );
+         read_position = record.second.offset + record.second.size;
+         result.locations.emplace_back( record.first, record_location{ result.size, record.second.size } );
+         result.size += record.second.size;
+      }
+      out.flush();
+      FC_ASSERT( in.good() && out.good(), "Unable to write bookie history file ${f}", ("f", temp) );
+      return result;
+   }
+
+   /// puts the copy made by a finished compaction in place of the log, with what was stored since appended to it
+   void finish_compaction()
+   {
+      if( !_compaction.valid() || _compaction.wait_for( std::chrono::seconds(0) ) != std::future_status::ready )
+         return;
+      try
+      {
+         compaction_result result = _compaction.get();
+         std::vector<char> tail( _file_size - _compaction_start_size );
+         _file.seekg( _compaction_start_size );
+         _file.read( tail.data(), tail.size() );
+         FC_ASSERT( _file.good(), "Unable to read from bookie history file ${f}", ("f", _filename) );
+         {
+            std::ofstream out( temp_filename().generic_string(), std::ios::binary | std::ios::app );
+            out.write( tail.data(), tail.size() );
+            out.close();
+            FC_ASSERT( out, "Unable to write bookie history file ${f}", ("f", temp_filename()) );
+         }
+         _file.close();
+         fc::rename( temp_filename(), _filename );
+
+         // objects stored again since the copy was started are in the tail, which now follows the copied records
+         for( const auto& record : result.locations )
+         {
+            auto location_iter = _locations.find( record.first );
+            if( location_iter != _locations.end() && location_iter->second.offset < _compaction_start_size )
+               location_iter->second.offset = record.second.offset;
+         }
+         for( auto& location : _locations )
+            if( location.second.offset >= _compaction_start_size )
+               location.second.offset = location.second.offset - _compaction_start_size + result.size;
+         _file_size = result.size + tail.size();
+      }
+      catch( const fc::exception& e )
+      {
+         elog( "Unable to compact bookie history file ${f}, going on with the old one: ${e}", ("f", _filename)("e", e.to_detail_string()) );
+         remove_temp_file();
+      }
+      catch( const std::exception& e )
+      {
+         elog( "Unable to compact bookie history file ${f}, going on with the old one: ${e}", ("f", _filename)("e", e.what()) );
+         remove_temp_file();
+      }
+      _file.clear();
+      if( !_file.is_open() )
+      {
+         _file.open( _filename.generic_string(), std::ios::binary | std::ios::in | std::ios::out );
+         if( !_file.is_open() )
+            elog( "Unable to reopen bookie history file ${f}", ("f", _filename) );
+      }
+   }
+
+   fc::path                          _filename;
+   bool                              _is_open = false;
+   mutable std::fstream              _file;
+   uint64_t                          _file_size = 0;
+   /// bytes of the log holding the latest versions
+   uint64_t                          _live_size = 0;
+   std::map<Key, record_location>    _locations;
+   /// objects that could not be written to the log
+   std::map<Key, Value>              _unlogged;
+
+   std::future<compaction_result>    _compaction;
+   /// size of the log when the running compaction was started
+   uint64_t                          _compaction_start_size = 0;
+
+   size_t                            _cache_size_limit = 0;
+   mutable size_t                    _cache_size = 0;
+   mutable std::map<Key, cache_entry> _cache;
+   /// cached keys, most recently used first
+   mutable std::list<Key>            _lru;
+};
+
+} } } // graphene::bookie::detail
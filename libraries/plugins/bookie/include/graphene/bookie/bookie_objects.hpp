@@ -25,6 +25,7 @@
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/betting_market_object.hpp>
 #include <graphene/chain/event_object.hpp>
+#include <graphene/bookie/bookie_history_store.hpp>
 
 namespace graphene { namespace bookie {
 using namespace chain;
@@ -41,7 +42,39 @@ public:
    virtual void object_inserted( const object& obj ) override;
    virtual void object_modified( const object& after  ) override;
 
-   map< event_id_type, event_object > ephemeral_event_object;
+   history_store< event_id_type, event_object > ephemeral_event_object;
+};
+
+/**
+    *  @brief This secondary index finds events by a part of their name in one language
+    *
+    *  The lower case names are indexed by the trigrams (runs of three bytes) in them.  A search walks
+    *  the events of the rarest trigram of the sub string, keeps those that have all its other trigrams
+    *  and then checks their names, instead of checking the name of every event.
+ */
+class event_name_index : public secondary_index
+{
+public:
+   virtual void object_inserted( const object& obj ) override;
+   virtual void object_removed( const object& obj ) override;
+   virtual void object_modified( const object& after  ) override;
+
+   /// the events whose name in the language contains the sub string, ignoring case, in id order and at most limit of them
+   vector< event_id_type > find_events( const std::string& sub_string, const std::string& language, size_t limit ) const;
+
+private:
+   struct language_index
+   {
+      /// the lower case name of each event
+      map< event_id_type, std::string > names;
+      /// the events with each trigram in their name
+      map< uint32_t, flat_set< event_id_type > > events_by_trigram;
+   };
+
+   void add( const event_object& event_obj );
+   void remove( event_id_type event_id );
+
+   map< std::string, language_index > languages;
 };
 
 #if 0 // we no longer have competitors, just leaving this here as an example of how to do a secondary index
@@ -115,7 +148,7 @@ public:
    virtual void object_inserted( const object& obj ) override;
    virtual void object_modified( const object& after  ) override;
 
-   map< betting_market_group_id_type, internal_type > internal;
+   history_store< betting_market_group_id_type, internal_type > internal;
 };
 
 inline bool operator==(const persistent_betting_market_group_index::internal_type& lhs, const persistent_betting_market_group_index::internal_type& rhs)
@@ -142,7 +175,7 @@ public:
    virtual void object_inserted( const object& obj ) override;
    virtual void object_modified( const object& after  ) override;
 
-   map< betting_market_id_type, betting_market_object > ephemeral_betting_market_object;
+   history_store< betting_market_id_type, betting_market_object > ephemeral_betting_market_object;
 };
 
 /**
@@ -182,7 +215,44 @@ public:
    virtual void object_inserted( const object& obj ) override;
    virtual void object_modified( const object& after  ) override;
 
-   map< bet_id_type, internal_type > internal;
+   history_store< bet_id_type, internal_type > internal;
+   /// (bettor, bet) for every bet in internal, so the bets of one bettor can be paged through without a full scan
+   std::set< std::pair< account_id_type, bet_id_type > > bets_by_bettor;
+};
+
+/**
+    *  @brief This secondary index keeps the amount of the open bets at each odds of each betting market
+    *
+    *  Binned order books are built from these levels, one per distinct odds, instead of from every bet.
+    *  Bets still in their delay period are not on the books and are left out, like in the by_odds walk
+    *  this replaces.
+ */
+class bet_order_book_index : public secondary_index
+{
+public:
+   struct order_book_levels
+   {
+      /// total amount to bet at each backer multiplier
+      map< bet_multiplier_type, share_type > back_bets;
+      map< bet_multiplier_type, share_type > lay_bets;
+      /// changes whenever the levels do, and is never reused, so subscribers can tell whether they changed
+      uint64_t revision = 0;
+   };
+
+   virtual void object_inserted( const object& obj ) override;
+   virtual void object_removed( const object& obj ) override;
+   virtual void about_to_modify( const object& before ) override;
+   virtual void object_modified( const object& after  ) override;
+
+   /// the revision of the book of a betting market, 0 while it has no open bets
+   uint64_t get_revision( betting_market_id_type betting_market_id ) const;
+
+   map< betting_market_id_type, order_book_levels > order_books;
+
+private:
+   void adjust( const bet_object& bet, bool add );
+
+   uint64_t _last_revision = 0;
 };
 
 inline bool operator==(const persistent_bet_index::internal_type& lhs, const persistent_bet_index::internal_type& rhs)
@@ -202,3 +272,8 @@ inline bool operator>(const persistent_bet_index::internal_type& lhs, const pers
 
 } } } //graphene::bookie::detail
 
+FC_REFLECT( graphene::bookie::detail::persistent_betting_market_group_index::internal_type,
+            (ephemeral_betting_market_group_object)(total_matched_bets_amount) )
+FC_REFLECT( graphene::bookie::detail::persistent_bet_index::internal_type,
+            (ephemeral_bet_object)(amount_matched)(associated_operations) )
+
@@ -23,6 +23,7 @@
  */
 
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem/path.hpp>
 #include <graphene/elasticsearch/elasticsearch_plugin.hpp>
 #include <graphene/chain/impacted.hpp>
 #include <graphene/chain/account_evaluator.hpp>
@@ -78,7 +79,8 @@ class elasticsearch_plugin_impl
       vector <string> bulk_lines; //  vector of op lines
       vector<std::string> prepare;
 
-      graphene::utilities::ES es;
+      graphene::utilities::es_bulk_sender::options _sender_options;
+      std::unique_ptr<graphene::utilities::es_bulk_sender> _sender;
       uint32_t limit_documents;
       int16_t op_type;
       operation_history_struct os;
@@ -105,12 +107,13 @@ class elasticsearch_plugin_impl
       void cleanObjects(const account_transaction_history_id_type& ath, const account_id_type& account_id);
       void createBulkLine(const account_transaction_history_object& ath);
       void prepareBulk(const account_transaction_history_id_type& ath_id);
-      void populateESstruct();
+      void sendBulk();
       void init_program_options(const boost::program_options::variables_map& options);
 };
 
 elasticsearch_plugin_impl::~elasticsearch_plugin_impl()
 {
+   _sender.reset();
    if (curl) {
       curl_easy_cleanup(curl);
       curl = nullptr;
@@ -196,30 +199,17 @@ bool elasticsearch_plugin_impl::update_account_histories( const signed_block& b
    }
    // we send bulk at end of block when we are in sync for better real time client experience
    if(is_sync)
-   {
-      populateESstruct();
-      if(es.bulk_lines.size() > 0)
-      {
-         prepare.clear();
-         if(!graphene::utilities::SendBulk(es))
-         {
-            // Note: although called with `std::move()`, `es` is not updated in `SendBulk()`
-            elog( "Error sending ${n} lines of bulk data to Elastic Search, the first lines are:",
-                  ("n",es.bulk_lines.size()) );
-            for( size_t i = 0; i < es.bulk_lines.size() && i < 10; ++i )
-            {
-               edump( (es.bulk_lines[i]) );
-            }
-            return false;
-         }
-         else
-            bulk_lines.clear();
-      }
-   }
+      sendBulk();
 
    if(bulk_lines.size() != limit_documents)
       bulk_lines.reserve(limit_documents);
 
+   if(b.block_num() % 10000 == 0)
+   {
+      const auto stats = _sender->get_stats();
+      ilog( "Elasticsearch sender at block ${b}: ${s}", ("b",b.block_num())("s",stats) );
+   }
+
    return true;
 }
 
@@ -485,23 +475,8 @@ bool elasticsearch_plugin_impl::add_elasticsearch( const account_id_type account
    }
    cleanObjects(ath.id, account_id);
 
-   if (curl && bulk_lines.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
-      prepare.clear();
-      populateESstruct();
-      if(!graphene::utilities::SendBulk(es))
-      {
-         // Note: although called with `std::move()`, `es` is not updated in `SendBulk()`
-         elog( "Error sending ${n} lines of bulk data to Elastic Search, the first lines are:",
-               ("n",es.bulk_lines.size()) );
-         for( size_t i = 0; i < es.bulk_lines.size() && i < 10; ++i )
-         {
-            edump( (es.bulk_lines[i]) );
-         }
-         return false;
-      }
-      else
-         bulk_lines.clear();
-   }
+   if (bulk_lines.size() >= limit_documents) // we are in bulk time, ready to add data to elasticsearech
+      sendBulk();
 
    return true;
 }
@@ -594,15 +569,14 @@ void elasticsearch_plugin_impl::cleanObjects(const account_transaction_history_i
    }
 }
 
-void elasticsearch_plugin_impl::populateESstruct()
+void elasticsearch_plugin_impl::sendBulk()
 {
-   es.curl = curl;
-   es.bulk_lines = std::move(bulk_lines);
-   es.elasticsearch_url = _elasticsearch_node_url;
-   es.auth = _elasticsearch_basic_auth;
-   es.index_prefix = _elasticsearch_index_prefix;
-   es.endpoint = "";
-   es.query = "";
+   prepare.clear();
+   if(bulk_lines.empty())
+      return;
+   // the sender ships the request from its own threads, blocking here only while its queue is full
+   _sender->enqueue(graphene::utilities::joinBulkLines(bulk_lines));
+   bulk_lines.clear();
 }
 
 void elasticsearch_plugin_impl::init_program_options(const boost::program_options::variables_map& options)
@@ -634,6 +608,24 @@ void elasticsearch_plugin_impl::init_program_options(const boost::program_option
    if (options.count("elasticsearch-operation-string")) {
       _elasticsearch_operation_string = options["elasticsearch-operation-string"].as<bool>();
    }
+   if (options.count("elasticsearch-max-in-flight")) {
+      _sender_options.max_in_flight = options["elasticsearch-max-in-flight"].as<uint16_t>();
+   }
+   if (options.count("elasticsearch-queue-size")) {
+      _sender_options.max_queue_bytes = uint64_t(options["elasticsearch-queue-size"].as<uint32_t>()) * 1024 * 1024;
+   }
+   if (options.count("elasticsearch-spill-dir")) {
+      _sender_options.spill_dir = options["elasticsearch-spill-dir"].as<std::string>();
+   }
+   else if (options.count("data-dir")) {
+      _sender_options.spill_dir = fc::path(options["data-dir"].as<boost::filesystem::path>()) / "elasticsearch-spill";
+   }
+   if (options.count("elasticsearch-max-item-error-attempts")) {
+      _sender_options.max_item_error_attempts = options["elasticsearch-max-item-error-attempts"].as<uint32_t>();
+   }
+   if (options.count("data-dir")) {
+      _sender_options.rejected_file = fc::path(options["data-dir"].as<boost::filesystem::path>()) / "elasticsearch-rejected.bulk";
+   }
    if (options.count("elasticsearch-mode")) {
       const auto option_number = options["elasticsearch-mode"].as<uint16_t>();
       if(option_number > mode::all)
@@ -688,6 +680,16 @@ void elasticsearch_plugin::plugin_set_program_options(
                "Save operation as string. Needed to serve history api calls(false)")
          ("elasticsearch-mode", boost::program_options::value<uint16_t>(),
                "Mode of operation: only_save(0), only_query(1), all(2) - Default: 0")
+         ("elasticsearch-max-in-flight", boost::program_options::value<uint16_t>(),
+               "Number of bulk requests sent to Elastic Search concurrently(2)")
+         ("elasticsearch-queue-size", boost::program_options::value<uint32_t>(),
+               "Megabytes of bulk requests kept in memory while waiting to be sent(256)")
+         ("elasticsearch-spill-dir", boost::program_options::value<std::string>(),
+               "Directory to save bulk requests to when the queue is full and on shutdown, they are sent after a restart "
+               "(elasticsearch-spill under the data dir, without a data dir block application and shutdown wait for them to be sent)")
+         ("elasticsearch-max-item-error-attempts", boost::program_options::value<uint32_t>(),
+               "Times an operation Elasticsearch rejects with a 4xx status is sent before giving up on it and "
+               "appending it to elasticsearch-rejected.bulk under the data dir(5)")
          ;
    cfg.add(cli);
 }
@@ -723,6 +725,12 @@ void elasticsearch_plugin::plugin_initialize(const boost::program_options::varia
 
    graphene::utilities::checkESVersion7OrAbove(es, my->is_es_version_7_or_above);
 
+   if(my->_elasticsearch_mode != mode::only_query) {
+      my->_sender_options.url = my->_elasticsearch_node_url;
+      my->_sender_options.auth = my->_elasticsearch_basic_auth;
+      my->_sender.reset(new graphene::utilities::es_bulk_sender(my->_sender_options));
+   }
+
    ilog("elasticsearch ACCOUNT HISTORY: plugin_initialize() end");
 }
 
@@ -733,6 +741,22 @@ void elasticsearch_plugin::plugin_startup()
    ilog("elasticsearch ACCOUNT HISTORY: plugin_startup() end");
 }
 
+void elasticsearch_plugin::plugin_shutdown()
+{
+   if(my->_sender)
+   {
+      my->sendBulk();
+      my->_sender->stop();
+   }
+}
+
+graphene::utilities::es_bulk_sender::stats elasticsearch_plugin::get_sender_stats()const
+{
+   if(!my->_sender)
+      return graphene::utilities::es_bulk_sender::stats();
+   return my->_sender->get_stats();
+}
+
 operation_history_object elasticsearch_plugin::get_operation_by_id(operation_history_id_type id)
 {
    const string operation_id_string = std::string(object_id_type(id));
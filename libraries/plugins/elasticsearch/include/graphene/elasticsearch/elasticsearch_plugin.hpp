@@ -27,6 +27,7 @@
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/operation_history_object.hpp>
 #include <graphene/utilities/elasticsearch.hpp>
+#include <graphene/utilities/es_bulk_sender.hpp>
 
 namespace graphene { namespace elasticsearch {
    using namespace chain;
@@ -65,6 +66,10 @@ class elasticsearch_plugin : public graphene::app::plugin
          boost::program_options::options_description& cfg) override;
       virtual void plugin_initialize(const boost::program_options::variables_map& options) override;
       virtual void plugin_startup() override;
+      virtual void plugin_shutdown() override;
+
+      /// queue depth and latency of the asynchronous bulk sender
+      graphene::utilities::es_bulk_sender::stats get_sender_stats()const;
 
       operation_history_object get_operation_by_id(operation_history_id_type id);
       vector<operation_history_object> get_account_history(const account_id_type account_id,
@@ -28,6 +28,8 @@
 
 #include <fc/thread/future.hpp>
 
+#include <boost/multi_index/composite_key.hpp>
+
 namespace graphene { namespace market_history {
 using namespace chain;
 
@@ -106,6 +108,72 @@ struct order_history_object : public abstract_object<order_history_object>
   fill_order_operation op;
 };
 
+/**
+ *  Rolling 24 hour summary of a market, kept up to date from fill_order_operations so that tickers can be
+ *  served without walking the trade history. Trades are accumulated into a ring of fixed size time slots;
+ *  the ring spans exactly one day, so a slot is reused once the trades it holds are a day old.
+ *
+ *  Amounts are stored with asset_a being the asset with the lower id, matching history_key.
+ */
+struct market_ticker_object : public abstract_object<market_ticker_object>
+{
+   static const uint8_t space_id = ACCOUNT_HISTORY_SPACE_ID;
+   static const uint8_t type_id  = 2;
+
+   static const uint32_t slot_seconds = 900;
+   static const uint32_t slot_count   = 86400 / slot_seconds;
+
+   struct slot
+   {
+      uint32_t    period = 0; ///< time / slot_seconds of the trades held in this slot
+      share_type  volume_a;
+      share_type  volume_b;
+      share_type  close_a;
+      share_type  close_b;
+   };
+
+   asset_id_type                     asset_a;
+   asset_id_type                     asset_b;
+   /// latest trade ever seen in this market
+   share_type                        last_a;
+   share_type                        last_b;
+   /// closing trade of the newest slot that has been recycled, the fallback for the price a day ago
+   share_type                        recycled_close_a;
+   share_type                        recycled_close_b;
+   uint32_t                          recycled_period = 0;
+   vector<slot>                      slots;  ///< slot_count entries, indexed by period % slot_count
+
+   /// records a trade of amount_a of asset_a against amount_b of asset_b
+   void add_trade( fc::time_point_sec time, share_type amount_a, share_type amount_b );
+
+   struct summary
+   {
+      share_type volume_a;
+      share_type volume_b;
+      /// price of the last trade before the day started, zero if unknown
+      share_type day_open_a;
+      share_type day_open_b;
+   };
+   /// totals over the day ending at now, at slot resolution
+   summary summarize( fc::time_point_sec now )const;
+};
+
+struct by_market;
+typedef multi_index_container<
+   market_ticker_object,
+   indexed_by<
+      hashed_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique< tag<by_market>,
+         composite_key< market_ticker_object,
+            member< market_ticker_object, asset_id_type, &market_ticker_object::asset_a >,
+            member< market_ticker_object, asset_id_type, &market_ticker_object::asset_b >
+         >
+      >
+   >
+> market_ticker_multi_index_type;
+
+typedef generic_index<market_ticker_object, market_ticker_multi_index_type> market_ticker_index;
+
 struct by_key;
 typedef multi_index_container<
    bucket_object,
@@ -172,4 +240,10 @@ FC_REFLECT_DERIVED( graphene::market_history::bucket_object, (graphene::db::obje
                     (open_base)(open_quote)
                     (close_base)(close_quote)
                     (base_volume)(quote_volume) )
+FC_REFLECT( graphene::market_history::market_ticker_object::slot, (period)(volume_a)(volume_b)(close_a)(close_b) )
+FC_REFLECT_DERIVED( graphene::market_history::market_ticker_object, (graphene::db::object),
+                    (asset_a)(asset_b)
+                    (last_a)(last_b)
+                    (recycled_close_a)(recycled_close_b)(recycled_period)
+                    (slots) )
 
@@ -37,6 +37,58 @@
 
 namespace graphene { namespace market_history {
 
+void market_ticker_object::add_trade( fc::time_point_sec time, share_type amount_a, share_type amount_b )
+{
+   const uint32_t period = time.sec_since_epoch() / slot_seconds;
+   if( slots.size() != slot_count )
+      slots.resize( slot_count );
+   slot& s = slots[period % slot_count];
+   if( s.period != period )
+   {
+      if( s.close_b != 0 && s.period < period && s.period >= recycled_period )
+      {
+         recycled_close_a = s.close_a;
+         recycled_close_b = s.close_b;
+         recycled_period = s.period;
+      }
+      s = slot();
+      s.period = period;
+   }
+   s.volume_a += amount_a;
+   s.volume_b += amount_b;
+   s.close_a = amount_a;
+   s.close_b = amount_b;
+   last_a = amount_a;
+   last_b = amount_b;
+}
+
+market_ticker_object::summary market_ticker_object::summarize( fc::time_point_sec now )const
+{
+   const uint32_t now_period = now.sec_since_epoch() / slot_seconds;
+   summary result;
+   result.day_open_a = recycled_close_a;
+   result.day_open_b = recycled_close_b;
+   uint32_t day_open_period = recycled_period;
+   for( const slot& s : slots )
+   {
+      if( s.close_b == 0 )
+         continue;
+      if( s.period + slot_count > now_period )
+      {
+         result.volume_a += s.volume_a;
+         result.volume_b += s.volume_b;
+      }
+      else if( s.period > day_open_period )
+      {
+         // a day old but not recycled yet, and newer than anything recycled so far
+         day_open_period = s.period;
+         result.day_open_a = s.close_a;
+         result.day_open_b = s.close_b;
+      }
+   }
+   return result;
+}
+
 namespace detail
 {
 
@@ -107,6 +159,41 @@ struct operation_process_fill_order
          ho.op = o;
       });
 
+      /** both sides of a match produce a fill, only count the one paying the asset with the lower id */
+      if( o.pays.asset_id < o.receives.asset_id )
+      {
+         const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+         auto ticker_itr = ticker_idx.find( boost::make_tuple( o.pays.asset_id, o.receives.asset_id ) );
+         if( ticker_itr == ticker_idx.end() )
+         {
+            // the ticker of a market that traded before the ticker index existed, e.g. on a node that was
+            // upgraded without a replay, starts out with the last day of trades kept in the history
+            vector<const order_history_object*> trades;
+            for( auto hist_itr = history_idx.lower_bound( hkey );
+                 hist_itr != history_idx.end() && hist_itr->key.base == hkey.base && hist_itr->key.quote == hkey.quote;
+                 ++hist_itr )
+            {
+               if( hist_itr->op.pays.asset_id > hist_itr->op.receives.asset_id )
+                  continue;
+               trades.push_back( &*hist_itr );
+               // the last trade before the day is the price a day ago
+               if( hist_itr->time + market_ticker_object::slot_count * market_ticker_object::slot_seconds <= time )
+                  break;
+            }
+            db.create<market_ticker_object>( [&]( market_ticker_object& t ) {
+               t.asset_a = o.pays.asset_id;
+               t.asset_b = o.receives.asset_id;
+               // the history is walked newest first
+               for( auto trade = trades.rbegin(); trade != trades.rend(); ++trade )
+                  t.add_trade( (*trade)->time, (*trade)->op.pays.amount, (*trade)->op.receives.amount );
+            });
+         }
+         else
+            db.modify( *ticker_itr, [&]( market_ticker_object& t ) {
+               t.add_trade( time, o.pays.amount, o.receives.amount );
+            });
+      }
+
       hkey.sequence += 200;
       itr = history_idx.lower_bound( hkey );
       /*
@@ -267,6 +354,7 @@ void market_history_plugin::plugin_initialize(const boost::program_options::vari
    database().applied_block.connect( [this]( const signed_block& b){ my->update_market_histories(b); } );
    database().add_index< primary_index< bucket_index  > >();
    database().add_index< primary_index< history_index  > >();
+   database().add_index< primary_index< market_ticker_index > >();
 
    if( options.count( "bucket-size" ) )
    {
@@ -77,6 +77,8 @@ void witness_plugin::plugin_set_program_options(
          ("private-key", bpo::value<vector<string>>()->composing()->multitoken()->
           DEFAULT_VALUE_VECTOR(std::make_pair(chain::public_key_type(default_priv_key.get_public_key()), graphene::utilities::key_to_wif(default_priv_key))),
           "Tuple of [PublicKey, WIF private key] (may specify multiple times)")
+         ("block-assembly-time-budget", bpo::value<uint32_t>()->default_value(1000),
+          "Milliseconds a produced block may spend collecting pending transactions before it is sealed, 0 for no limit")
          ;
    config_file_options.add(command_line_options);
 }
@@ -91,6 +93,8 @@ void witness_plugin::plugin_initialize(const boost::program_options::variables_m
    ilog("witness plugin:  plugin_initialize() begin");
    _options = &options;
    LOAD_VALUE_SET(options, "witness-id", _witnesses, chain::witness_id_type)
+   if (options.count("block-assembly-time-budget"))
+      database().set_block_assembly_time_budget(fc::milliseconds(options.at("block-assembly-time-budget").as<uint32_t>()));
    if (options.count("witness-ids")) {
        vector<chain::witness_id_type> v = fc::json::from_string(options.at("witness-ids").as<string>()).as<vector<chain::witness_id_type>>( 5 );
        _witnesses.insert(v.begin(), v.end());
@@ -188,9 +192,17 @@ block_production_condition::block_production_condition_enum witness_plugin::bloc
    switch( result )
    {
       case block_production_condition::produced:
+      {
          ilog("Generated block #${n} with timestamp ${t} at time ${c}", 
                ("n", capture["n"])("t", capture["t"])("c", capture["c"]));
+         const auto& stats = database().get_last_block_generation_stats();
+         ilog("Block #${n} with ${i} transactions (${p} postponed${b}): assembly ${a}us${r}, sealing ${s}us, push ${u}us",
+               ("n", capture["n"])("i", stats.included_transactions)("p", stats.postponed_transactions)
+               ("b", stats.time_budget_exceeded ? ", out of time" : "")
+               ("a", stats.assembly_time.count())("r", stats.reused_pending_state ? " (reused pending state)" : "")
+               ("s", stats.sealing_time.count())("u", stats.push_time.count()));
          break;
+      }
       case block_production_condition::not_synced:
          ilog("Not producing block because production is disabled until we receive a recent block (see: --enable-stale-production)");
          break;
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/utilities/es_bulk_sender.hpp>
+
+#include <fc/io/fstream.hpp>
+#include <fc/io/json.hpp>
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+namespace graphene { namespace utilities {
+
+es_bulk_sender::es_bulk_sender( const options& opts )
+   : _options( opts )
+{
+   FC_ASSERT( _options.max_in_flight > 0, "At least one request must be allowed in flight" );
+   if( _options.spill_dir != fc::path() )
+   {
+      fc::create_directories( _options.spill_dir );
+      load_spilled();
+   }
+   // the handles are created here so that curl's global initialization happens on the calling thread
+   for( uint32_t i = 0; i < _options.max_in_flight; ++i )
+   {
+      CURL* curl = curl_easy_init();
+      FC_ASSERT( curl != nullptr, "Unable to initialize curl" );
+      _handles.push_back( curl );
+   }
+   for( CURL* curl : _handles )
+      _threads.emplace_back( [this,curl]() { run( curl ); } );
+}
+
+es_bulk_sender::~es_bulk_sender()
+{
+   stop();
+   for( CURL* curl : _handles )
+      curl_easy_cleanup( curl );
+}
+
+void es_bulk_sender::enqueue( std::string&& body )
+{
+   if( body.empty() )
+      return;
+   batch b;
+   b.body = std::move( body );
+   b.enqueued = fc::time_point::now();
+
+   std::unique_lock<std::mutex> lock( _mutex );
+   FC_ASSERT( !_stopping, "Elasticsearch sender has been stopped" );
+   b.seq = _next_seq++;
+   // a body larger than the whole limit is still accepted once the queue has drained
+   if( _stats.queued_bytes > 0 && _stats.queued_bytes + b.body.size() > _options.max_queue_bytes )
+   {
+      if( _options.spill_dir == fc::path() )
+         _space.wait( lock, [this,&b]() {
+            return _stopping || _stats.queued_bytes == 0
+                   || _stats.queued_bytes + b.body.size() <= _options.max_queue_bytes;
+         } );
+      else
+         spill( b );
+   }
+   if( b.body.empty() )
+      ++_stats.spilled_batches;
+   else
+      _stats.queued_bytes += b.body.size();
+   ++_stats.queued_batches;
+   _queue.push_back( std::move( b ) );
+   lock.unlock();
+   _work.notify_one();
+}
+
+void es_bulk_sender::stop( const std::chrono::milliseconds& drain_timeout )
+{
+   {
+      std::unique_lock<std::mutex> lock( _mutex );
+      if( _stopping )
+         return;
+      auto drained = [this]() { return _queue.empty() && _stats.in_flight == 0; };
+      // without a spill directory the queued bodies would be lost, so they are all sent first
+      if( _options.spill_dir == fc::path() )
+         _idle.wait( lock, drained );
+      else
+         _idle.wait_for( lock, drain_timeout, drained );
+      _stopping = true;
+   }
+   _work.notify_all();
+   _space.notify_all();
+   for( auto& t : _threads )
+      t.join();
+   _threads.clear();
+
+   std::lock_guard<std::mutex> lock( _mutex );
+   if( _queue.empty() )
+      return;
+   for( auto& b : _queue )
+      if( !b.body.empty() )
+         spill( b );
+   ilog( "Saved ${n} unsent Elasticsearch bulk requests to ${d}", ("n",_queue.size())("d",_options.spill_dir) );
+}
+
+es_bulk_sender::stats es_bulk_sender::get_stats()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _stats;
+}
+
+void es_bulk_sender::run( CURL* curl )
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   while( true )
+   {
+      _work.wait( lock, [this]() { return _stopping || !_queue.empty(); } );
+      if( _stopping )
+         return;
+
+      batch b = std::move( _queue.front() );
+      _queue.pop_front();
+      --_stats.queued_batches;
+      if( b.body.empty() )
+         --_stats.spilled_batches;
+      else
+      {
+         _stats.queued_bytes -= b.body.size();
+         _space.notify_all();
+      }
+      ++_stats.in_flight;
+      lock.unlock();
+
+      bool ok = true;
+      if( b.body.empty() )
+      {
+         try
+         {
+            fc::read_file_contents( spill_path( b.seq ), b.body );
+         }
+         catch( const fc::exception& e )
+         {
+            elog( "Unable to read spilled Elasticsearch bulk request ${s}: ${e}", ("s",b.seq)("e",e.to_detail_string()) );
+            ok = false;
+         }
+      }
+
+      uint32_t backoff_ms = _options.min_backoff_ms;
+      while( ok )
+      {
+         if( send( curl, b ) )
+            break;
+
+         lock.lock();
+         ++_stats.failed_attempts;
+         if( _work.wait_for( lock, std::chrono::milliseconds( backoff_ms ), [this]() { return _stopping; } ) )
+         {
+            // hand it back in seq order so stop() saves it with the rest of the queue
+            _stats.queued_bytes += b.body.size();
+            ++_stats.queued_batches;
+            --_stats.in_flight;
+            auto pos = std::upper_bound( _queue.begin(), _queue.end(), b.seq,
+                                         []( uint64_t seq, const batch& queued ) { return seq < queued.seq; } );
+            _queue.insert( pos, std::move( b ) );
+            _idle.notify_all();
+            return;
+         }
+         lock.unlock();
+         backoff_ms = std::min( backoff_ms * 2, _options.max_backoff_ms );
+      }
+
+      if( b.spilled && _options.spill_dir != fc::path() )
+         fc::remove( spill_path( b.seq ) );
+
+      lock.lock();
+      --_stats.in_flight;
+      if( !ok )
+         ++_stats.dropped_batches;
+      else
+      {
+         ++_stats.sent_batches;
+         _stats.last_latency_us = ( fc::time_point::now() - b.enqueued ).count();
+         _stats.avg_latency_us = _stats.avg_latency_us == 0 ? _stats.last_latency_us
+                                 : ( _stats.avg_latency_us * 7 + _stats.last_latency_us ) / 8;
+      }
+      _idle.notify_all();
+   }
+}
+
+bool es_bulk_sender::send( CURL* curl, batch& b )
+{
+   CurlRequest request;
+   request.handler = curl;
+   request.url = _options.url + "_bulk";
+   request.auth = _options.auth;
+   request.type = "POST";
+   // lend the body to the request instead of copying it
+   request.query.swap( b.body );
+   std::string response;
+   long http_code = 0;
+   try
+   {
+      response = doCurl( request );
+      http_code = getResponseCode( curl );
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Error sending Elasticsearch bulk request ${s}: ${e}", ("s",b.seq)("e",e.to_detail_string()) );
+   }
+   request.query.swap( b.body );
+   if( http_code != 200 )
+   {
+      if( http_code != 0 )
+         handleBulkResponse( http_code, response );
+      return false;
+   }
+   try
+   {
+      const fc::variant result = fc::json::from_string( response );
+      return !result["errors"].as_bool() || drop_completed_items( b, result );
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Unable to read the Elasticsearch response to bulk request ${s}: ${e}", ("s",b.seq)("e",e.to_detail_string()) );
+   }
+   return false;
+}
+
+bool es_bulk_sender::drop_completed_items( batch& b, const fc::variant& response )
+{
+   // an operation is an action line followed by a source line, except for deletes
+   std::vector<std::string> operations;
+   size_t pos = 0;
+   while( pos < b.body.size() )
+   {
+      const bool has_source = b.body.compare( pos, 10, "{\"delete\":" ) != 0;
+      size_t end = pos;
+      for( int lines = has_source ? 2 : 1; lines > 0 && end < b.body.size(); --lines )
+      {
+         end = b.body.find( '\n', end );
+         end = end == std::string::npos ? b.body.size() : end + 1;
+      }
+      operations.push_back( b.body.substr( pos, end - pos ) );
+      pos = end;
+   }
+
+   const fc::variant_object& result = response.get_object();
+   auto items_itr = result.find( "items" );
+   if( items_itr == result.end() || !items_itr->value().is_array()
+       || items_itr->value().get_array().size() != operations.size() )
+   {
+      elog( "Elasticsearch reported item errors for bulk request ${s}, the first lines are: ${l}",
+            ("s",b.seq)("l",b.body.substr( 0, 1024 )) );
+      return false;
+   }
+
+   std::string retry;
+   std::vector<std::string> rejected;
+   const fc::variants& items = items_itr->value().get_array();
+   for( size_t i = 0; i < items.size(); ++i )
+   {
+      // each item is keyed by its action
+      const fc::variant_object& outcome = items[i].get_object().begin()->value().get_object();
+      const int64_t status = outcome["status"].as_int64();
+      if( status < 300 )
+         continue;
+      if( status >= 400 && status < 500 && status != 429 )
+      {
+         if( rejected.empty() )
+            elog( "Elasticsearch rejected an operation of bulk request ${s} with status ${c}: ${e}",
+                  ("s",b.seq)("c",status)("e",outcome.contains( "error" ) ? outcome["error"] : fc::variant()) );
+         rejected.push_back( std::move( operations[i] ) );
+      }
+      else
+         retry += operations[i];
+   }
+
+   if( !rejected.empty() && ++b.rejected_attempts >= _options.max_item_error_attempts )
+      save_rejected( b, rejected );
+   else
+      for( const auto& operation : rejected )
+         retry += operation;
+   b.body = std::move( retry );
+   return b.body.empty();
+}
+
+void es_bulk_sender::save_rejected( const batch& b, const std::vector<std::string>& operations )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   _stats.rejected_items += operations.size();
+   if( _options.rejected_file == fc::path() )
+   {
+      for( const auto& operation : operations )
+         elog( "Giving up on Elasticsearch operation of bulk request ${s}: ${o}", ("s",b.seq)("o",operation) );
+      return;
+   }
+   std::ofstream out( _options.rejected_file.generic_string(), std::ios::binary | std::ios::app );
+   for( const auto& operation : operations )
+      out.write( operation.data(), operation.size() );
+   out.close();
+   if( out )
+      elog( "Giving up on ${n} Elasticsearch operations of bulk request ${s} after ${a} tries, appended them to ${f}",
+            ("n",operations.size())("s",b.seq)("a",b.rejected_attempts)("f",_options.rejected_file) );
+   else
+      for( const auto& operation : operations )
+         elog( "Giving up on Elasticsearch operation of bulk request ${s}, unable to write it to ${f}: ${o}",
+               ("s",b.seq)("f",_options.rejected_file)("o",operation) );
+}
+
+fc::path es_bulk_sender::spill_path( uint64_t seq )const
+{
+   return _options.spill_dir / ( std::to_string( seq ) + ".bulk" );
+}
+
+void es_bulk_sender::spill( batch& b )
+{
+   const fc::path tmp = _options.spill_dir / ( std::to_string( b.seq ) + ".tmp" );
+   {
+      std::ofstream out( tmp.generic_string(), std::ios::binary | std::ios::trunc );
+      out.write( b.body.data(), b.body.size() );
+      out.close();
+      FC_ASSERT( out, "Unable to write ${f}", ("f",tmp) );
+   }
+   fc::rename( tmp, spill_path( b.seq ) );
+   b.body = std::string();
+   b.spilled = true;
+}
+
+void es_bulk_sender::load_spilled()
+{
+   std::vector<uint64_t> spilled;
+   for( fc::directory_iterator itr( _options.spill_dir ); itr != fc::directory_iterator(); ++itr )
+   {
+      const std::string name = fc::path( *itr ).filename().string();
+      const std::string suffix = ".bulk";
+      if( name.size() <= suffix.size() || name.compare( name.size() - suffix.size(), suffix.size(), suffix ) != 0 )
+         continue;
+      try
+      {
+         spilled.push_back( std::stoull( name.substr( 0, name.size() - suffix.size() ) ) );
+      }
+      catch( const std::exception& )
+      {
+         wlog( "Ignoring unexpected file ${f} in the Elasticsearch spill directory", ("f",name) );
+      }
+   }
+   std::sort( spilled.begin(), spilled.end() );
+   for( uint64_t seq : spilled )
+   {
+      batch b;
+      b.seq = seq;
+      b.spilled = true;
+      b.enqueued = fc::time_point::now();
+      _queue.push_back( std::move( b ) );
+   }
+   _next_seq = spilled.empty() ? 0 : spilled.back() + 1;
+   _stats.queued_batches = _stats.spilled_batches = spilled.size();
+   if( !spilled.empty() )
+      ilog( "Resending ${n} Elasticsearch bulk requests saved in ${d}", ("n",spilled.size())("d",_options.spill_dir) );
+}
+
+} } // end namespace graphene::utilities
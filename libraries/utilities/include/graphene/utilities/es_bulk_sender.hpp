@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/utilities/elasticsearch.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace graphene { namespace utilities {
+
+   /**
+    * @brief ships bulk request bodies to Elasticsearch from dedicated threads
+    *
+    * enqueue() hands a body over and returns immediately while the queue is below its byte limit. Above the
+    * limit, bodies are spilled to disk if a spill directory is configured, otherwise enqueue() blocks until the
+    * senders catch up. Each sender thread owns a curl handle, so up to max_in_flight requests are outstanding
+    * at once. The bodies are taken from the queue in the order they were queued but may be applied out of
+    * order, which is safe as long as every operation names its document _id, as the account history does.
+    *
+    * Failed requests are retried with exponential backoff until they succeed. When Elasticsearch reports item
+    * errors only the failed operations are retried. An operation it rejects for good, with a 4xx status other
+    * than 429, is given up on after max_item_error_attempts tries and appended to the rejected file.
+    *
+    * Bodies left over at stop() and spilled bodies that were never sent are picked up again from the spill
+    * directory by the next sender using it.
+    */
+   class es_bulk_sender
+   {
+      public:
+         struct options
+         {
+            std::string url;             ///< node url, with trailing slash
+            std::string auth;
+            uint32_t    max_in_flight = 2;
+            uint64_t    max_queue_bytes = 256 * 1024 * 1024;
+            fc::path    spill_dir;       ///< empty to block instead of spilling
+            uint32_t    min_backoff_ms = 100;
+            uint32_t    max_backoff_ms = 30000;
+            uint32_t    max_item_error_attempts = 5; ///< tries for an operation rejected with a 4xx status
+            fc::path    rejected_file;   ///< where given up operations go, empty to only log them
+         };
+
+         struct stats
+         {
+            uint64_t queued_batches = 0;
+            uint64_t queued_bytes = 0;   ///< bytes held in memory
+            uint64_t spilled_batches = 0; ///< queued batches currently on disk
+            uint32_t in_flight = 0;
+            uint64_t sent_batches = 0;
+            uint64_t failed_attempts = 0;
+            uint64_t dropped_batches = 0; ///< spilled batches that could not be read back
+            uint64_t rejected_items = 0;  ///< operations given up on after being rejected
+            int64_t  last_latency_us = 0; ///< enqueue to acknowledgement of the last batch
+            int64_t  avg_latency_us = 0;  ///< moving average of the above
+         };
+
+         explicit es_bulk_sender( const options& opts );
+         ~es_bulk_sender();
+
+         /// queues one bulk request body, as produced by joinBulkLines()
+         void enqueue( std::string&& body );
+
+         /**
+          * waits for the queue to empty and stops the sender threads; with a spill directory it waits no longer
+          * than drain_timeout and spills what is left, without one nothing could keep it so it waits until all
+          * is sent
+          */
+         void stop( const std::chrono::milliseconds& drain_timeout = std::chrono::seconds(10) );
+
+         stats get_stats()const;
+
+      private:
+         struct batch
+         {
+            uint64_t           seq = 0;
+            std::string        body;            ///< empty while only on disk
+            bool               spilled = false; ///< a copy is in the spill directory
+            uint32_t           rejected_attempts = 0; ///< tries in which some operation was rejected for good
+            fc::time_point     enqueued;
+         };
+
+         void     run( CURL* curl );
+         bool     send( CURL* curl, batch& b );
+         /// leaves just the operations to retry in the body, returns true if there are none
+         bool     drop_completed_items( batch& b, const fc::variant& response );
+         void     save_rejected( const batch& b, const std::vector<std::string>& operations );
+         fc::path spill_path( uint64_t seq )const;
+         void     spill( batch& b );
+         void     load_spilled();
+
+         options                     _options;
+         std::vector<CURL*>          _handles;
+         std::vector<std::thread>    _threads;
+
+         mutable std::mutex          _mutex;
+         std::condition_variable     _work;    ///< signalled when a batch is queued or on stop
+         std::condition_variable     _space;   ///< signalled when queued bytes drop
+         std::condition_variable     _idle;    ///< signalled when a batch completes
+         std::deque<batch>           _queue;   ///< in seq order
+         uint64_t                    _next_seq = 0;
+         bool                        _stopping = false;
+         stats                       _stats;
+   };
+
+} } // end namespace graphene::utilities
+
+FC_REFLECT( graphene::utilities::es_bulk_sender::stats,
+            (queued_batches)(queued_bytes)(spilled_batches)(in_flight)(sent_batches)
+            (failed_attempts)(dropped_batches)(rejected_items)(last_latency_us)(avg_latency_us) )
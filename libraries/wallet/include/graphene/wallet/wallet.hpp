@@ -2060,6 +2060,7 @@ class wallet_api
 
       asset get_total_matched_bet_amount_for_betting_market_group(betting_market_group_id_type group_id);
       std::vector<event_object> get_events_containing_sub_string(const std::string& sub_string, const std::string& language);
+      std::vector<event_object> get_first_events_containing_sub_string(const std::string& sub_string, const std::string& language, unsigned limit);
 
       /** Get an order book for a betting market, with orders aggregated into bins with similar
        * odds
@@ -2889,6 +2890,7 @@ FC_API( graphene::wallet::wallet_api,
         (get_order_book)
         (get_total_matched_bet_amount_for_betting_market_group)
         (get_events_containing_sub_string)
+        (get_first_events_containing_sub_string)
         (get_binned_order_book)
         (get_matched_bets_for_bettor)
         (get_all_matched_bets_for_bettor)
@@ -7875,6 +7875,11 @@ std::vector<event_object> wallet_api::get_events_containing_sub_string(const std
     return( my->_remote_bookie->get_events_containing_sub_string(sub_string, language) );
 }
 
+std::vector<event_object> wallet_api::get_first_events_containing_sub_string(const std::string& sub_string, const std::string& language, unsigned limit)
+{
+    return( my->_remote_bookie->get_first_events_containing_sub_string(sub_string, language, limit) );
+}
+
 binned_order_book wallet_api::get_binned_order_book(graphene::chain::betting_market_id_type betting_market_id, int32_t precision)
 {
     return( my->_remote_bookie->get_binned_order_book(betting_market_id, precision) );
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/chain/block_database.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/filesystem.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <iostream>
+#include <string>
+
+namespace bpo = boost::program_options;
+using graphene::chain::block_codec;
+using graphene::chain::block_database;
+
+/**
+ * Re-encodes an existing block log (the blockchain/database/block_num_to_block directory of a
+ * data dir) into a new directory, e.g. to compress the blocks of an existing node. Replace the
+ * original directory with the output while the node is stopped.
+ *
+ * A compressed log keeps its blocks in blocks_v2, so nodes built without block compression refuse
+ * to open it. Keep the original directory to go back to such a build, or convert the log again
+ * with --codec none.
+ */
+int main( int argc, char** argv )
+{
+   try
+   {
+      bpo::options_description opts( "Usage: block_log_convert --from <dir> --to <dir> [--codec none|zstd]" );
+      opts.add_options()
+         ("help,h", "Print this help message and exit")
+         ("from", bpo::value<std::string>(), "Existing block_num_to_block directory")
+         ("to", bpo::value<std::string>(), "Directory to write the converted block log to, must not exist")
+         ("codec", bpo::value<std::string>()->default_value("zstd"), "Codec for the converted blocks: none or zstd");
+
+      bpo::variables_map options;
+      bpo::store( bpo::parse_command_line( argc, argv, opts ), options );
+      if( options.count("help") || !options.count("from") || !options.count("to") )
+      {
+         std::cout << opts << "\n";
+         return options.count("help") ? 0 : 1;
+      }
+
+      const fc::path src_dir( options["from"].as<std::string>() );
+      const fc::path dst_dir( options["to"].as<std::string>() );
+      const std::string codec_name = options["codec"].as<std::string>();
+      FC_ASSERT( fc::exists( src_dir / "index" ), "${d} does not contain a block log", ("d",src_dir) );
+      FC_ASSERT( !fc::exists( dst_dir ), "${d} already exists", ("d",dst_dir) );
+      FC_ASSERT( codec_name == "none" || codec_name == "zstd", "Unknown codec ${c}", ("c",codec_name) );
+
+      block_database src;
+      src.open( src_dir );
+      block_database dst;
+      dst.open( dst_dir );
+      dst.set_compression( codec_name == "zstd" ? block_codec::zstd : block_codec::raw );
+      dst.set_group_commit( 1024, 64 * 1024 * 1024 );
+
+      const auto start = fc::time_point::now();
+      const uint32_t copied = dst.copy_from( src );
+      dst.close();
+      src.close();
+      std::cout << "Converted " << copied << " blocks in "
+                << ( fc::time_point::now() - start ).count() / 1000000 << " s\n";
+      return 0;
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+   }
+   return 1;
+}
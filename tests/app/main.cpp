@@ -34,6 +34,7 @@
 #include <graphene/accounts_list/accounts_list_plugin.hpp>
 #include <graphene/affiliate_stats/affiliate_stats_plugin.hpp>
 #include <graphene/market_history/market_history_plugin.hpp>
+#include <graphene/net/config.hpp>
 #include <fc/thread/thread.hpp>
 
 #include <boost/filesystem/path.hpp>
@@ -172,6 +173,55 @@ BOOST_AUTO_TEST_CASE( two_node_network )
       BOOST_CHECK_EQUAL(app1.chain_database()->head_block_num(), 1);
 
       BOOST_TEST_MESSAGE( "Checking GRAPHENE_NULL_ACCOUNT has balance" );
+
+      BOOST_TEST_MESSAGE( "Checking the message cache of app1" );
+      auto cache_stats = [&app1]() { return app1.p2p_node()->network_get_info()["message_cache"].get_object(); };
+      fc::variant_object stats = cache_stats();
+      BOOST_CHECK_EQUAL( stats["size_limit"].as_uint64(), GRAPHENE_NET_DEFAULT_MESSAGE_CACHE_SIZE_LIMIT );
+      // app2 fetched the transaction from app1, app1 keeps the transaction and the block it received
+      BOOST_CHECK_GE( stats["hits"].as_uint64(), 1u );
+      const uint64_t cached_messages = stats["messages"].as_uint64();
+      BOOST_CHECK_GE( cached_messages, 2u );
+      BOOST_CHECK_GT( stats["size_in_bytes"].as_uint64(), fc::raw::pack_size( trx ) + fc::raw::pack_size( block_1 ) );
+      BOOST_CHECK_EQUAL( stats["evicted_for_size"].as_uint64(), 0u );
+      const uint64_t misses = stats["misses"].as_uint64();
+
+      // a limit below the size of any message evicts everything
+      app1.p2p_node()->set_advanced_node_parameters( fc::mutable_variant_object( "message_cache_size_limit", 1 ) );
+      BOOST_CHECK_EQUAL( app1.p2p_node()->get_advanced_node_parameters()["message_cache_size_limit"].as_uint64(), 1u );
+      stats = cache_stats();
+      BOOST_CHECK_EQUAL( stats["size_limit"].as_uint64(), 1u );
+      BOOST_CHECK_EQUAL( stats["messages"].as_uint64(), 0u );
+      BOOST_CHECK_EQUAL( stats["size_in_bytes"].as_uint64(), 0u );
+      BOOST_CHECK_EQUAL( stats["evicted_for_size"].as_uint64(), cached_messages );
+
+      // so a transaction broadcast now is evicted right away and app2 has to be served from the chain database
+      graphene::chain::signed_transaction trx2;
+      {
+         account_id_type nathan_id = db1->get_index_type<account_index>().indices().get<by_name>().find( "nathan" )->id;
+         fc::ecc::private_key nathan_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
+
+         transfer_operation xfer_op;
+         xfer_op.from = nathan_id;
+         xfer_op.to = GRAPHENE_NULL_ACCOUNT;
+         xfer_op.amount = asset( 1000 );
+         trx2.operations.push_back( xfer_op );
+         db1->current_fee_schedule().set_fee( trx2.operations.back() );
+
+         trx2.set_expiration( db1->get_slot_time( 10 ) );
+         trx2.sign( nathan_key, db1->get_chain_id() );
+         trx2.validate();
+      }
+      db1->push_transaction(trx2);
+      app1.p2p_node()->broadcast(graphene::net::trx_message(trx2));
+
+      fc::usleep(fc::milliseconds(500));
+      BOOST_CHECK_EQUAL( db2->get_balance( GRAPHENE_NULL_ACCOUNT, asset_id_type() ).amount.value, 1001000 );
+      stats = cache_stats();
+      BOOST_CHECK_EQUAL( stats["messages"].as_uint64(), 0u );
+      BOOST_CHECK_EQUAL( stats["size_in_bytes"].as_uint64(), 0u );
+      BOOST_CHECK_GE( stats["evicted_for_size"].as_uint64(), cached_messages + 1 );
+      BOOST_CHECK_GT( stats["misses"].as_uint64(), misses );
    } catch( fc::exception& e ) {
       edump((e.to_detail_string()));
       throw;
@@ -31,6 +31,7 @@
 #include "../common/betting_test_markets.hpp"
 
 #include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
 #include <fc/crypto/openssl.hpp>
 #include <fc/log/appender.hpp>
 #include <openssl/rand.h>
@@ -46,6 +47,7 @@
 #include <graphene/chain/proposal_object.hpp>
 
 #include <graphene/bookie/bookie_api.hpp>
+#include <graphene/bookie/bookie_objects.hpp>
 
 struct enable_betting_logging_config {
    enable_betting_logging_config()
@@ -307,6 +309,98 @@ BOOST_AUTO_TEST_CASE(binned_order_books)
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE(binned_order_book_after_undo)
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      CREATE_ICE_HOCKEY_BETTING_MARKET(false, 0);
+
+      graphene::bookie::bookie_api bookie_api(app);
+      transfer(account_id_type(), alice_id, asset(10000));
+      transfer(account_id_type(), bob_id, asset(10000));
+
+      place_bet(bob_id, capitals_win_market_id, bet_type::back, asset(100, asset_id_type()), 2 * GRAPHENE_BETTING_ODDS_PRECISION);
+      generate_blocks(1);
+      auto book_as_json = [&]() {
+         return fc::json::to_string(fc::variant(bookie_api.get_binned_order_book(capitals_win_market_id, 1), GRAPHENE_MAX_NESTED_OBJECTS));
+      };
+      const std::string book_before = book_as_json();
+      BOOST_REQUIRE_EQUAL(bookie_api.get_binned_order_book(capitals_win_market_id, 1).aggregated_back_bets.size(), 1u);
+
+      // alice's pending bet matches bob's completely, which removes it from the books
+      share_type lay_amount = bet_object::get_approximate_matching_amount(100, 2 * GRAPHENE_BETTING_ODDS_PRECISION, bet_type::back, true /* round up */);
+      place_bet(alice_id, capitals_win_market_id, bet_type::lay, asset(lay_amount, asset_id_type()), 2 * GRAPHENE_BETTING_ODDS_PRECISION);
+      BOOST_CHECK(bookie_api.get_binned_order_book(capitals_win_market_id, 1).aggregated_back_bets.empty());
+
+      // undoing the pending transaction puts bob's bet back on the books
+      db.clear_pending();
+      BOOST_CHECK_EQUAL(book_as_json(), book_before);
+      generate_blocks(1);
+      BOOST_CHECK_EQUAL(book_as_json(), book_before);
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE(binned_order_book_subscription)
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      CREATE_ICE_HOCKEY_BETTING_MARKET(false, 0);
+
+      graphene::bookie::bookie_api bookie_api(app);
+      transfer(account_id_type(), bob_id, asset(10000));
+
+      std::vector<graphene::bookie::binned_order_book> updates;
+      bookie_api.subscribe_to_binned_order_book([&updates](const variant& update) {
+         updates.push_back(update.as<graphene::bookie::binned_order_book>(GRAPHENE_MAX_NESTED_OBJECTS));
+      }, capitals_win_market_id, 1);
+
+      // back bets at 1.55 and 1.6 go to the 1.6 bin, the one at 1.65 to the 1.7 bin
+      place_bet(bob_id, capitals_win_market_id, bet_type::back, asset(100, asset_id_type()), 155 * GRAPHENE_BETTING_ODDS_PRECISION / 100);
+      place_bet(bob_id, capitals_win_market_id, bet_type::back, asset(100, asset_id_type()), 16 * GRAPHENE_BETTING_ODDS_PRECISION / 10);
+      place_bet(bob_id, capitals_win_market_id, bet_type::back, asset(100, asset_id_type()), 165 * GRAPHENE_BETTING_ODDS_PRECISION / 100);
+      generate_blocks(1);
+      fc::usleep(fc::milliseconds(200));
+
+      BOOST_REQUIRE_EQUAL(updates.size(), 1u);
+      BOOST_REQUIRE_EQUAL(updates[0].aggregated_back_bets.size(), 2u);
+      BOOST_CHECK_EQUAL(updates[0].aggregated_back_bets[0].backer_multiplier, 16 * GRAPHENE_BETTING_ODDS_PRECISION / 10);
+      BOOST_CHECK(updates[0].aggregated_back_bets[0].amount_to_bet == 200);
+      BOOST_CHECK_EQUAL(updates[0].aggregated_back_bets[1].backer_multiplier, 17 * GRAPHENE_BETTING_ODDS_PRECISION / 10);
+      BOOST_CHECK(updates[0].aggregated_back_bets[1].amount_to_bet == 100);
+      BOOST_CHECK(updates[0].aggregated_lay_bets.empty());
+
+      // only the bin that changed is pushed
+      place_bet(bob_id, capitals_win_market_id, bet_type::back, asset(100, asset_id_type()), 167 * GRAPHENE_BETTING_ODDS_PRECISION / 100);
+      generate_blocks(1);
+      fc::usleep(fc::milliseconds(200));
+
+      BOOST_REQUIRE_EQUAL(updates.size(), 2u);
+      BOOST_REQUIRE_EQUAL(updates[1].aggregated_back_bets.size(), 1u);
+      BOOST_CHECK_EQUAL(updates[1].aggregated_back_bets[0].backer_multiplier, 17 * GRAPHENE_BETTING_ODDS_PRECISION / 10);
+      BOOST_CHECK(updates[1].aggregated_back_bets[0].amount_to_bet == 200);
+
+      // a block that leaves the book alone pushes nothing
+      generate_blocks(1);
+      fc::usleep(fc::milliseconds(200));
+      BOOST_CHECK_EQUAL(updates.size(), 2u);
+
+      graphene::bookie::binned_order_book order_book = bookie_api.get_binned_order_book(capitals_win_market_id, 1);
+      BOOST_REQUIRE_EQUAL(order_book.aggregated_back_bets.size(), 2u);
+      BOOST_CHECK(order_book.aggregated_back_bets[0].amount_to_bet == 200);
+      BOOST_CHECK(order_book.aggregated_back_bets[1].amount_to_bet == 200);
+
+      bookie_api.unsubscribe_from_binned_order_book(capitals_win_market_id);
+      place_bet(bob_id, capitals_win_market_id, bet_type::back, asset(100, asset_id_type()), 2 * GRAPHENE_BETTING_ODDS_PRECISION);
+      generate_blocks(1);
+      fc::usleep(fc::milliseconds(200));
+      BOOST_CHECK_EQUAL(updates.size(), 2u);
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( peerplays_sport_create_test )
 {
    try
@@ -919,6 +1013,215 @@ BOOST_AUTO_TEST_CASE(persistent_objects_test)
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE(matched_bets_for_bettor_from_history)
+{
+   try
+   {
+      graphene::bookie::bookie_api bookie_api(app);
+      const auto &aidx = dynamic_cast<const base_primary_index &>(db.get_index_type<bet_object_index>());
+      auto &bet_history = const_cast<graphene::bookie::detail::persistent_bet_index &>(aidx.get_secondary_index<graphene::bookie::detail::persistent_bet_index>());
+
+      // bets from three bettors, as the bookie plugin records them; every other bet matched
+      const uint32_t bettors = 3;
+      const uint32_t historical_bets = 60;
+      bet_object bet;
+      for (uint32_t i = 0; i < historical_bets; ++i)
+      {
+         bet.id = bet_id_type(i);
+         bet.bettor_id = account_id_type(i % bettors);
+         bet.amount_to_bet = asset(100 + i);
+         bet_history.object_inserted(bet);
+         if ((i / bettors) % 2 == 0)
+            bet_history.internal.modify(bet.id, [](graphene::bookie::detail::persistent_bet_index::internal_type& b) {
+               b.amount_matched = 100;
+            });
+      }
+
+      const account_id_type bettor(1);
+      std::vector<graphene::bookie::matched_bet_object> matched_bets = bookie_api.get_matched_bets_for_bettor(bettor);
+      BOOST_REQUIRE_EQUAL(matched_bets.size(), historical_bets / bettors / 2);
+      for (const graphene::bookie::matched_bet_object& matched_bet : matched_bets)
+      {
+         BOOST_CHECK(matched_bet.bettor_id == bettor);
+         BOOST_CHECK(matched_bet.amount_matched == 100);
+      }
+
+      // paging through the same bets, each page starting after the last bet of the previous one
+      std::vector<graphene::bookie::matched_bet_object> paged_bets;
+      bet_id_type last_bet;
+      while (true)
+      {
+         std::vector<graphene::bookie::matched_bet_object> page = bookie_api.get_all_matched_bets_for_bettor(bettor, last_bet, 4);
+         if (page.empty())
+            break;
+         BOOST_CHECK_LE(page.size(), 4u);
+         paged_bets.insert(paged_bets.end(), page.begin(), page.end());
+         last_bet = page.back().id;
+      }
+      BOOST_REQUIRE_EQUAL(paged_bets.size(), matched_bets.size());
+      for (size_t i = 0; i < paged_bets.size(); ++i)
+         BOOST_CHECK(paged_bets[i].id == matched_bets[i].id);
+
+      BOOST_CHECK(bookie_api.get_matched_bets_for_bettor(account_id_type(bettors)).empty());
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE(events_containing_sub_string)
+{
+   try
+   {
+      CREATE_ICE_HOCKEY_BETTING_MARKET(false, 0);
+      graphene::bookie::bookie_api bookie_api(app);
+
+      auto find_events = [&](const std::string& sub_string, const std::string& language) {
+         std::vector<event_object> events = bookie_api.get_events_containing_sub_string(sub_string, language);
+         BOOST_CHECK_LE(events.size(), 1u);
+         return events.size() == 1 && events[0].id == capitals_vs_blackhawks_id;
+      };
+      BOOST_CHECK(find_events("capitals", "en"));
+      BOOST_CHECK(find_events("CHICAGO black", "en"));
+      BOOST_CHECK(find_events("Ca", "en"));
+      BOOST_CHECK(find_events("", "en"));
+      BOOST_CHECK(find_events("芝加哥", "zh_Hans"));
+      BOOST_CHECK(!find_events("capitals", "zh_Hans"));
+      BOOST_CHECK(!find_events("capitals", "de"));
+      BOOST_CHECK(!find_events("capitals/washington", "en"));
+      BOOST_CHECK(bookie_api.get_first_events_containing_sub_string("capitals", "en", 0).empty());
+      BOOST_CHECK_EQUAL(bookie_api.get_first_events_containing_sub_string("ca", "en", 1).size(), 1u);
+      GRAPHENE_REQUIRE_THROW(bookie_api.get_first_events_containing_sub_string("capitals", "en", 1001), fc::exception);
+
+      update_event(capitals_vs_blackhawks_id, _name = internationalized_string_type({{"en", "Washington Capitals vs. Chicago Blackhawks"}}));
+      generate_blocks(1);
+      BOOST_CHECK(find_events("capitals vs. chicago", "en"));
+      BOOST_CHECK(!find_events("capitals/chicago", "en"));
+      BOOST_CHECK(!find_events("芝加哥", "zh_Hans"));
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE(event_name_index_forgets_old_names)
+{
+   try
+   {
+      graphene::bookie::detail::event_name_index event_names;
+      event_object event;
+      event.id = event_id_type(0);
+      event.name = {{"en", "Washington Capitals/Chicago Blackhawks"}};
+      event_names.object_inserted(event);
+      event.id = event_id_type(1);
+      event.name = {{"en", "Washington Capitals/Boston Bruins"}};
+      event_names.object_inserted(event);
+      BOOST_CHECK_EQUAL(event_names.find_events("capitals/", "en", 1000).size(), 2u);
+      BOOST_CHECK_EQUAL(event_names.find_events("capitals/", "en", 1).size(), 1u);
+
+      // renamed and removed events are no longer found by their old names
+      event.id = event_id_type(0);
+      event.name = {{"en", "Wanderers/Celtic"}};
+      event_names.object_modified(event);
+      BOOST_CHECK_EQUAL(event_names.find_events("wanderers", "en", 1000).size(), 1u);
+      BOOST_REQUIRE_EQUAL(event_names.find_events("capitals/", "en", 1000).size(), 1u);
+      BOOST_CHECK(event_names.find_events("capitals/", "en", 1000).front() == event_id_type(1));
+      event_names.object_removed(event);
+      BOOST_CHECK(event_names.find_events("wanderers", "en", 1000).empty());
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE(bookie_history_store_reads_back_evicted_objects)
+{
+   try
+   {
+      typedef graphene::bookie::detail::persistent_bet_index::internal_type bet_history_type;
+      graphene::bookie::detail::history_store<bet_id_type, bet_history_type> history;
+
+      // stored before there is a log, moved to it on open
+      bet_object bet;
+      bet.id = bet_id_type(0);
+      bet.amount_to_bet = asset(100);
+      history.store(bet.id, bet);
+
+      fc::temp_directory history_dir(graphene::utilities::temp_directory_path());
+      history.open(history_dir.path() / "bets.log", 64 * 1024);
+      BOOST_CHECK(history.is_open());
+
+      const uint32_t bets = 20000;
+      for (uint32_t i = 1; i < bets; ++i)
+      {
+         bet.id = bet_id_type(i);
+         bet.amount_to_bet = asset(100 + i);
+         history.store(bet.id, bet);
+      }
+      // rewriting the bets over and over supersedes most of the log, so it gets compacted along the way
+      for (uint32_t round = 1; round <= 5; ++round)
+         for (uint32_t i = 0; i < bets; i += 2)
+            BOOST_REQUIRE(history.modify(bet_id_type(i), [&](bet_history_type& b) {
+               b.amount_matched = round;
+               b.associated_operations.emplace_back(operation_history_id_type(round));
+            }));
+
+      auto check_history = [&]() {
+         BOOST_CHECK_EQUAL(history.size(), bets);
+         for (uint32_t i = 0; i < bets; ++i)
+         {
+            fc::optional<bet_history_type> stored = history.find(bet_id_type(i));
+            BOOST_REQUIRE(stored.valid());
+            BOOST_CHECK(stored->ephemeral_bet_object.id == bet_id_type(i));
+            BOOST_CHECK(stored->ephemeral_bet_object.amount_to_bet == asset(100 + i));
+            BOOST_CHECK(stored->amount_matched == (i % 2 ? 0 : 5));
+            BOOST_CHECK_EQUAL(stored->associated_operations.size(), i % 2 ? 0u : 5u);
+         }
+         BOOST_CHECK(!history.find(bet_id_type(bets)).valid());
+         BOOST_CHECK(!history.modify(bet_id_type(bets), [](bet_history_type&) {}));
+      };
+      // a compaction may still be running, the log stays in use meanwhile
+      check_history();
+      history.wait_for_compaction();
+      check_history();
+      history.close();
+      BOOST_CHECK(!fc::exists(history_dir.path() / "bets.log"));
+      BOOST_CHECK(!fc::exists(history_dir.path() / "bets.log.tmp"));
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE(bookie_history_store_keeps_objects_it_cannot_write)
+{
+   try
+   {
+      typedef graphene::bookie::detail::persistent_bet_index::internal_type bet_history_type;
+      graphene::bookie::detail::history_store<bet_id_type, bet_history_type> history;
+
+      // every write to /dev/full fails as if the disk were full
+      fc::temp_directory history_dir(graphene::utilities::temp_directory_path());
+      fc::path full_disk = history_dir.path() / "bets.log";
+      boost::filesystem::create_symlink("/dev/full", full_disk);
+      history.open(full_disk, 1024);
+
+      bet_object bet;
+      bet.amount_to_bet = asset(100);
+      for (uint32_t i = 0; i < 100; ++i)
+      {
+         bet.id = bet_id_type(i);
+         history.store(bet.id, bet);
+      }
+      BOOST_REQUIRE(history.modify(bet_id_type(7), [](bet_history_type& b) { b.amount_matched = 5; }));
+
+      BOOST_CHECK_EQUAL(history.size(), 100u);
+      BOOST_CHECK(history.contains(bet_id_type(99)));
+      for (uint32_t i = 0; i < 100; ++i)
+      {
+         fc::optional<bet_history_type> stored = history.find(bet_id_type(i));
+         BOOST_REQUIRE(stored.valid());
+         BOOST_CHECK(stored->ephemeral_bet_object.id == bet_id_type(i));
+         BOOST_CHECK(stored->amount_matched == (i == 7 ? 5 : 0));
+      }
+      history.close();
+      BOOST_CHECK(fc::exists("/dev/full"));
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE(test_settled_market_states)
 {
    try
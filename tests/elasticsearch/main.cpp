@@ -25,10 +25,19 @@
 #include <graphene/app/api.hpp>
 #include <graphene/utilities/tempdir.hpp>
 #include <fc/crypto/digest.hpp>
+#include <fc/io/fstream.hpp>
 
 #include <graphene/utilities/elasticsearch.hpp>
+#include <graphene/utilities/es_bulk_sender.hpp>
 #include <graphene/elasticsearch/elasticsearch_plugin.hpp>
 
+#include <boost/algorithm/string.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include "../common/database_fixture.hpp"
 
 #define BOOST_TEST_MODULE Elastic Search Database Tests
@@ -537,3 +546,240 @@ BOOST_AUTO_TEST_CASE(elasticsearch_history_api) {
    }
 }
 BOOST_AUTO_TEST_SUITE_END()
+
+/// HTTP server on localhost standing in for Elasticsearch, failing the first `failures` requests with a 500,
+/// or with item errors if item_errors is set; after that it rejects the operations whose source contains `reject`
+/// with a 400, and takes `delay_ms` to answer each request
+struct es_stub
+{
+   explicit es_stub( uint32_t failures, bool item_errors = false, const std::string& reject = std::string(),
+                     uint32_t delay_ms = 0 )
+      : _failures( failures ), _item_errors( item_errors ), _reject( reject ), _delay_ms( delay_ms )
+   {
+      _fd = socket( AF_INET, SOCK_STREAM, 0 );
+      sockaddr_in addr = {};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+      socklen_t len = sizeof( addr );
+      FC_ASSERT( bind( _fd, (sockaddr*)&addr, len ) == 0 && listen( _fd, 16 ) == 0 );
+      FC_ASSERT( getsockname( _fd, (sockaddr*)&addr, &len ) == 0 );
+      url = "http://127.0.0.1:" + std::to_string( ntohs( addr.sin_port ) ) + "/";
+      _thread = std::thread( [this]() { serve(); } );
+   }
+   ~es_stub()
+   {
+      shutdown( _fd, SHUT_RDWR );
+      close( _fd );
+      _thread.join();
+   }
+
+   std::vector<std::string> received()
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      return _received;
+   }
+
+   std::string url;
+
+private:
+   void serve()
+   {
+      int conn;
+      while( ( conn = accept( _fd, nullptr, nullptr ) ) >= 0 )
+      {
+         std::string request;
+         char buf[4096];
+         size_t header_end = std::string::npos;
+         size_t content_length = 0;
+         ssize_t n;
+         while( ( n = recv( conn, buf, sizeof( buf ), 0 ) ) > 0 )
+         {
+            request.append( buf, n );
+            if( header_end == std::string::npos && ( header_end = request.find( "\r\n\r\n" ) ) != std::string::npos )
+            {
+               auto pos = request.find( "Content-Length: " );
+               if( pos != std::string::npos && pos < header_end )
+                  content_length = std::stoul( request.substr( pos + 16 ) );
+            }
+            if( header_end != std::string::npos && request.size() >= header_end + 4 + content_length )
+               break;
+         }
+         bool fail;
+         {
+            std::lock_guard<std::mutex> lock( _mutex );
+            fail = _failures > 0;
+            if( fail )
+               --_failures;
+            else if( header_end != std::string::npos )
+               _received.push_back( request.substr( header_end + 4 ) );
+         }
+         const bool server_error = fail && !_item_errors;
+         std::string body = server_error ? "{}" : fail ? "{\"errors\":true}" : "{\"errors\":false}";
+         if( !fail && !_reject.empty() && header_end != std::string::npos )
+         {
+            // every operation is an action line and a source line
+            std::vector<std::string> lines;
+            const std::string content = request.substr( header_end + 4 );
+            boost::split( lines, content, boost::is_any_of( "\n" ) );
+            bool errors = false;
+            std::string items;
+            for( size_t i = 1; i < lines.size(); i += 2 )
+            {
+               const bool rejected = lines[i].find( _reject ) != std::string::npos;
+               errors |= rejected;
+               items += std::string( items.empty() ? "" : "," ) + ( rejected
+                     ? "{\"index\":{\"status\":400,\"error\":{\"type\":\"mapper_parsing_exception\"}}}"
+                     : "{\"index\":{\"status\":201}}" );
+            }
+            body = std::string( "{\"errors\":" ) + ( errors ? "true" : "false" ) + ",\"items\":[" + items + "]}";
+         }
+         if( _delay_ms > 0 )
+            std::this_thread::sleep_for( std::chrono::milliseconds( _delay_ms ) );
+         const std::string response = std::string( server_error ? "HTTP/1.1 500 Internal Server Error" : "HTTP/1.1 200 OK" )
+               + "\r\nContent-Type: application/json\r\nConnection: close\r\nContent-Length: "
+               + std::to_string( body.size() ) + "\r\n\r\n" + body;
+         send( conn, response.data(), response.size(), 0 );
+         close( conn );
+      }
+   }
+
+   int                      _fd;
+   uint32_t                 _failures;
+   bool                     _item_errors;
+   std::string              _reject;
+   uint32_t                 _delay_ms;
+   std::mutex               _mutex;
+   std::vector<std::string> _received;
+   std::thread              _thread;
+};
+
+static bool wait_for_sent( const graphene::utilities::es_bulk_sender& sender, uint64_t count )
+{
+   for( int i = 0; i < 1000 && sender.get_stats().sent_batches < count; ++i )
+      std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+   return sender.get_stats().sent_batches == count;
+}
+
+/// whether the stub got the bodies numbered 0 to count - 1 once each, in any order as they are sent side by side
+static bool received_all( es_stub& stub, int count )
+{
+   std::vector<std::string> received = stub.received();
+   std::vector<std::string> expected;
+   for( int i = 0; i < count; ++i )
+      expected.push_back( "{\"index\":{}}\n{\"n\":" + std::to_string( i ) + "}\n" );
+   std::sort( received.begin(), received.end() );
+   std::sort( expected.begin(), expected.end() );
+   return received == expected;
+}
+
+BOOST_AUTO_TEST_CASE(elasticsearch_bulk_sender) {
+   try {
+      // retried until the stub accepts them
+      {
+         es_stub stub( 2 );
+         graphene::utilities::es_bulk_sender::options opts;
+         opts.url = stub.url;
+         opts.min_backoff_ms = 10;
+         graphene::utilities::es_bulk_sender sender( opts );
+         for( int i = 0; i < 20; ++i )
+            sender.enqueue( "{\"index\":{}}\n{\"n\":" + std::to_string( i ) + "}\n" );
+         BOOST_REQUIRE( wait_for_sent( sender, 20 ) );
+         const auto stats = sender.get_stats();
+         BOOST_CHECK_EQUAL( stats.failed_attempts, 2u );
+         BOOST_CHECK_EQUAL( stats.queued_batches, 0u );
+         BOOST_CHECK_EQUAL( stats.queued_bytes, 0u );
+         BOOST_CHECK( received_all( stub, 20 ) );
+      }
+
+      // item errors are retried as well, and requests are in flight side by side
+      {
+         es_stub stub( 3, true, std::string(), 20 );
+         graphene::utilities::es_bulk_sender::options opts;
+         opts.url = stub.url;
+         opts.min_backoff_ms = 10;
+         graphene::utilities::es_bulk_sender sender( opts );
+         for( int i = 0; i < 10; ++i )
+            sender.enqueue( "{\"index\":{\"_id\":\"" + std::to_string( i ) + "\"}}\n{\"n\":" + std::to_string( i ) + "}\n" );
+         uint32_t max_in_flight = 0;
+         for( int i = 0; i < 1000 && sender.get_stats().sent_batches < 10; ++i )
+         {
+            max_in_flight = std::max( max_in_flight, sender.get_stats().in_flight );
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+         }
+         BOOST_REQUIRE( wait_for_sent( sender, 10 ) );
+         BOOST_CHECK_EQUAL( max_in_flight, 2u );
+         const auto stats = sender.get_stats();
+         BOOST_CHECK_EQUAL( stats.failed_attempts, 3u );
+         BOOST_CHECK_EQUAL( stats.dropped_batches, 0u );
+         auto received = stub.received();
+         BOOST_REQUIRE_EQUAL( received.size(), 10u );
+         std::sort( received.begin(), received.end() );
+         BOOST_CHECK( std::unique( received.begin(), received.end() ) == received.end() );
+      }
+
+      // an operation rejected for good is tried a few times, then set aside while the rest of its request is sent
+      {
+         fc::temp_directory rejected_dir( graphene::utilities::temp_directory_path() );
+         es_stub stub( 0, false, "bad" );
+         graphene::utilities::es_bulk_sender::options opts;
+         opts.url = stub.url;
+         opts.min_backoff_ms = 10;
+         opts.max_item_error_attempts = 3;
+         opts.rejected_file = rejected_dir.path() / "rejected.bulk";
+         graphene::utilities::es_bulk_sender sender( opts );
+         const std::string good = "{\"index\":{\"_id\":\"1\"}}\n{\"n\":1}\n";
+         const std::string bad = "{\"index\":{\"_id\":\"2\"}}\n{\"n\":\"bad\"}\n";
+         sender.enqueue( good + bad );
+         sender.enqueue( std::string( good ) );
+         BOOST_REQUIRE( wait_for_sent( sender, 2 ) );
+         const auto stats = sender.get_stats();
+         BOOST_CHECK_EQUAL( stats.rejected_items, 1u );
+         BOOST_CHECK_EQUAL( stats.failed_attempts, 2u );
+         std::vector<std::string> received = stub.received();
+         BOOST_CHECK_EQUAL( std::count( received.begin(), received.end(), good + bad ), 1 );
+         BOOST_CHECK_EQUAL( std::count( received.begin(), received.end(), bad ), 2 );
+         BOOST_CHECK_EQUAL( std::count( received.begin(), received.end(), good ), 1 );
+         std::string rejected;
+         fc::read_file_contents( opts.rejected_file, rejected );
+         BOOST_CHECK_EQUAL( rejected, bad );
+      }
+
+      // spilled while the cluster is down, and picked up by the next sender
+      fc::temp_directory spill_dir( graphene::utilities::temp_directory_path() );
+      auto spilled_files = [&spill_dir]() {
+         size_t count = 0;
+         for( fc::directory_iterator itr( spill_dir.path() ); itr != fc::directory_iterator(); ++itr )
+            ++count;
+         return count;
+      };
+      {
+         es_stub down( std::numeric_limits<uint32_t>::max() );
+         graphene::utilities::es_bulk_sender::options opts;
+         opts.url = down.url;
+         opts.spill_dir = spill_dir.path();
+         opts.max_queue_bytes = 1;
+         opts.min_backoff_ms = 10;
+         graphene::utilities::es_bulk_sender sender( opts );
+         for( int i = 0; i < 5; ++i )
+            sender.enqueue( "{\"index\":{}}\n{\"n\":" + std::to_string( i ) + "}\n" );
+         BOOST_CHECK_GE( sender.get_stats().spilled_batches + sender.get_stats().in_flight, 3u );
+         sender.stop( std::chrono::milliseconds( 0 ) );
+         BOOST_CHECK_EQUAL( sender.get_stats().sent_batches, 0u );
+      }
+      BOOST_CHECK_EQUAL( spilled_files(), 5u );
+      {
+         es_stub stub( 0 );
+         graphene::utilities::es_bulk_sender::options opts;
+         opts.url = stub.url;
+         opts.spill_dir = spill_dir.path();
+         graphene::utilities::es_bulk_sender sender( opts );
+         BOOST_REQUIRE( wait_for_sent( sender, 5 ) );
+         BOOST_CHECK( received_all( stub, 5 ) );
+      }
+      BOOST_CHECK_EQUAL( spilled_files(), 0u );
+   }
+   catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -22,6 +22,12 @@
  * THE SOFTWARE.
  */
 #include <boost/test/unit_test.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include <graphene/app/database_api.hpp>
+
+#include <graphene/bookie/bookie_api.hpp>
+#include <graphene/bookie/bookie_objects.hpp>
 
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/protocol/protocol.hpp>
@@ -29,12 +35,22 @@
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
+#include <graphene/chain/distinct_number_picker.hpp>
 
 #include <graphene/db/simple_index.hpp>
+#include <graphene/db/thread_pool.hpp>
+
+#include <graphene/net/message_oriented_connection.hpp>
+#include <graphene/net/stcp_socket.hpp>
 
 #include <fc/crypto/digest.hpp>
+#include <fc/io/json.hpp>
+#include <fc/network/tcp_socket.hpp>
+#include <fc/thread/thread.hpp>
 #include "../common/database_fixture.hpp"
 
+#include <random>
+
 using namespace graphene::chain;
 
 //BOOST_FIXTURE_TEST_SUITE( performance_tests, database_fixture )
@@ -50,7 +66,417 @@ BOOST_AUTO_TEST_CASE( sigcheck_benchmark )
    auto end = fc::time_point::now();
    auto elapsed = end-start;
    wdump( ((100000.0*1000000.0) / elapsed.count()) );
+
+   // recovering the signees of a block's worth of transactions, serially and on a thread pool
+   const uint32_t trx_count = 20000;
+   const chain_id_type chain_id = fc::sha256::hash( "sigcheck_benchmark" );
+   vector<signed_transaction> trxs( trx_count );
+   for( uint32_t i = 0; i < trx_count; ++i )
+   {
+      trxs[i].expiration = fc::time_point_sec( i );
+      trxs[i].sign( nathan_key, chain_id );
+   }
+   for( uint32_t threads : { 0, 2, 4, 8 } )
+   {
+      for( auto& trx : trxs )
+         trx.signees.clear();
+      graphene::db::thread_pool pool( threads );
+      start = fc::time_point::now();
+      pool.run( trxs.size(), [&trxs,&chain_id]( size_t i ) { trxs[i].get_signature_keys( chain_id ); } );
+      elapsed = fc::time_point::now() - start;
+      BOOST_CHECK( trxs.back().signees.size() == 1 );
+      wlog( "Recovered ${n} transaction signees with ${t} threads: ${r} trx/s",
+            ("n",trx_count)("t",threads)("r",(trx_count*1000000.0) / elapsed.count()) );
+   }
+}
+
+// records and replays the undo entries of a block touching 50000 objects twice each, using the
+// node based containers undo_state used to hold and the flat_undo_map that replaced them
+BOOST_AUTO_TEST_CASE( undo_state_benchmark )
+{
+   const uint32_t object_count = 50000;
+   const uint32_t rounds = 20;
+   account_object acct;
+
+   std::unordered_map<object_id_type, std::unique_ptr<graphene::db::object>> hashed;
+   fc::microseconds hashed_modify, hashed_undo;
+   for( uint32_t r = 0; r < rounds; ++r )
+   {
+      auto start = fc::time_point::now();
+      for( uint32_t pass = 0; pass < 2; ++pass )
+         for( uint32_t i = 0; i < object_count; ++i )
+         {
+            acct.id = account_id_type( i );
+            if( hashed.find( acct.id ) == hashed.end() )
+               hashed[acct.id] = acct.clone();
+         }
+      auto mid = fc::time_point::now();
+      uint64_t restored = 0;
+      for( auto& item : hashed )
+         restored += item.second->id.instance();
+      hashed.clear();
+      hashed_modify += mid - start;
+      hashed_undo += fc::time_point::now() - mid;
+      BOOST_CHECK_EQUAL( restored, uint64_t( object_count ) * ( object_count - 1 ) / 2 );
+   }
+
+   graphene::db::flat_undo_map<std::unique_ptr<graphene::db::object>> flat;
+   fc::microseconds flat_modify, flat_undo;
+   for( uint32_t r = 0; r < rounds; ++r )
+   {
+      auto start = fc::time_point::now();
+      for( uint32_t pass = 0; pass < 2; ++pass )
+         for( uint32_t i = 0; i < object_count; ++i )
+         {
+            acct.id = account_id_type( i );
+            if( !flat.contains( acct.id ) )
+               flat.insert( acct.id, acct.clone() );
+         }
+      auto mid = fc::time_point::now();
+      uint64_t restored = 0;
+      for( auto& item : flat )
+         restored += item.second->id.instance();
+      flat.clear();
+      flat_modify += mid - start;
+      flat_undo += fc::time_point::now() - mid;
+      BOOST_CHECK_EQUAL( restored, uint64_t( object_count ) * ( object_count - 1 ) / 2 );
+   }
+
+   wlog( "undo_state on_modify: unordered_map ${h} us, flat_undo_map ${f} us",
+         ("h",hashed_modify.count()/rounds)("f",flat_modify.count()/rounds) );
+   wlog( "undo_state undo walk: unordered_map ${h} us, flat_undo_map ${f} us",
+         ("h",hashed_undo.count()/rounds)("f",flat_undo.count()/rounds) );
+}
+
+BOOST_AUTO_TEST_CASE( distinct_number_picker_benchmark )
+{
+   const uint64_t selections = 1000;
+   for( uint64_t range : { uint64_t(1000), uint64_t(100000), uint64_t(1000000) } )
+   {
+      std::mt19937_64 rng( range );
+      vector<uint64_t> draws;
+      for( uint64_t i = 0; i < selections; ++i )
+         draws.push_back( rng() % ( range - i ) );
+
+      auto start = fc::time_point::now();
+      vector<uint64_t> tmpv;
+      for( uint64_t i = 0; i < range; ++i )
+         tmpv.push_back( i );
+      vector<uint64_t> erased;
+      for( uint64_t idx : draws )
+      {
+         erased.push_back( tmpv.at( idx ) );
+         tmpv.erase( tmpv.begin() + idx );
+      }
+      auto erase_time = fc::time_point::now() - start;
+
+      start = fc::time_point::now();
+      distinct_number_picker picker( 0, range );
+      vector<uint64_t> picked;
+      for( uint64_t idx : draws )
+         picked.push_back( picker.pick( idx ) );
+      auto picker_time = fc::time_point::now() - start;
+
+      BOOST_CHECK( picked == erased );
+      wlog( "${k} distinct picks out of ${n}: vector erase ${e} us, distinct_number_picker ${p} us",
+            ("k",selections)("n",range)("e",erase_time.count())("p",picker_time.count()) );
+   }
 }
+
+namespace {
+   struct counting_delegate : public graphene::net::message_oriented_connection_delegate
+   {
+      uint32_t received = 0;
+      uint32_t mismatched = 0;
+      uint32_t expected_size = 0;
+      uint32_t expected_count = 0;
+      fc::promise<void>::ptr all_received; ///< set once expected_count messages arrived
+
+      void on_message( graphene::net::message_oriented_connection*, const graphene::net::message& m ) override
+      {
+         ++received;
+         if( m.size != expected_size || m.data.size() != expected_size )
+            ++mismatched;
+         if( all_received && received == expected_count )
+            all_received->set_value();
+      }
+      void on_connection_closed( graphene::net::message_oriented_connection* ) override {}
+   };
+}
+
+// streams messages over a loopback connection and reads them back with the read loop message_oriented_connection
+// used to have (a 16 byte read followed by a read of the rest of each frame) and with its buffered reader
+BOOST_AUTO_TEST_CASE( message_framing_benchmark )
+{ try {
+   using namespace graphene::net;
+   const uint32_t message_count = 5000;
+   const fc::ip::address loopback( "127.0.0.1" );
+
+   for( uint32_t payload_size : { 100u, 1000u, 50000u } )
+   {
+      message msg;
+      msg.msg_type = 1000;
+      msg.data.assign( payload_size, 'x' );
+      msg.size = payload_size;
+
+      counting_delegate sender_delegate;
+      auto send_all = [&]( message_oriented_connection& sender, uint16_t port ) {
+         return fc::async( [&sender, &msg, &loopback, port, message_count]() {
+            sender.connect_to( fc::ip::endpoint( loopback, port ) );
+            for( uint32_t i = 0; i < message_count; ++i )
+               sender.send_message( msg );
+         } );
+      };
+
+      fc::microseconds legacy_time;
+      {
+         fc::tcp_server server;
+         server.listen( fc::ip::endpoint( loopback, 0 ) );
+         message_oriented_connection sender( &sender_delegate );
+         auto sending = send_all( sender, server.get_port() );
+
+         stcp_socket receiver;
+         server.accept( receiver.get_socket() );
+         receiver.accept();
+
+         auto start = fc::time_point::now();
+         const size_t leftover = 16 - sizeof(message_header);
+         message m;
+         for( uint32_t i = 0; i < message_count; ++i )
+         {
+            char buffer[16];
+            receiver.read( buffer, 16 );
+            memcpy( (char*)&m, buffer, sizeof(message_header) );
+            size_t remaining_bytes_with_padding = 16 * ( ( m.size - leftover + 15 ) / 16 );
+            m.data.resize( leftover + remaining_bytes_with_padding );
+            std::copy( buffer + sizeof(message_header), buffer + sizeof(buffer), m.data.begin() );
+            if( remaining_bytes_with_padding )
+               receiver.read( &m.data[leftover], remaining_bytes_with_padding );
+            m.data.resize( m.size );
+            BOOST_REQUIRE_EQUAL( payload_size, m.data.size() );
+         }
+         legacy_time = fc::time_point::now() - start;
+         sending.wait();
+      }
+
+      fc::microseconds buffered_time;
+      {
+         fc::tcp_server server;
+         server.listen( fc::ip::endpoint( loopback, 0 ) );
+         message_oriented_connection sender( &sender_delegate );
+         auto sending = send_all( sender, server.get_port() );
+
+         counting_delegate receiver_delegate;
+         receiver_delegate.expected_size = payload_size;
+         receiver_delegate.expected_count = message_count;
+         receiver_delegate.all_received = fc::promise<void>::ptr( new fc::promise<void>( "message_framing_benchmark" ) );
+         message_oriented_connection receiver( &receiver_delegate );
+         server.accept( receiver.get_socket() );
+
+         // accept() does the key exchange and then starts the read loop, so timing starts after it as above
+         receiver.accept();
+         auto start = fc::time_point::now();
+         receiver_delegate.all_received->wait();
+         buffered_time = fc::time_point::now() - start;
+         sending.wait();
+
+         BOOST_CHECK_EQUAL( message_count, receiver_delegate.received );
+         BOOST_CHECK_EQUAL( 0u, receiver_delegate.mismatched );
+      }
+
+      wlog( "${n} messages of ${s} bytes: legacy framing ${l} us, buffered framing ${b} us",
+            ("n",message_count)("s",payload_size)("l",legacy_time.count())("b",buffered_time.count()) );
+   }
+} FC_LOG_AND_RETHROW() }
+
+// times block production with a growing number of sessions subscribed to the same accounts; the shared
+// change cache serializes each changed object once, so the cost per extra session stays small
+BOOST_FIXTURE_TEST_CASE( subscription_fanout_benchmark, database_fixture )
+{ try {
+   ACTORS((alice)(bob));
+   fund( alice, asset(10000000) );
+   generate_block();
+
+   for( uint32_t subscribers : { 0, 10, 100, 500 } )
+   {
+      vector<std::unique_ptr<graphene::app::database_api>> sessions;
+      vector<vector<string>> received( subscribers );
+      for( uint32_t i = 0; i < subscribers; ++i )
+      {
+         sessions.emplace_back( new graphene::app::database_api( db ) );
+         sessions.back()->set_subscribe_callback( [&received, i]( const variant& updates ) {
+            received[i].push_back( fc::json::to_string( updates ) );
+         }, false );
+         sessions.back()->get_full_accounts( { "alice", "bob" }, true );
+      }
+
+      const uint32_t blocks = 10;
+      fc::microseconds elapsed;
+      for( uint32_t b = 0; b < blocks; ++b )
+      {
+         for( uint32_t t = 0; t < 20; ++t )
+            transfer( alice_id, bob_id, asset(10 + t) );
+         auto start = fc::time_point::now();
+         generate_block();
+         elapsed += fc::time_point::now() - start;
+      }
+      fc::usleep( fc::milliseconds(200) );
+
+      for( uint32_t i = 1; i < subscribers; ++i )
+         BOOST_CHECK( received[i] == received[0] );
+      if( subscribers )
+         BOOST_CHECK( !received[0].empty() );
+      wlog( "${n} subscribers: ${t} us per block", ("n",subscribers)("t",elapsed.count() / blocks) );
+   }
+} FC_LOG_AND_RETHROW() }
+
+// get_matched_bets_for_bettor and paging with get_all_matched_bets_for_bettor over a history of a million bets
+BOOST_FIXTURE_TEST_CASE( matched_bets_for_bettor_benchmark, database_fixture )
+{ try {
+   graphene::bookie::bookie_api bookie_api( app );
+   const auto& aidx = dynamic_cast<const base_primary_index&>( db.get_index_type<bet_object_index>() );
+   auto& bet_history = const_cast<graphene::bookie::detail::persistent_bet_index&>(
+         aidx.get_secondary_index<graphene::bookie::detail::persistent_bet_index>() );
+
+   // a long history of bets from many bettors, as the bookie plugin records it; half of each bettor's bets matched
+   const uint32_t bettors = 1000;
+   const uint32_t historical_bets = 1000000;
+   bet_object bet;
+   for( uint32_t i = 0; i < historical_bets; ++i )
+   {
+      bet.id = bet_id_type( i );
+      bet.bettor_id = account_id_type( i % bettors );
+      bet.amount_to_bet = asset( 100 + i );
+      bet_history.object_inserted( bet );
+      if( ( i / bettors ) % 2 == 0 )
+         bet_history.internal.modify( bet.id, []( graphene::bookie::detail::persistent_bet_index::internal_type& b ) {
+            b.amount_matched = 100;
+         } );
+   }
+
+   const account_id_type bettor( 42 );
+   auto start = fc::time_point::now();
+   std::vector<graphene::bookie::matched_bet_object> matched_bets = bookie_api.get_matched_bets_for_bettor( bettor );
+   auto all_time = fc::time_point::now() - start;
+   BOOST_REQUIRE_EQUAL( matched_bets.size(), historical_bets / bettors / 2 );
+
+   // paging through the same bets, each page starting after the last bet of the previous one
+   std::vector<graphene::bookie::matched_bet_object> paged_bets;
+   bet_id_type last_bet;
+   start = fc::time_point::now();
+   while( true )
+   {
+      std::vector<graphene::bookie::matched_bet_object> page = bookie_api.get_all_matched_bets_for_bettor( bettor, last_bet, 100 );
+      if( page.empty() )
+         break;
+      paged_bets.insert( paged_bets.end(), page.begin(), page.end() );
+      last_bet = page.back().id;
+   }
+   auto paged_time = fc::time_point::now() - start;
+   BOOST_CHECK_EQUAL( paged_bets.size(), matched_bets.size() );
+
+   wlog( "${n} matched bets of a bettor among ${b} bets: get_matched_bets_for_bettor ${a} us, pages of 100 ${p} us",
+         ("n",matched_bets.size())("b",historical_bets)("a",all_time.count())("p",paged_time.count()) );
+} FC_LOG_AND_RETHROW() }
+
+// find_events of the event name index against the scan over every event name it replaces, over 50000 events
+BOOST_AUTO_TEST_CASE( events_containing_sub_string_benchmark )
+{ try {
+   // a season's worth of events between teams of several leagues, named like the sportsbook names them
+   const std::vector<std::string> teams = {
+      "Washington Capitals", "Chicago Blackhawks", "Boston Bruins", "Montreal Canadiens", "Toronto Maple Leafs",
+      "New York Rangers", "Detroit Red Wings", "Pittsburgh Penguins", "Vancouver Canucks", "Calgary Flames",
+      "Edmonton Oilers", "Los Angeles Kings", "Anaheim Ducks", "San Jose Sharks", "Dallas Stars",
+      "Manchester United", "Manchester City", "Liverpool", "Arsenal", "Chelsea", "Tottenham Hotspur",
+      "Real Madrid", "Barcelona", "Atletico Madrid", "Bayern Munich", "Borussia Dortmund", "Juventus",
+      "AC Milan", "Inter Milan", "Paris Saint-Germain", "Ajax", "Benfica", "Porto", "Celtic", "Rangers" };
+   const uint32_t event_count = 50000;
+
+   graphene::bookie::detail::event_name_index event_names;
+   std::vector<std::pair<event_id_type, std::string>> scanned_names;
+   event_object event;
+   for( uint32_t i = 0; i < event_count; ++i )
+   {
+      event.id = event_id_type( i );
+      std::string name = teams[i % teams.size()] + "/" + teams[(i / teams.size() + i + 1) % teams.size()] +
+                         " " + std::to_string( 2000 + i / 1000 );
+      event.name = {{"en", name}};
+      event_names.object_inserted( event );
+      scanned_names.emplace_back( event.id, name );
+   }
+
+   for( const std::string sub_string : { "capitals", "Madrid/Bar", "Inter Milan/Ajax 2042", "ma", "Wanderers" } )
+   {
+      auto start = fc::time_point::now();
+      std::vector<event_id_type> found = event_names.find_events( sub_string, "en", 1000 );
+      auto index_time = fc::time_point::now() - start;
+
+      start = fc::time_point::now();
+      std::vector<event_id_type> scanned;
+      std::string lower_case_sub_string = boost::algorithm::to_lower_copy( sub_string );
+      for( const auto& name : scanned_names )
+         if( scanned.size() < 1000 && boost::algorithm::to_lower_copy( name.second ).find( lower_case_sub_string ) != std::string::npos )
+            scanned.push_back( name.first );
+      auto scan_time = fc::time_point::now() - start;
+
+      BOOST_CHECK( found == scanned );
+      wlog( "\"${s}\" in ${e} events: ${n} found, index ${i} us, scan ${t} us",
+            ("s",sub_string)("e",event_count)("n",found.size())("i",index_time.count())("t",scan_time.count()) );
+   }
+} FC_LOG_AND_RETHROW() }
+
+// limit orders placed next to call orders that the feed protects, which apply_order() no longer checks for
+// margin calls, and check_call_orders() against call_orders_may_trigger(), the check that skips it
+BOOST_FIXTURE_TEST_CASE( limit_orders_with_call_orders_benchmark, database_fixture )
+{ try {
+   ACTORS((buyer)(seller)(feedproducer));
+
+   const auto& bitusd = create_bitasset( "USDBIT", feedproducer_id );
+   const auto& core   = asset_id_type()(db);
+
+   transfer( committee_account, buyer_id, asset(100000000) );
+   transfer( committee_account, seller_id, asset(100000000) );
+   update_feed_producers( bitusd, {feedproducer.id} );
+
+   price_feed current_feed;
+   current_feed.settlement_price = bitusd.amount( 100 ) / core.amount( 100 );
+   publish_feed( bitusd, feedproducer, current_feed );
+
+   const uint32_t borrowers = 100;
+   for( uint32_t i = 0; i < borrowers; ++i )
+   {
+      const account_object& borrower = create_account( "borrower" + fc::to_string(i) );
+      transfer( committee_account, borrower.id, asset(1000000) );
+      borrow( borrower, bitusd.amount(1000), asset(2000 + 10 * i) );
+   }
+   borrow( seller, bitusd.amount(100000), asset(1000000) );
+   BOOST_REQUIRE( !db.call_orders_may_trigger( bitusd ) );
+
+   // bids of at most 6 CORE per USDBIT and asks of at least 100, so none of them cross
+   const uint32_t orders = 500;
+   auto start = fc::time_point::now();
+   for( uint32_t i = 0; i < orders; ++i )
+   {
+      BOOST_REQUIRE( create_sell_order( buyer, core.amount(100 + i), bitusd.amount(100) ) != nullptr );
+      BOOST_REQUIRE( create_sell_order( seller, bitusd.amount(10), core.amount(1000 + i) ) != nullptr );
+   }
+   auto order_time = fc::time_point::now() - start;
+
+   const uint32_t checks = 100000;
+   start = fc::time_point::now();
+   for( uint32_t i = 0; i < checks; ++i )
+      BOOST_REQUIRE( !db.check_call_orders( bitusd ) );
+   auto check_time = fc::time_point::now() - start;
+   start = fc::time_point::now();
+   for( uint32_t i = 0; i < checks; ++i )
+      BOOST_REQUIRE( !db.call_orders_may_trigger( bitusd ) );
+   auto trigger_time = fc::time_point::now() - start;
+
+   wlog( "${o} limit orders next to ${c} call orders: ${t} us", ("o",2 * orders)("c",borrowers + 1)("t",order_time.count()) );
+   wlog( "${n} checks: check_call_orders ${c} us, call_orders_may_trigger ${t} us",
+         ("n",checks)("c",check_time.count())("t",trigger_time.count()) );
+} FC_LOG_AND_RETHROW() }
+
 /*
 BOOST_AUTO_TEST_CASE( transfer_benchmark )
 {
@@ -30,6 +30,7 @@
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/witness_scheduler_rng.hpp>
+#include <graphene/chain/distinct_number_picker.hpp>
 #include <graphene/chain/exceptions.hpp>
 
 #include <graphene/db/simple_index.hpp>
@@ -41,6 +42,7 @@
 
 #include <algorithm>
 #include <random>
+#include <set>
 
 using namespace graphene::chain;
 using namespace graphene::db;
@@ -728,4 +730,71 @@ BOOST_AUTO_TEST_CASE( bitasset_feed_expiration_test )
    BOOST_CHECK( !o.feed_is_expired( now ) );
 }
 
+/**
+ * distinct_number_picker must pick the same numbers as erasing each pick from a vector holding the whole range,
+ * which is what database::get_random_numbers used to do
+ */
+BOOST_AUTO_TEST_CASE( distinct_number_picker_test )
+{
+   auto check = []( uint64_t minimum, uint64_t maximum, uint64_t selections, std::function<uint64_t(uint64_t)> draw ) {
+      vector<uint64_t> range;
+      for( uint64_t i = minimum; i < maximum; ++i )
+         range.push_back( i );
+      distinct_number_picker picker( minimum, maximum );
+      for( uint64_t i = 0; i < selections && !range.empty(); ++i )
+      {
+         BOOST_REQUIRE_EQUAL( picker.remaining(), range.size() );
+         uint64_t idx = draw( range.size() );
+         uint64_t expected = range[idx];
+         range.erase( range.begin() + idx );
+         BOOST_REQUIRE_EQUAL( picker.pick( idx ), expected );
+      }
+      BOOST_CHECK_EQUAL( picker.remaining(), range.size() );
+   };
+   std::mt19937_64 rng( 7 );
+   auto random_draw = [&rng]( uint64_t bound ) { return rng() % bound; };
+
+   // any number of picks out of small ranges
+   for( uint64_t size = 0; size <= 16; ++size )
+      for( uint64_t selections = 0; selections <= size; ++selections )
+         check( 5, 5 + size, selections, random_draw );
+
+   // larger ranges, picked partially and completely
+   check( 0, 1000, 1000, random_draw );
+   check( 1000000, 1010000, 2000, random_draw );
+   check( uint64_t(1) << 40, (uint64_t(1) << 40) + 5000, 5000, random_draw );
+
+   // always the lowest, always the highest, and alternating between both
+   check( 100, 600, 500, []( uint64_t ) { return uint64_t(0); } );
+   check( 100, 600, 500, []( uint64_t bound ) { return bound - 1; } );
+   uint64_t turn = 0;
+   check( 100, 600, 500, [&turn]( uint64_t bound ) { return ++turn % 2 ? uint64_t(0) : bound - 1; } );
+
+   BOOST_CHECK_EQUAL( distinct_number_picker( 10, 5 ).remaining(), 0u );
+   distinct_number_picker picker( 0, 3 );
+   GRAPHENE_REQUIRE_THROW( picker.pick( 3 ), fc::exception );
+}
+
+BOOST_AUTO_TEST_CASE( get_random_numbers_test )
+{
+   generate_block();
+
+   // a range far too wide to hold in memory
+   const uint64_t minimum = uint64_t(1) << 60;
+   vector<uint64_t> picks = db.get_random_numbers( minimum, minimum * 2, 10000, false );
+   BOOST_CHECK_EQUAL( picks.size(), 10000u );
+   std::set<uint64_t> distinct( picks.begin(), picks.end() );
+   BOOST_CHECK_EQUAL( distinct.size(), picks.size() );
+   BOOST_CHECK( *distinct.begin() >= minimum );
+   BOOST_CHECK( *distinct.rbegin() < minimum * 2 );
+
+   // all of a small range
+   picks = db.get_random_numbers( 10, 20, 10, false );
+   std::sort( picks.begin(), picks.end() );
+   vector<uint64_t> expected = { 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 };
+   BOOST_CHECK( picks == expected );
+
+   GRAPHENE_REQUIRE_THROW( db.get_random_numbers( 10, 20, 11, false ), fc::exception );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
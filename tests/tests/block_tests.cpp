@@ -127,6 +127,141 @@ BOOST_AUTO_TEST_CASE( block_database_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( block_database_group_commit )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+      bdb.set_group_commit( 4, 1024 * 1024 );
+
+      // blocks that are still pending must be readable
+      vector<signed_block> blocks;
+      signed_block b;
+      for( uint32_t i = 0; i < 10; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         bdb.store( b.id(), b );
+         blocks.push_back( b );
+         BOOST_CHECK( bdb.contains( b.id() ) );
+         BOOST_CHECK( bdb.fetch_block_id( b.block_num() ) == b.id() );
+         auto fetch = bdb.fetch_by_number( b.block_num() );
+         BOOST_REQUIRE( fetch.valid() );
+         BOOST_CHECK( fetch->witness == b.witness );
+      }
+
+      // removing a pending block and a written block
+      bdb.remove( blocks[9].id() );
+      BOOST_CHECK( !bdb.contains( blocks[9].id() ) );
+      bdb.remove( blocks[2].id() );
+      BOOST_CHECK( !bdb.fetch_optional( blocks[2].id() ).valid() );
+      BOOST_CHECK( bdb.last_id().valid() );
+      BOOST_CHECK( *bdb.last_id() == blocks[8].id() );
+
+      bdb.close();
+      bdb.open( data_dir.path() );
+      BOOST_CHECK( *bdb.last_id() == blocks[8].id() );
+      for( uint32_t i = 0; i < 9; ++i )
+      {
+         auto fetch = bdb.fetch_optional( blocks[i].id() );
+         BOOST_CHECK_EQUAL( fetch.valid(), i != 2 );
+         if( fetch.valid() )
+            BOOST_CHECK( fetch->witness == blocks[i].witness );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_writes_each_block_by_default )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+
+      // a second reader of the files sees every stored block without a flush, as after a crash
+      signed_block b;
+      for( uint32_t i = 0; i < 3; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         bdb.store( b.id(), b );
+
+         block_database reader;
+         reader.open( data_dir.path() );
+         BOOST_REQUIRE( reader.last_id().valid() );
+         BOOST_CHECK( *reader.last_id() == b.id() );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_compression )
+{
+   try {
+      if( !block_database::is_codec_supported( block_codec::zstd ) )
+      {
+         BOOST_TEST_MESSAGE( "Built without zstd, skipping compressed block log test" );
+         return;
+      }
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      // the first half of the log is stored raw, the second half compressed
+      vector<signed_block> blocks;
+      {
+         block_database bdb;
+         bdb.open( data_dir.path() / "mixed" );
+         signed_block b;
+         for( uint32_t i = 0; i < 10; ++i )
+         {
+            if( i == 5 ) bdb.set_compression( block_codec::zstd );
+            if( i > 0 ) b.previous = b.id();
+            b.witness = witness_id_type(i+1);
+            bdb.store( b.id(), b );
+            blocks.push_back( b );
+            // versions without compression must not find a blocks file to misread
+            BOOST_CHECK( fc::exists( data_dir.path() / "mixed" / "blocks" ) == ( i < 5 ) );
+            BOOST_CHECK( fc::exists( data_dir.path() / "mixed" / "blocks_v2" ) == ( i >= 5 ) );
+         }
+      }
+
+      block_database bdb;
+      bdb.open( data_dir.path() / "mixed" );
+      for( const auto& b : blocks )
+      {
+         // the second fetch of a compressed block is served from the decode cache
+         for( int pass = 0; pass < 2; ++pass )
+         {
+            auto fetch = bdb.fetch_optional( b.id() );
+            BOOST_REQUIRE( fetch.valid() );
+            BOOST_CHECK( fetch->witness == b.witness );
+         }
+      }
+
+      block_database converted;
+      converted.open( data_dir.path() / "converted" );
+      converted.set_compression( block_codec::zstd );
+      BOOST_CHECK_EQUAL( converted.copy_from( bdb ), blocks.size() );
+      BOOST_CHECK( *converted.last_id() == blocks.back().id() );
+      for( const auto& b : blocks )
+      {
+         auto fetch = converted.fetch_by_number( b.block_num() );
+         BOOST_REQUIRE( fetch.valid() );
+         BOOST_CHECK( fetch->id() == b.id() );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( generate_empty_blocks )
 {
    try {
@@ -186,6 +321,51 @@ BOOST_AUTO_TEST_CASE( generate_empty_blocks )
    }
 }
 
+BOOST_AUTO_TEST_CASE( incremental_object_database_snapshots )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      const fc::path db_dir = data_dir.path() / "object_database";
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      uint32_t last_block = 0;
+      uint32_t snapshot_block = 0;
+
+      // round 0 writes the base, rounds 1 and 2 write deltas, round 3 compacts everything into a new base
+      for( uint32_t round = 0; round < 4; ++round )
+      {
+         database db;
+         db.set_snapshot_options( 2, 2 );
+         // alternate between serial and parallel decoding of the index files
+         db.set_load_threads( round % 2 == 0 ? 0 : 3 );
+         db.open(data_dir.path(), make_genesis, "TEST" );
+         if( round > 0 )
+         {
+            BOOST_CHECK_EQUAL( db.head_block_num(), last_block );
+            BOOST_CHECK_EQUAL( db.get_snapshot_block_num(), snapshot_block );
+         }
+         for( uint32_t i = 0; i < 50; ++i )
+            db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         last_block = db.head_block_num();
+         // close() rewinds to the last irreversible block before writing the snapshot
+         snapshot_block = db.get_dynamic_global_properties().last_irreversible_block_num;
+         db.close();
+
+         BOOST_CHECK( fc::exists( db_dir / "manifest" ) );
+         BOOST_CHECK_EQUAL( fc::exists( db_dir / "delta.1" ), round == 1 || round == 2 );
+         BOOST_CHECK_EQUAL( fc::exists( db_dir / "delta.2" ), round == 2 );
+      }
+
+      database db;
+      db.set_load_threads( 4 );
+      db.open(data_dir.path(), []{return genesis_state_type();}, "TEST");
+      BOOST_CHECK_EQUAL( db.head_block_num(), last_block );
+      BOOST_CHECK_EQUAL( db.get_snapshot_block_num(), snapshot_block );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( undo_block )
 {
    try {
@@ -1527,4 +1707,34 @@ BOOST_FIXTURE_TEST_CASE( miss_many_blocks, database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( block_assembly_reuses_pending_state, database_fixture )
+{ try {
+   ACTORS( (alice)(bob) );
+   fund( alice, asset(1000000) );
+   generate_block();
+
+   for( int i = 0; i < 10; ++i )
+      transfer( alice_id, bob_id, asset(100 + i) );
+   signed_block block = generate_block();
+   const auto& stats = db.get_last_block_generation_stats();
+   BOOST_CHECK( stats.reused_pending_state );
+   BOOST_CHECK( !stats.time_budget_exceeded );
+   BOOST_CHECK_EQUAL( 10u, stats.included_transactions );
+   BOOST_CHECK_EQUAL( 10u, block.transactions.size() );
+   BOOST_CHECK_EQUAL( 1045, get_balance( bob_id, asset_id_type() ) );
+
+   // out of time the block is sealed early, and what it left out goes into the next one
+   for( int i = 0; i < 5; ++i )
+      transfer( alice_id, bob_id, asset(10 + i) );
+   db.set_block_assembly_time_budget( fc::microseconds(1) );
+   block = generate_block();
+   const uint32_t first_block_txs = block.transactions.size();
+   BOOST_CHECK_EQUAL( 5u, stats.included_transactions + stats.postponed_transactions );
+
+   db.set_block_assembly_time_budget( fc::microseconds() );
+   block = generate_block();
+   BOOST_CHECK_EQUAL( 5u, first_block_txs + block.transactions.size() );
+   BOOST_CHECK_EQUAL( 1105, get_balance( bob_id, asset_id_type() ) );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
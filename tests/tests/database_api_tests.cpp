@@ -68,4 +68,74 @@ BOOST_FIXTURE_TEST_SUITE(database_api_tests, database_fixture)
       } FC_LOG_AND_RETHROW()
   }
 
+  BOOST_AUTO_TEST_CASE(market_ticker_rolling_window) {
+      try {
+          using graphene::market_history::market_ticker_object;
+          const fc::time_point_sec t0(1600000000);
+          market_ticker_object ticker;
+
+          ticker.add_trade(t0, 100, 300);
+          ticker.add_trade(t0 + 60, 200, 500);
+          auto summary = ticker.summarize(t0 + 120);
+          BOOST_CHECK_EQUAL(summary.volume_a.value, 300);
+          BOOST_CHECK_EQUAL(summary.volume_b.value, 800);
+          BOOST_CHECK_EQUAL(summary.day_open_b.value, 0);
+
+          // a day later the first slot is stale and provides the opening price
+          ticker.add_trade(t0 + 3600, 10, 20);
+          summary = ticker.summarize(t0 + 86400 + 1800);
+          BOOST_CHECK_EQUAL(summary.volume_a.value, 10);
+          BOOST_CHECK_EQUAL(summary.volume_b.value, 20);
+          BOOST_CHECK_EQUAL(summary.day_open_a.value, 200);
+          BOOST_CHECK_EQUAL(summary.day_open_b.value, 500);
+
+          // reusing the first slot keeps its closing price as the opening price
+          ticker.add_trade(t0 + 86400, 5, 7);
+          summary = ticker.summarize(t0 + 86400 + 60);
+          BOOST_CHECK_EQUAL(summary.volume_a.value, 15);
+          BOOST_CHECK_EQUAL(summary.volume_b.value, 27);
+          BOOST_CHECK_EQUAL(summary.day_open_a.value, 200);
+          BOOST_CHECK_EQUAL(summary.day_open_b.value, 500);
+          BOOST_CHECK_EQUAL(ticker.last_a.value, 5);
+          BOOST_CHECK_EQUAL(ticker.last_b.value, 7);
+
+          graphene::app::database_api db_api(db);
+          const vector<std::pair<string, string>> too_many_markets(101, std::make_pair("1.3.0", "1.3.1"));
+          GRAPHENE_REQUIRE_THROW(db_api.get_tickers(too_many_markets), fc::exception);
+      } FC_LOG_AND_RETHROW()
+  }
+
+  BOOST_AUTO_TEST_CASE(market_ticker_seeded_from_history) {
+      try {
+          using namespace graphene::market_history;
+          ACTORS((buyer)(seller));
+          const auto& tick = create_user_issued_asset("TICK");
+          const asset_id_type tick_id = tick.id;
+          issue_uia(seller, tick.amount(1000));
+          transfer(committee_account, buyer_id, asset(10000));
+
+          create_sell_order(seller_id, asset(100, tick_id), asset(300));
+          create_sell_order(buyer_id, asset(300), asset(100, tick_id));
+          generate_block();
+
+          // a node upgraded without a replay has the trade in its history but no ticker yet
+          const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+          auto ticker_itr = ticker_idx.find(boost::make_tuple(asset_id_type(), tick_id));
+          BOOST_REQUIRE(ticker_itr != ticker_idx.end());
+          db.remove(*ticker_itr);
+
+          create_sell_order(seller_id, asset(50, tick_id), asset(200));
+          create_sell_order(buyer_id, asset(200), asset(50, tick_id));
+          generate_block();
+
+          ticker_itr = ticker_idx.find(boost::make_tuple(asset_id_type(), tick_id));
+          BOOST_REQUIRE(ticker_itr != ticker_idx.end());
+          const auto summary = ticker_itr->summarize(db.head_block_time());
+          BOOST_CHECK_EQUAL(summary.volume_a.value, 500);
+          BOOST_CHECK_EQUAL(summary.volume_b.value, 150);
+          BOOST_CHECK_EQUAL(ticker_itr->last_a.value, 200);
+          BOOST_CHECK_EQUAL(ticker_itr->last_b.value, 50);
+      } FC_LOG_AND_RETHROW()
+  }
+
 BOOST_AUTO_TEST_SUITE_END()
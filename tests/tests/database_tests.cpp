@@ -81,6 +81,63 @@ BOOST_AUTO_TEST_CASE( merge_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( flat_undo_map_test )
+{ try {
+   graphene::db::flat_undo_map<object_id_type> map;
+   for( uint32_t i = 0; i < 1000; ++i )
+      map.insert( account_id_type(i), object_id_type( asset_id_type(i) ) );
+   BOOST_CHECK_EQUAL( map.size(), 1000u );
+
+   // erase every other entry, then reinsert some of them while tombstones are still present
+   for( uint32_t i = 0; i < 1000; i += 2 )
+      BOOST_CHECK( map.erase( account_id_type(i) ) );
+   BOOST_CHECK( !map.erase( account_id_type(0) ) );
+   BOOST_CHECK_EQUAL( map.size(), 500u );
+   for( uint32_t i = 0; i < 100; i += 2 )
+      map.insert( account_id_type(i), object_id_type( asset_id_type(i + 1) ) );
+   // grow past the current table so the tombstones are compacted away
+   for( uint32_t i = 1000; i < 3000; ++i )
+      map.insert( account_id_type(i), object_id_type( asset_id_type(i) ) );
+
+   BOOST_CHECK_EQUAL( map.size(), 2550u );
+   size_t visited = 0;
+   for( const auto& item : map )
+   {
+      ++visited;
+      const uint32_t i = item.first.instance();
+      BOOST_CHECK( i % 2 == 1 || i < 100 || i >= 1000 );
+      BOOST_CHECK_EQUAL( item.second.instance(), ( i % 2 == 0 && i < 100 ) ? i + 1 : i );
+   }
+   BOOST_CHECK_EQUAL( visited, map.size() );
+   BOOST_CHECK( map.find( account_id_type(200) ) == nullptr );
+   BOOST_REQUIRE( map.find( account_id_type(201) ) != nullptr );
+   BOOST_CHECK( *map.find( account_id_type(201) ) == object_id_type( asset_id_type(201) ) );
+   BOOST_CHECK( !map.contains( asset_id_type(201) ) );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( flat_undo_map_insert_existing_id )
+{ try {
+   graphene::db::flat_undo_map<object_id_type> map;
+   for( uint32_t i : { 7, 3, 9, 1 } )
+      map.insert( account_id_type(i), object_id_type( asset_id_type(i) ) );
+
+   // the second insert of an id keeps the first value, as std::map::emplace does
+   object_id_type& stored = map.insert( account_id_type(3), object_id_type( asset_id_type(100) ) );
+   BOOST_CHECK( stored == object_id_type( asset_id_type(3) ) );
+   BOOST_CHECK_EQUAL( map.size(), 4u );
+   size_t visited = 0;
+   for( const auto& item : map )
+      visited += ( item.first == object_id_type( account_id_type(3) ) );
+   BOOST_CHECK_EQUAL( visited, 1u );
+
+   map.erase( account_id_type(9) );
+   const auto ids = map.sorted_ids();
+   BOOST_REQUIRE_EQUAL( ids.size(), 3u );
+   BOOST_CHECK( ids[0] == object_id_type( account_id_type(1) ) );
+   BOOST_CHECK( ids[1] == object_id_type( account_id_type(3) ) );
+   BOOST_CHECK( ids[2] == object_id_type( account_id_type(7) ) );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( flat_index_test )
 {
    ACTORS((sam));
@@ -195,4 +252,40 @@ BOOST_AUTO_TEST_CASE( direct_index_test )
    // but the secondary has not updated its representation
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( asset_holders_count_index_test )
+{ try {
+   ACTORS( (alice)(bob) );
+
+   const auto& count_idx = db.get_index_type< primary_index< account_balance_index > >()
+                             .get_secondary_index< asset_holders_count_index >();
+   auto scan_count = [&]( asset_id_type asset ) {
+      uint64_t count = 0;
+      for( const account_balance_object& bal : db.get_index_type< account_balance_index >().indices() )
+         if( bal.asset_type == asset && bal.balance != 0 )
+            ++count;
+      return count;
+   };
+   const asset_id_type core;
+   const uint64_t initial = scan_count( core );
+   BOOST_CHECK_EQUAL( initial, count_idx.get_holders_count( core ) );
+
+   {
+      auto session = db._undo_db.start_undo_session();
+      db.adjust_balance( alice_id, asset( 1000 ) );
+      db.adjust_balance( bob_id, asset( 500 ) );
+      BOOST_CHECK_EQUAL( initial + 2, count_idx.get_holders_count( core ) );
+
+      // emptying a balance drops the holder, topping it up again does not count it twice
+      db.adjust_balance( bob_id, asset( -500 ) );
+      BOOST_CHECK_EQUAL( initial + 1, count_idx.get_holders_count( core ) );
+      db.adjust_balance( alice_id, asset( 1 ) );
+      BOOST_CHECK_EQUAL( initial + 1, count_idx.get_holders_count( core ) );
+      BOOST_CHECK_EQUAL( scan_count( core ), count_idx.get_holders_count( core ) );
+   }
+
+   // undoing the session restores the count
+   BOOST_CHECK_EQUAL( initial, count_idx.get_holders_count( core ) );
+   BOOST_CHECK_EQUAL( 0u, count_idx.get_holders_count( asset_id_type( 12345 ) ) );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1511,6 +1511,59 @@ BOOST_AUTO_TEST_CASE( proxy_voting )
    }
 }
 
+BOOST_AUTO_TEST_CASE( parallel_vote_tally )
+{
+   try {
+      generate_blocks( HARDFORK_GPOS_TIME );
+      generate_block();
+
+      const auto& core = asset_id_type()(db);
+      update_gpos_global(5184000, 864000, HARDFORK_GPOS_TIME);
+      // tally on threads and compare every maintenance against the serial tally
+      db.set_vote_tally_threads(3, true);
+
+      const auto& witness1 = witness_id_type(1)(db);
+      const auto& witness2 = witness_id_type(2)(db);
+
+      vector<account_id_type> voters;
+      vector<fc::ecc::private_key> keys;
+      for( int i = 0; i < 24; ++i )
+      {
+         std::string name = "voter" + std::to_string(i);
+         auto key = generate_private_key(name);
+         const account_object& voter = create_account(name, key.get_public_key());
+         transfer( committee_account, voter.id, core.amount( 1000 ) );
+         create_vesting( voter.id, core.amount( 100 + i ), vesting_balance_type::gpos );
+         voters.push_back( voter.id );
+         keys.push_back( key );
+      }
+      generate_block();
+
+      // voters stop voting in different subperiods, so their stakes decay by different factors
+      for( size_t subperiod = 0; subperiod < 6; ++subperiod )
+      {
+         for( size_t i = subperiod * 4; i < voters.size(); ++i )
+            vote_for( voters[i], ( i % 2 ? witness1 : witness2 ).vote_id, keys[i] );
+         advance_x_maint(10);
+
+         BOOST_CHECK_EQUAL( db.get_vote_tally_mismatches(), 0u );
+         if( subperiod == 0 )
+         {
+            BOOST_CHECK_GT( witness1.total_votes, 0u );
+            BOOST_CHECK_GT( witness2.total_votes, 0u );
+         }
+      }
+
+      // into the next period, where only the latest votes keep their weight
+      advance_x_maint(10);
+      BOOST_CHECK_EQUAL( db.get_vote_tally_mismatches(), 0u );
+   }
+   catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( no_proposal )
 {
    try {
@@ -544,4 +544,110 @@ BOOST_AUTO_TEST_CASE( lottery_winner_ticket_id_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( ticket_ledger_stress_test )
+{
+   try {
+      const uint32_t buyers_count = 200;
+      const uint32_t purchases_per_buyer = 50;
+      const uint32_t buyers_per_block = 20;
+      // purchases alternate between 5 and 15 tickets, 500 tickets per buyer
+      const uint64_t tickets_count = buyers_count * purchases_per_buyer / 2 * 20;
+
+      generate_block();
+      asset_id_type lottery_id = db.get_index<asset_object>().get_next_id();
+      lottery_asset_create_operation creator;
+      creator.issuer = account_id_type();
+      creator.fee = asset();
+      creator.symbol = "STRESSLOT";
+      creator.common_options.max_supply = tickets_count;
+      creator.precision = 0;
+      creator.common_options.market_fee_percent = GRAPHENE_MAX_MARKET_FEE_PERCENT/100; /*1%*/
+      creator.common_options.issuer_permissions = charge_market_fee|white_list|override_authority|transfer_restricted|disable_confidential;
+      creator.common_options.flags = charge_market_fee|white_list|override_authority|disable_confidential;
+      creator.common_options.core_exchange_rate = price({asset(1),asset(1,asset_id_type(1))});
+      creator.common_options.whitelist_authorities = creator.common_options.blacklist_authorities = {account_id_type()};
+
+      lottery_asset_options lottery_options;
+      lottery_options.benefactors.push_back( benefactor( account_id_type(), 25 * GRAPHENE_1_PERCENT ) );
+      lottery_options.end_date = db.head_block_time() + fc::days(7);
+      lottery_options.ticket_price = asset(1);
+      lottery_options.winning_tickets = { 25 * GRAPHENE_1_PERCENT, 25 * GRAPHENE_1_PERCENT, 25 * GRAPHENE_1_PERCENT };
+      lottery_options.is_active = true;
+      lottery_options.ending_on_soldout = true;
+      creator.extensions = lottery_options;
+
+      trx.operations.push_back(std::move(creator));
+      PUSH_TX( db, trx, ~0 );
+      trx.operations.clear();
+      generate_block();
+
+      vector<account_id_type> buyers;
+      for( uint32_t i = 0; i < buyers_count; ++i )
+      {
+         const account_object& buyer = create_account( "buyer" + fc::to_string(i) );
+         transfer( account_id_type(), buyer.id, asset( tickets_count / buyers_count ) );
+         buyers.push_back( buyer.id );
+      }
+      generate_block();
+
+      fc::time_point start = fc::time_point::now();
+      for( uint32_t i = 0; i < buyers_count; ++i )
+      {
+         for( uint32_t j = 0; j < purchases_per_buyer; ++j )
+         {
+            ticket_purchase_operation tpo;
+            tpo.fee = asset();
+            tpo.buyer = buyers[i];
+            tpo.lottery = lottery_id;
+            tpo.tickets_to_buy = j % 2 ? 15 : 5;
+            tpo.amount = asset( tpo.tickets_to_buy );
+            trx.operations.push_back(std::move(tpo));
+         }
+         graphene::chain::test::set_expiration(db, trx);
+         PUSH_TX( db, trx, ~0 );
+         trx.operations.clear();
+         if( (i + 1) % buyers_per_block == 0 )
+            generate_block();
+      }
+      BOOST_TEST_MESSAGE( "Bought " + fc::to_string(tickets_count) + " tickets and ended the lottery in " +
+                          fc::to_string( (fc::time_point::now() - start).count() / 1000 ) + " ms" );
+
+      // the last purchase sold the lottery out
+      const asset_object& lottery = lottery_id(db);
+      BOOST_CHECK( !lottery.lottery_options->is_active );
+      BOOST_REQUIRE( lottery.dynamic_data(db).sweeps_tickets_sold.valid() );
+      BOOST_CHECK_EQUAL( lottery.dynamic_data(db).sweeps_tickets_sold->value, int64_t(tickets_count) );
+      BOOST_CHECK_EQUAL( db.get_balance( lottery_id ).amount.value, 0 );
+      const auto& purchases = db.get_index_type<lottery_ticket_purchase_index>().indices().get<by_lottery_buyer>();
+      BOOST_CHECK( purchases.lower_bound( boost::make_tuple( lottery_id ) ) == purchases.end() );
+
+      uint32_t rewards = 0;
+      for( account_id_type buyer : buyers )
+      {
+         for( const operation_history_object& h : get_operation_history( buyer ) )
+         {
+            if( h.op.which() != operation::tag<lottery_reward_operation>::value )
+               continue;
+            auto reward_op = h.op.get<lottery_reward_operation>();
+            if( reward_op.is_benefactor_reward || reward_op.lottery != lottery_id )
+               continue;
+            ++rewards;
+            BOOST_CHECK( reward_op.winner == buyer );
+            // the ticket id is the purchase in the history, unless the ticket was bought in the final block
+            if( reward_op.winner_ticket_id.which() == ticket_num::tag<uint64_t>::value )
+            {
+               const auto& purchase = operation_history_id_type( reward_op.winner_ticket_id.get<uint64_t>() )(db);
+               BOOST_REQUIRE( purchase.op.which() == operation::tag<ticket_purchase_operation>::value );
+               BOOST_CHECK( purchase.op.get<ticket_purchase_operation>().buyer == buyer );
+               BOOST_CHECK( purchase.op.get<ticket_purchase_operation>().lottery == lottery_id );
+            }
+         }
+      }
+      BOOST_CHECK_EQUAL( rewards, lottery.lottery_options->winning_tickets.size() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
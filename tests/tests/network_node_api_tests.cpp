@@ -25,6 +25,11 @@
 #include <boost/test/unit_test.hpp>
 
 #include <graphene/app/api.hpp>
+#include <graphene/net/config.hpp>
+#include <graphene/net/peer_database.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/io/json.hpp>
 
 #include "../common/database_fixture.hpp"
 
@@ -198,4 +203,99 @@ BOOST_AUTO_TEST_CASE(unsubscribe_from_pending_transactions) {
     } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( peer_database_persistence_and_candidates )
+{ try {
+   using namespace graphene::net;
+   fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+   const fc::path json_file = data_dir.path() / "peers.json";
+   const fc::path binary_file = data_dir.path() / "peers.dat";
+   const fc::time_point_sec now = fc::time_point::now();
+   const uint32_t retry_timeout = 30;
+
+   auto make_record = [&]( uint16_t port, potential_peer_last_connection_disposition disposition,
+                           fc::time_point_sec last_attempt, uint32_t failed_attempts ) {
+      potential_peer_record record( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), port ) );
+      record.last_seen_time = now;
+      record.last_connection_disposition = disposition;
+      record.last_connection_attempt_time = last_attempt;
+      record.number_of_failed_connection_attempts = failed_attempts;
+      return record;
+   };
+
+   // a legacy json database is migrated once
+   std::vector<potential_peer_record> legacy_records;
+   legacy_records.push_back( make_record( 1001, last_connection_succeeded, now, 0 ) );
+   legacy_records.push_back( make_record( 1002, last_connection_failed, now - 100, 0 ) );
+   legacy_records.push_back( make_record( 1003, last_connection_failed, now - 100, 5 ) );
+   legacy_records.push_back( make_record( 1004, last_connection_rejected, now - 10, 0 ) );
+   fc::json::save_to_file( legacy_records, json_file, GRAPHENE_NET_MAX_NESTED_OBJECTS );
+   {
+      peer_database peers;
+      peers.open( binary_file, json_file );
+      BOOST_CHECK_EQUAL( peers.size(), 4u );
+      BOOST_CHECK( fc::exists( binary_file ) );
+      BOOST_CHECK( !fc::exists( json_file ) );
+
+      // 1002 failed long enough ago, 1003 still has to wait for its (5 + 1) * 30 seconds, 1004 failed too recently
+      std::vector<potential_peer_record> candidates = peers.get_connection_candidates( now, retry_timeout );
+      BOOST_REQUIRE_EQUAL( candidates.size(), 2u );
+      BOOST_CHECK_EQUAL( candidates[0].endpoint.port(), 1001 );
+      BOOST_CHECK_EQUAL( candidates[1].endpoint.port(), 1002 );
+
+      // changes are appended to the log as they happen, and reach the file before it is closed
+      potential_peer_record updated = *peers.lookup_entry_for_endpoint( legacy_records[2].endpoint );
+      updated.last_connection_disposition = last_connection_succeeded;
+      const auto size_before_update = fc::file_size( binary_file );
+      peers.update_entry( updated );
+      BOOST_CHECK_GT( fc::file_size( binary_file ), size_before_update );
+      peers.erase( legacy_records[3].endpoint );
+      for( uint32_t i = 0; i < 3 * MAXIMUM_PEERDB_SIZE; ++i )
+         peers.update_entry( make_record( 2000 + i % 10, last_connection_succeeded, now, 0 ) );
+      BOOST_CHECK_EQUAL( peers.size(), 13u );
+   }
+
+   // reopening replays the log, without the json file coming back into play
+   peer_database peers;
+   peers.open( binary_file, json_file );
+   BOOST_CHECK_EQUAL( peers.size(), 13u );
+   BOOST_CHECK( !peers.lookup_entry_for_endpoint( legacy_records[3].endpoint ) );
+   BOOST_CHECK( peers.lookup_entry_for_endpoint( legacy_records[2].endpoint )->last_connection_disposition == last_connection_succeeded );
+   BOOST_CHECK_EQUAL( peers.get_connection_candidates( now, retry_timeout ).size(), 13u );
+   peers.close();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( peer_database_survives_write_errors )
+{ try {
+   using namespace graphene::net;
+   fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+   const fc::path binary_file = data_dir.path() / "peers.dat";
+   const fc::path blocker = data_dir.path() / "peers.dat.tmp";
+   auto make_record = []( uint16_t port ) {
+      potential_peer_record record( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), port ) );
+      record.last_connection_disposition = last_connection_succeeded;
+      return record;
+   };
+   {
+      peer_database peers;
+      peers.open( binary_file );
+      // a directory where compaction writes the new log makes it fail, which must not reach the caller
+      fc::create_directories( blocker / "x" );
+      for( uint32_t i = 0; i < 3 * MAXIMUM_PEERDB_SIZE; ++i )
+         BOOST_CHECK_NO_THROW( peers.update_entry( make_record( 2000 + i % 10 ) ) );
+      BOOST_CHECK_NO_THROW( peers.erase( make_record( 2000 ).endpoint ) );
+      BOOST_CHECK_NO_THROW( peers.clear() );
+      BOOST_CHECK_NO_THROW( peers.update_entry( make_record( 3000 ) ) );
+      BOOST_CHECK_EQUAL( peers.size(), 1u );
+
+      // once the disk is usable again close() writes out what the log missed
+      fc::remove_all( blocker );
+      peers.close();
+   }
+   peer_database peers;
+   peers.open( binary_file );
+   BOOST_CHECK_EQUAL( peers.size(), 1u );
+   BOOST_CHECK( peers.lookup_entry_for_endpoint( make_record( 3000 ).endpoint ) );
+   peers.close();
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
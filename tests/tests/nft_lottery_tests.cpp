@@ -542,6 +542,100 @@ BOOST_AUTO_TEST_CASE(ending_by_participants_count_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(ending_check_with_many_active_lotteries_test)
+{
+    try
+    {
+        generate_blocks(HARDFORK_NFT_TIME);
+        generate_block();
+
+        auto create_lottery = [&](const std::string &symbol, share_type max_supply, fc::time_point_sec end_date) {
+            nft_metadata_id_type lottery_id = db.get_index<nft_metadata_object>().get_next_id();
+            nft_lottery_options lottery_options;
+            lottery_options.benefactors.push_back(nft_lottery_benefactor(account_id_type(), 25 * GRAPHENE_1_PERCENT));
+            lottery_options.end_date = end_date;
+            lottery_options.ticket_price = asset(100);
+            lottery_options.winning_tickets = {5 * GRAPHENE_1_PERCENT, 5 * GRAPHENE_1_PERCENT, 5 * GRAPHENE_1_PERCENT, 10 * GRAPHENE_1_PERCENT, 10 * GRAPHENE_1_PERCENT, 10 * GRAPHENE_1_PERCENT, 10 * GRAPHENE_1_PERCENT, 10 * GRAPHENE_1_PERCENT, 10 * GRAPHENE_1_PERCENT};
+            lottery_options.is_active = true;
+            lottery_options.ending_on_soldout = true;
+
+            nft_metadata_create_operation op;
+            op.owner = account_id_type();
+            op.symbol = symbol;
+            op.base_uri = "http://nft.example.com";
+            op.is_transferable = true;
+            op.name = symbol;
+            op.max_supply = max_supply;
+            op.lottery_options = lottery_options;
+            trx.operations.push_back(op);
+            set_expiration(db, trx);
+            PUSH_TX(db, trx, ~0);
+            trx.operations.clear();
+            return lottery_id;
+        };
+        auto buy_tickets = [&](nft_metadata_id_type lottery_id, account_id_type buyer, uint64_t tickets) {
+            nft_lottery_token_purchase_operation tpo;
+            tpo.fee = asset();
+            tpo.buyer = buyer;
+            tpo.lottery_id = lottery_id;
+            tpo.tickets_to_buy = tickets;
+            tpo.amount = asset(tickets * 100);
+            trx.operations.push_back(tpo);
+            set_expiration(db, trx);
+            PUSH_TX(db, trx, ~0);
+            trx.operations.clear();
+        };
+
+        // thousands of active lotteries, none of them close to ending
+        const uint32_t active_lotteries = 2000;
+        const fc::time_point_sec far_end_date = db.head_block_time() + fc::days(30);
+        for (uint32_t i = 0; i < active_lotteries; ++i)
+        {
+            create_lottery("NFTBENCH" + std::to_string(i), 1000, far_end_date - i);
+            if (i % 200 == 199)
+                generate_block();
+        }
+        account_id_type buyer(3);
+        transfer(account_id_type(), buyer, asset(10000000));
+        nft_metadata_id_type active_lottery = db.get_index_type<nft_metadata_index>().indices().get<by_symbol>().find("NFTBENCH0")->get_id();
+        buy_tickets(active_lottery, buyer, 10);
+        generate_block();
+
+        // checking for ending lotteries now only visits the ones that are due
+        const uint32_t checks = 1000;
+        fc::time_point start = fc::time_point::now();
+        for (uint32_t i = 0; i < checks; ++i)
+            db.check_ending_nft_lotteries();
+        fc::microseconds elapsed = fc::time_point::now() - start;
+        BOOST_TEST_MESSAGE("checking " + std::to_string(active_lotteries) + " active lotteries took " +
+                           std::to_string(elapsed.count() / checks) + " us per block");
+        BOOST_CHECK(active_lottery(db).lottery_data->lottery_options.is_active);
+
+        // a lottery that sells out and one that reaches its end date in the same block end in consecutive blocks,
+        // the one with the later end date first
+        nft_metadata_id_type sold_out_lottery = create_lottery("NFTSOLDOUT", 5, far_end_date + fc::days(1));
+        nft_metadata_id_type expiring_lottery = create_lottery("NFTEXPIRING", 1000, db.head_block_time() + fc::seconds(30));
+        buy_tickets(expiring_lottery, buyer, 1);
+        generate_block();
+        while (db.get_slot_time(1) < expiring_lottery(db).lottery_data->lottery_options.end_date)
+            generate_block();
+        BOOST_CHECK(expiring_lottery(db).lottery_data->lottery_options.is_active);
+        buy_tickets(sold_out_lottery, buyer, 5);
+        generate_block();
+        BOOST_CHECK(!sold_out_lottery(db).lottery_data->lottery_options.is_active);
+        BOOST_CHECK(expiring_lottery(db).lottery_data->lottery_options.is_active);
+        generate_block();
+        BOOST_CHECK(!expiring_lottery(db).lottery_data->lottery_options.is_active);
+        BOOST_CHECK(active_lottery(db).lottery_data->lottery_options.is_active);
+        BOOST_CHECK(active_lottery(db).get_token_current_supply(db) == share_type(10));
+    }
+    catch (fc::exception &e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
 BOOST_AUTO_TEST_CASE(try_to_end_empty_lottery_test)
 {
     try
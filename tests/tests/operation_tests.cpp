@@ -230,6 +230,119 @@ BOOST_AUTO_TEST_CASE( margin_call_limit_test )
    }
 }
 
+/**
+ *  Places limit orders on a market where every call order is protected by the feed, which apply_order()
+ *  no longer checks for margin calls.  Then moves the feed so the least collateralized call order gets
+ *  margin called by a new order.
+ */
+BOOST_AUTO_TEST_CASE( limit_orders_next_to_protected_call_orders )
+{ try {
+      ACTORS((buyer)(seller)(feedproducer));
+
+      const auto& bitusd = create_bitasset("USDBIT", feedproducer_id);
+      const auto& core   = asset_id_type()(db);
+      const asset_id_type bitusd_id = bitusd.id;
+
+      transfer(committee_account, buyer_id, asset(100000000));
+      transfer(committee_account, seller_id, asset(100000000));
+      update_feed_producers( bitusd, {feedproducer.id} );
+
+      price_feed current_feed;
+      current_feed.settlement_price = bitusd.amount( 100 ) / core.amount(100);
+      publish_feed( bitusd, feedproducer, current_feed );
+
+      // collateral from 2:1 up, borrower0 being the least collateralized
+      const uint32_t borrowers = 10;
+      for( uint32_t i = 0; i < borrowers; ++i )
+      {
+         const account_object& borrower = create_account( "borrower" + fc::to_string(i) );
+         transfer( committee_account, borrower.id, asset(1000000) );
+         borrow( borrower, bitusd.amount(1000), asset(2000 + 10 * i) );
+      }
+      borrow( seller, bitusd.amount(100000), asset(1000000) );
+
+      const call_order_object* least_collateralized = db.find_least_collateralized_call( asset_id_type(), bitusd_id );
+      BOOST_REQUIRE( least_collateralized != nullptr );
+      BOOST_CHECK( least_collateralized->borrower == get_account("borrower0").id );
+      BOOST_CHECK( !db.call_orders_may_trigger( bitusd ) );
+
+      // bids and asks that do not cross, the asks too cheap to be used for margin calls even after the feed moves
+      for( uint32_t i = 0; i < 20; ++i )
+      {
+         BOOST_REQUIRE( create_sell_order( buyer, core.amount(100 + i), bitusd.amount(100) ) != nullptr );
+         BOOST_REQUIRE( create_sell_order( seller, bitusd.amount(10), core.amount(30 + i) ) != nullptr );
+      }
+      BOOST_CHECK( !db.check_call_orders( bitusd ) );
+      BOOST_CHECK( !db.call_orders_may_trigger( bitusd ) );
+
+      // every borrower is now below the maintenance collateral ratio, but there is no one to buy from yet
+      current_feed.settlement_price = bitusd.amount( 100 ) / core.amount(150);
+      publish_feed( bitusd, feedproducer, current_feed );
+      BOOST_CHECK( db.call_orders_may_trigger( bitusd ) );
+      BOOST_CHECK( db.find_least_collateralized_call( asset_id_type(), bitusd_id )->borrower == get_account("borrower0").id );
+
+      // which a new order crossing the least collateralized call order provides
+      BOOST_CHECK( create_sell_order( seller, bitusd.amount(1000), core.amount(1400) ) == nullptr );
+      least_collateralized = db.find_least_collateralized_call( asset_id_type(), bitusd_id );
+      BOOST_REQUIRE( least_collateralized != nullptr );
+      BOOST_CHECK( least_collateralized->borrower == get_account("borrower1").id );
+   } catch( const fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+/**
+ *  Closes the least collateralized call order in a transaction that is undone, then moves the feed:
+ *  the restored call order must be the one apply_order() sees and margin calls.
+ */
+BOOST_AUTO_TEST_CASE( margin_call_after_undoing_a_closed_call_order )
+{ try {
+      ACTORS((seller)(borrower)(borrower2)(feedproducer));
+
+      const auto& bitusd = create_bitasset("USDBIT", feedproducer_id);
+      const auto& core   = asset_id_type()(db);
+      const asset_id_type bitusd_id = bitusd.id;
+
+      transfer(committee_account, seller_id, asset(10000000));
+      transfer(committee_account, borrower_id, asset(10000000));
+      transfer(committee_account, borrower2_id, asset(10000000));
+      update_feed_producers( bitusd, {feedproducer.id} );
+
+      price_feed current_feed;
+      current_feed.settlement_price = bitusd.amount( 100 ) / core.amount(100);
+      publish_feed( bitusd, feedproducer, current_feed );
+
+      borrow( borrower, bitusd.amount(1000), asset(2000) );
+      borrow( borrower2, bitusd.amount(1000), asset(4000) );
+      borrow( seller, bitusd.amount(10000), asset(1000000) );
+      generate_block();
+
+      cover( borrower, bitusd.amount(1000), asset(2000) );
+      BOOST_REQUIRE( db.find_least_collateralized_call( asset_id_type(), bitusd_id ) != nullptr );
+      BOOST_CHECK( db.find_least_collateralized_call( asset_id_type(), bitusd_id )->borrower == borrower2_id );
+      db.clear_pending();
+
+      const call_order_object* least_collateralized = db.find_least_collateralized_call( asset_id_type(), bitusd_id );
+      BOOST_REQUIRE( least_collateralized != nullptr );
+      BOOST_CHECK( least_collateralized->borrower == borrower_id );
+
+      // the restored call order is now below the maintenance collateral ratio, borrower2's is not
+      current_feed.settlement_price = bitusd.amount( 100 ) / core.amount(150);
+      publish_feed( bitusd, feedproducer, current_feed );
+      BOOST_CHECK( db.call_orders_may_trigger( bitusd ) );
+
+      BOOST_CHECK( create_sell_order( seller, bitusd.amount(1000), core.amount(1400) ) == nullptr );
+      least_collateralized = db.find_least_collateralized_call( asset_id_type(), bitusd_id );
+      BOOST_REQUIRE( least_collateralized != nullptr );
+      BOOST_CHECK( least_collateralized->borrower == borrower2_id );
+      generate_block();
+   } catch( const fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 /**
  *  This test sets up the minimum condition for a black swan to occur but does
  *  not test the full range of cases that may be possible during a black swan.
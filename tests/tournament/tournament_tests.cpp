@@ -2257,6 +2257,91 @@ BOOST_FIXTURE_TEST_CASE( massive, database_fixture )
 }
 #endif
 
+// Checks that blocks in which no match changes visit no tournament, and measures block production with
+// many tournaments in progress against checking every in-progress tournament on each block
+BOOST_FIXTURE_TEST_CASE( tournament_load_benchmark, database_fixture )
+{
+    try
+    {
+        const unsigned number_of_tournaments = 50;
+        const unsigned number_of_players = 16;
+        const unsigned number_of_blocks = 5;
+        BOOST_TEST_MESSAGE("Hello tournament load benchmark");
+
+        ACTORS((nathan));
+        fc::ecc::private_key nathan_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
+        transfer(committee_account, nathan_id, asset(1000000000));
+        upgrade_to_lifetime_member(nathan);
+
+        std::vector<std::pair<account_id_type, fc::ecc::private_key>> players;
+        for (unsigned i = 0; i < number_of_players; ++i)
+        {
+            std::string name = "account" + std::to_string(i);
+            auto priv_key = generate_private_key(name);
+            const auto& account = create_account(name, priv_key.get_public_key());
+            transfer(committee_account, account.id, asset(100000000));
+            players.emplace_back(account.id, priv_key);
+        }
+
+        tournaments_helper tournament_helper(*this);
+        asset buy_in = asset(10000);
+        for (unsigned i = 0; i < number_of_tournaments; ++i)
+        {
+            tournament_id_type tournament_id = tournament_helper.create_tournament(nathan_id, nathan_priv_key, buy_in,
+                                                                                   number_of_players, 30, 30, 3);
+            for (const auto& player : players)
+                tournament_helper.join_tournament(tournament_id, player.first, player.first, player.second, buy_in);
+        }
+
+        // let the start delay pass; nobody moves afterwards, so the games sit waiting for their commit timeouts
+        generate_blocks(db.head_block_time() + fc::seconds(3));
+        generate_block();
+        for (const auto& tournament_id : tournament_helper.list_tournaments())
+            BOOST_REQUIRE(tournament_id(db).get_state() == tournament_state::in_progress);
+        auto& due_index = const_cast<tournament_due_index&>(
+              db.get_index_type<primary_index<match_index>>().get_secondary_index<tournament_due_index>());
+
+        fc::time_point start = fc::time_point::now();
+        for (unsigned i = 0; i < number_of_blocks; ++i)
+        {
+            generate_block();
+            BOOST_CHECK_EQUAL(due_index.checked_tournaments, 0u);
+        }
+        int64_t block_us = (fc::time_point::now() - start).count() / number_of_blocks;
+
+        // after a restart every tournament in progress is checked once
+        due_index.full_scan_pending = true;
+        generate_block();
+        BOOST_CHECK_EQUAL(due_index.checked_tournaments, number_of_tournaments);
+        generate_block();
+        BOOST_CHECK_EQUAL(due_index.checked_tournaments, 0u);
+
+        // what each of those blocks used to spend on top, rolled back afterwards
+        start = fc::time_point::now();
+        {
+            auto session = db._undo_db.start_undo_session();
+            auto& start_time_index = db.get_index_type<tournament_index>().indices().get<by_start_time>();
+            for (auto itr = start_time_index.lower_bound(boost::make_tuple(tournament_state::in_progress));
+                 itr != start_time_index.end() && itr->get_state() == tournament_state::in_progress; ++itr)
+                itr->check_for_new_matches_to_start(db);
+        }
+        int64_t full_scan_us = (fc::time_point::now() - start).count();
+
+        for (const auto& tournament_id : tournament_helper.list_tournaments())
+            BOOST_CHECK(tournament_id(db).get_state() == tournament_state::in_progress);
+
+        BOOST_TEST_MESSAGE("Average block with " + std::to_string(number_of_tournaments) + " idle tournaments: " +
+                           std::to_string(block_us) + " us, full scan of in-progress tournaments: " +
+                           std::to_string(full_scan_us) + " us");
+        wlog("Tournament load: ${b} us per block, ${s} us per full scan", ("b", block_us)("s", full_scan_us));
+    }
+    catch (fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 //#define BOOST_TEST_MODULE "C++ Unit Tests for Graphene Blockchain Database"